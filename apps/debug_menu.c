@@ -61,6 +61,7 @@
 #include "rtc.h"
 #include "storage.h"
 #include "fs_defines.h"
+#include "disk_cache.h"
 #include "eeprom_24cxx.h"
 #if (CONFIG_STORAGE & STORAGE_MMC) || (CONFIG_STORAGE & STORAGE_SD)
 #include "sdmmc.h"
@@ -499,6 +500,42 @@ static bool dbg_buffering_thread(void)
 #undef STR_DATAREM
 }
 
+static int buflib_stats_callback(int btn, struct gui_synclist *lists)
+{
+    (void)lists;
+    struct buflib_stats stats;
+    core_get_stats(&stats);
+
+    simplelist_set_line_count(0);
+
+    simplelist_addline("Free: %zu B in %u holes", stats.free_bytes,
+                       stats.free_blocks);
+    simplelist_addline("Largest free: %zu B", stats.largest_free);
+    unsigned int frag = stats.free_bytes ?
+        1000ull*(stats.free_bytes - stats.largest_free) / stats.free_bytes : 0;
+    simplelist_addline("Fragmentation: %u.%u%%", frag / 10, frag % 10);
+    simplelist_addline("Compactions: %lu", stats.compactions);
+    simplelist_addline("Futile compactions skipped: %lu",
+                       stats.compactions_skipped);
+    simplelist_addline("Bytes moved: %lu", stats.bytes_moved);
+    simplelist_addline("Size class hits: %lu", stats.size_class_hits);
+
+    if (btn == ACTION_NONE)
+        btn = ACTION_REDRAW;
+
+    return btn;
+}
+
+static bool dbg_buflib_stats(void)
+{
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Buflib Stats", 7, NULL);
+    info.action_callback = buflib_stats_callback;
+    info.scroll_all = true;
+    info.timeout = HZ;
+    return simplelist_show_list(&info);
+}
+
 #ifdef BUFLIB_DEBUG_PRINT
 static const char* bf_getname(int selected_item, void *data,
                                    char *buffer, size_t buffer_len)
@@ -1788,6 +1825,52 @@ static bool dbg_disk_info(void)
     info.scroll_all = true;
     return simplelist_show_list(&info);
 }
+
+static unsigned int dbg_permille(unsigned long num, unsigned long den)
+{
+    return den ? 1000ull*num / den : 0;
+}
+
+static int disk_cache_callback(int btn, struct gui_synclist *lists)
+{
+    (void)lists;
+    struct dc_stats stats;
+    dc_get_stats(&stats);
+
+    simplelist_set_line_count(0);
+
+    simplelist_addline("Entries: %u x %u B", DC_NUM_ENTRIES,
+                       DC_CACHE_BUFSIZE);
+    unsigned int hitrate = dbg_permille(stats.hits, stats.hits + stats.misses);
+    simplelist_addline("Hits: %lu (%u.%u%%)", stats.hits,
+                       hitrate / 10, hitrate % 10);
+    simplelist_addline("Misses: %lu", stats.misses);
+#ifdef DC_CLUSTERED_IO
+    simplelist_addline("Readahead: %u sectors max", DC_MAX_RUN);
+    unsigned int useful = dbg_permille(stats.ra_used, stats.ra_sectors);
+    simplelist_addline("Read ahead: %lu", stats.ra_sectors);
+    simplelist_addline("RA used: %lu (%u.%u%%)", stats.ra_used,
+                       useful / 10, useful % 10);
+    simplelist_addline("RA wasted: %lu", stats.ra_wasted);
+#endif
+    simplelist_addline("Written: %lu in %lu requests", stats.wb_sectors,
+                       stats.wb_requests);
+
+    if (btn == ACTION_NONE)
+        btn = ACTION_REDRAW;
+
+    return btn;
+}
+
+static bool dbg_disk_cache(void)
+{
+    struct simplelist_info info;
+    simplelist_info_init(&info, "Disk Cache Info", 8, NULL);
+    info.action_callback = disk_cache_callback;
+    info.scroll_all = true;
+    info.timeout = HZ;
+    return simplelist_show_list(&info);
+}
 #endif /* PLATFORM_NATIVE */
 
 #ifdef HAVE_DIRCACHE
@@ -2440,9 +2523,25 @@ static const char* dbg_talk_get_name(int selected_item, void *data,
                     talk_data->cached_clips);
             break;
         case 7:
-            snprintf(buffer, buffer_len, "Cache hits / misses: %d / %d",
-                    talk_data->cache_hits, talk_data->cache_misses);
+        {
+            int lookups = talk_data->cache_hits + talk_data->cache_misses;
+            snprintf(buffer, buffer_len, "Cache hits / misses: %d / %d (%d%%)",
+                    talk_data->cache_hits, talk_data->cache_misses,
+                    lookups ? talk_data->cache_hits * 100 / lookups : 0);
             break;
+        }
+        case 8:
+            snprintf(buffer, buffer_len, "Prefetched clips / spoken: %d / %d",
+                    talk_data->prefetch_loads, talk_data->prefetch_hits);
+            break;
+        case 9:
+        {
+            int loads = talk_data->clip_loads;
+            snprintf(buffer, buffer_len, "Clip load time avg / max: %ld / %ld ms",
+                    loads ? talk_data->load_ticks * (1000/HZ) / loads : 0,
+                    talk_data->load_ticks_max * (1000/HZ));
+            break;
+        }
         default:
             buffer = "TODO";
             break;
@@ -2456,7 +2555,7 @@ static bool dbg_talk(void)
     struct simplelist_info list;
     struct talk_debug_data data;
     if (talk_get_debug_data(&data))
-        simplelist_info_init(&list, "Voice Information:", 8, &data);
+        simplelist_info_init(&list, "Voice Information:", 10, &data);
     else
         simplelist_info_init(&list, "Voice Information:", 2, &data);
     list.scroll_all = true;
@@ -2628,6 +2727,7 @@ static const struct {
 #endif
 #if (CONFIG_PLATFORM & PLATFORM_NATIVE)
         { "View disk info", dbg_disk_info },
+        { "View disk cache info", dbg_disk_cache },
 #if (CONFIG_STORAGE & STORAGE_ATA)
         { "Dump ATA identify info", dbg_identify_info},
 #ifdef HAVE_ATA_SMART
@@ -2646,6 +2746,7 @@ static const struct {
 #ifdef PM_DEBUG
         { "pm histogram", peak_meter_histogram},
 #endif /* PM_DEBUG */
+        { "View buflib stats", dbg_buflib_stats },
 #ifdef BUFLIB_DEBUG_PRINT
         { "View buflib allocs", dbg_buflib_allocs },
 #endif
@@ -59,6 +59,7 @@ static struct compare_data
 {
     int sort_dir; /* qsort key for sorting directories */
     int(*_compar)(const char*, const char*, size_t);
+    unsigned key_flags; /* strnatkey() flags matching _compar */
 } cmp_data;
 
 /* dummmy functions to allow compatibility with strncmp & strncasecmp */
@@ -284,6 +285,70 @@ static int compare(const void* p1, const void* p2)
     return 0; /* never reached */
 }
 
+/* appends v to a collation key as 5 bytes that are never 0 */
+static size_t key_put_u32(char *key, uint32_t v)
+{
+    for (int i = 4; i >= 0; i--)
+        *key++ = 0x80 | ((v >> (7*i)) & 0x7f);
+    return 5;
+}
+
+/* collation key for tree_sort_by_key(), orders entries like compare() */
+static size_t make_key(const struct entry *e, char *key, size_t size)
+{
+    unsigned flags = cmp_data.key_flags;
+    size_t len = 0;
+    int criteria;
+
+    if (size < 7) /* class, 5 byte criteria, terminator */
+        return size;
+
+    if (e->attr & ATTR_DIRECTORY)
+    {   /* dirs go first */
+        criteria = cmp_data.sort_dir;
+        key[len++] = 2;
+#ifdef HAVE_MULTIVOLUME
+        if (e->attr & ATTR_VOLUME)
+        {   /* volumes before other dirs, alphabetically */
+            criteria = SORT_ALPHA;
+            key[0] = 1;
+        }
+#endif
+    }
+    else
+    {
+        criteria = global_settings.sort_file;
+        key[len++] = 3;
+    }
+
+    switch(criteria)
+    {
+        case SORT_TYPE:
+        case SORT_TYPE_REVERSED:
+        {
+            uint32_t t = e->attr & FILE_ATTR_MASK;
+
+            if (!t) /* unknown type sorts after known */
+                t = INT_MAX;
+            len += key_put_u32(&key[len],
+                               criteria == SORT_TYPE_REVERSED ? ~t : t);
+            break;
+        }
+
+        case SORT_DATE:
+        case SORT_DATE_REVERSED:
+            len += key_put_u32(&key[len], criteria == SORT_DATE_REVERSED ?
+                                          ~e->time_write : e->time_write);
+            break;
+
+        case SORT_ALPHA_REVERSED:
+            flags |= STRNATKEY_REVERSE;
+            break;
+    }
+
+    return len + strnatkey(&key[len], e->name, size - len, flags);
+}
+
 /* load and sort directory into the tree's cache. returns NULL on failure. */
 int ft_load(struct tree_context* c, const char* tempdir)
 {
@@ -412,19 +477,34 @@ int ft_load(struct tree_context* c, const char* tempdir)
     if (global_settings.sort_case)
     {
         if (global_settings.interpret_numbers == SORT_INTERPRET_AS_NUMBER)
+        {
             cmp_data._compar = strnatcmp_n;
+            cmp_data.key_flags = STRNATKEY_NUMBERS;
+        }
         else
+        {
             cmp_data._compar = strncmp;
+            cmp_data.key_flags = 0;
+        }
     }
     else
     {
         if (global_settings.interpret_numbers == SORT_INTERPRET_AS_NUMBER)
+        {
             cmp_data._compar = strnatcasecmp_n;
+            cmp_data.key_flags = STRNATKEY_NUMBERS | STRNATKEY_CASEFOLD;
+        }
         else
+        {
             cmp_data._compar = strncasecmp;
+            cmp_data.key_flags = STRNATKEY_CASEFOLD;
+        }
     }
 
-    qsort(tree_get_entries(c), files_in_dir, sizeof(struct entry), compare);
+    /* sort on collation keys if they fit, else compare names pairwise */
+    if (!tree_sort_by_key(c, tree_get_entries(c), files_in_dir,
+                          name_buffer_used, make_key))
+        qsort(tree_get_entries(c), files_in_dir, sizeof(struct entry), compare);
 
     /* If thumbnail talking is enabled, make an extra run to mark files with
        associated thumbnails, so we don't do unsuccessful spinups later. */
@@ -51,6 +51,8 @@ void list_draw(struct screen *display, struct gui_synclist *list);
 
 static long last_dirty_tick;
 static struct viewport parent[NB_SCREENS];
+/* list whose last spoken item may have its neighbours prefetched when idle */
+static struct gui_synclist *talk_prefetch_list;
 
 static bool list_is_dirty(struct gui_synclist *list)
 {
@@ -158,6 +160,8 @@ void gui_synclist_init(struct gui_synclist * gui_list,
     gui_list->callback_speak_item = NULL;
     gui_list->callback_draw_item = NULL;
     gui_list->nb_items = 0;
+    if (talk_prefetch_list == gui_list)
+        talk_prefetch_list = NULL;
     gui_list->selected_item = 0;
     gui_synclist_init_display_settings(gui_list);
 
@@ -345,10 +349,38 @@ static void _gui_synclist_speak_item(struct gui_synclist *lists)
             lists->scheduled_talk_tick = 0; /* work done */
             cb(lists->selected_item, lists->data);
             lists->last_talked_tick = current_tick;
+            talk_prefetch_list = lists;
         }
     }
 }
 
+/* Runs the speak callback in prefetch mode for what is likely to be spoken
+   next: the submenu of the selected item and the items next to it. This
+   only loads the voice clips so that moving on doesn't wait for the disk. */
+static void gui_synclist_prefetch_talk(struct gui_synclist *lists)
+{
+    list_speak_item *cb = lists->callback_speak_item;
+    int sel = lists->selected_item;
+    int nb_items = lists->nb_items;
+
+    talk_prefetch_list = NULL;
+    if (!cb || nb_items == 0)
+        return;
+
+    talk_prefetch(TALK_PREFETCH_NEXT_LEVEL);
+    cb(sel, lists->data);
+    talk_prefetch(TALK_PREFETCH_ITEM);
+    if (sel + 1 < nb_items)
+        cb(sel + 1, lists->data);
+    else if (lists->wraparound && nb_items > 1)
+        cb(0, lists->data);
+    if (sel > 0)
+        cb(sel - 1, lists->data);
+    else if (lists->wraparound && nb_items > 2)
+        cb(nb_items - 1, lists->data);
+    talk_prefetch(TALK_PREFETCH_OFF);
+}
+
 void gui_synclist_speak_item(struct gui_synclist *lists)
 {
     if (lists->talk_menu)
@@ -762,6 +794,9 @@ bool gui_synclist_do_button(struct gui_synclist * lists, int *actionptr)
        && TIME_AFTER(current_tick, lists->scheduled_talk_tick))
         /* scheduled postponed item announcement is due */
         _gui_synclist_speak_item(lists);
+    else if (action == ACTION_NONE && talk_prefetch_list == lists
+             && !lists->scheduled_talk_tick)
+        gui_synclist_prefetch_talk(lists);
     return false;
 }
 
@@ -786,6 +821,12 @@ int list_do_action_timeout(struct gui_synclist *lists, int timeout)
         if(timeout > delay || timeout == TIMEOUT_BLOCK)
             timeout = delay;
     }
+    else if (talk_prefetch_list == lists)
+    {
+        /* come back soon to prefetch the clips around the spoken item */
+        if(timeout > HZ/10 || timeout == TIMEOUT_BLOCK)
+            timeout = HZ/10;
+    }
     return timeout;
 }
 
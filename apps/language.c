@@ -27,6 +27,7 @@
 #include "debug.h"
 #include "string.h"
 #include "viewport.h"
+#include "font.h"
 
 /* The following header is generated by the build system and only defines
    MAX_LANGUAGE_SIZE to be the size of the largest currently available
@@ -141,6 +142,17 @@ int lang_english_to_id(const char *english)
     return -1;
 }
 
+void lang_prewarm_font(int font_id)
+{
+    /* low ids are the most common strings, so walk them in order and stop
+     * when the cache runs out of free slots */
+    for (int i = 0; i < LANG_LAST_INDEX_IN_ARRAY; i++)
+    {
+        if (!font_prewarm(font_id, language_strings[i]))
+            break;
+    }
+}
+
 int lang_is_rtl(void)
 {
     return (lang_options & LANGUAGE_FLAG_RTL) != 0;
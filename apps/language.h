@@ -35,6 +35,10 @@ int lang_load(const char *filename, const unsigned char *builtin,
 /* get the ID of an english string so it can be localised */
 int lang_english_to_id(const char *english);
 
+/* load the glyphs used by the current language into the free glyph cache
+ * slots of a font */
+void lang_prewarm_font(int font_id);
+
 /* returns whether the loaded language is a right-to-left language */
 int lang_is_rtl(void);
 /* returns whether the loaded language needs units spoken before the value */
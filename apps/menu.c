@@ -269,6 +269,21 @@ static int init_menu_lists(const struct menu_item_ex *menu,
     return start_action;
 }
 
+/* load the clips of the first entries of a submenu before it is entered */
+static void prefetch_submenu(const struct menu_item_ex *menu)
+{
+    int count = MENU_GET_COUNT(menu->flags);
+    for (int i = 0; i < count && i < 2; i++)
+    {
+        const struct menu_item_ex *item = menu->submenus[i];
+        int type = item->flags&MENU_TYPE_MASK;
+        if ((type == MT_SETTING) || (type == MT_SETTING_W_TEXT))
+            talk_setting(item->variable);
+        else if (!(item->flags&MENU_DYNAMIC_DESC))
+            talk_id(P2ID(item->callback_and_desc->desc), false);
+    }
+}
+
 static int talk_menu_item(int selected_item, void *data)
 {
     const struct menu_item_ex *menu = (const struct menu_item_ex *)data;
@@ -277,6 +292,13 @@ static int talk_menu_item(int selected_item, void *data)
     unsigned char *str;
     int sel = get_menu_selection(selected_item, menu);
 
+        if (talk_get_prefetch() == TALK_PREFETCH_NEXT_LEVEL)
+        {
+            if ((menu->flags&MENU_TYPE_MASK) == MT_MENU
+                && (menu->submenus[sel]->flags&MENU_TYPE_MASK) == MT_MENU)
+                prefetch_submenu(menu->submenus[sel]);
+            return 0;
+        }
         if ((menu->flags&MENU_TYPE_MASK) == MT_MENU)
         {
             type = menu->submenus[sel]->flags&MENU_TYPE_MASK;
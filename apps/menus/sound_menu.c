@@ -177,6 +177,8 @@ static int timestretch_callback(int action,
                      &global_settings.dithering_enabled, lowlatency_callback);
     MENUITEM_SETTING(afr_enabled,
                      &global_settings.afr_enabled, lowlatency_callback);
+    MENUITEM_SETTING(resample_quality,
+                     &global_settings.resample_quality, lowlatency_callback);
     MENUITEM_SETTING(pbe,
                      &global_settings.pbe, lowlatency_callback);
     MENUITEM_SETTING(pbe_precut,
@@ -257,7 +259,7 @@ MAKE_MENU(sound_settings, ID2P(LANG_SOUND_SETTINGS), NULL, Icon_Audio,
           ,&power_mode
 #endif
           ,&crossfeed_menu, &equalizer_menu, &dithering_enabled
-          ,&surround_menu, &pbe_menu, &afr_enabled
+          ,&surround_menu, &pbe_menu, &afr_enabled, &resample_quality
 #ifdef HAVE_PITCHCONTROL
           ,&timestretch_enabled
 #endif
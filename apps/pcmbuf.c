@@ -119,6 +119,12 @@ static size_t chunk_transidx;
 
 static size_t pcmbuf_watermark = 0;
 
+/* Track change pre-decode: decoded audio kept ahead so that the next
+   track's codec setup is covered, and the amount of the next track that is
+   decoded at full speed once the codec moves on to it */
+static unsigned int predecode_ms = 0;
+static size_t predecode_remaining = 0;
+
 static bool low_latency_mode = false;
 
 static bool pcmbuf_sync_position = false;
@@ -488,10 +494,20 @@ void * pcmbuf_request_buffer(int *count)
         /* Boost CPU if necessary */
         size_t realrem = pcmbuf_size - freespace;
 
-        if (realrem < pcmbuf_watermark)
+        if (predecode_remaining > 0)
+        {
+            /* Start of the next track - get its first frames in as quickly
+               as possible */
             trigger_cpu_boost();
+            boost_codec_thread(0);
+        }
+        else
+        {
+            if (realrem < pcmbuf_watermark)
+                trigger_cpu_boost();
 
-        boost_codec_thread(realrem*10 / pcmbuf_size);
+            boost_codec_thread(realrem*10 / pcmbuf_size);
+        }
     }
     else    /* !playing */
     {
@@ -530,6 +546,8 @@ void pcmbuf_write_complete(int count, unsigned long elapsed, off_t offset)
 {
     size_t size = count * PCMBUF_SAMPLE_SIZE;
 
+    predecode_remaining -= MIN(size, predecode_remaining);
+
 #ifdef HAVE_CROSSFADE
     if (crossfade_status != CROSSFADE_INACTIVE)
     {
@@ -578,6 +596,25 @@ static void init_buffer_state(void)
 
     /* Clear change notification */
     chunk_transidx = INVALID_BUF_INDEX;
+
+    predecode_remaining = 0;
+}
+
+/* Size of the track change pre-decode margin in bytes */
+static size_t predecode_size(void)
+{
+    return MIN(predecode_ms * (BYTERATE / 1000), pcmbuf_size / 2);
+}
+
+/* Set the low data watermark, at least the pre-decode margin */
+static void pcmbuf_update_watermark(size_t watermark)
+{
+    static size_t base_watermark = 0;
+
+    if (watermark)
+        base_watermark = watermark;
+
+    pcmbuf_watermark = MAX(base_watermark, predecode_size());
 }
 
 /* Initialize the PCM buffer. The structure looks like this:
@@ -603,7 +640,7 @@ size_t pcmbuf_init(void *bufend)
 #ifdef HAVE_CROSSFADE
     pcmbuf_finish_crossfade_enable();
 #else 
-    pcmbuf_watermark = PCMBUF_WATERMARK;
+    pcmbuf_update_watermark(PCMBUF_WATERMARK);
 #endif /* HAVE_CROSSFADE */
 
     init_buffer_state();
@@ -769,6 +806,8 @@ void pcmbuf_start_track_change(enum pcm_track_change_type type)
          * the track */
         logf("gapless track change");
 
+        predecode_remaining = predecode_size();
+
 #ifdef HAVE_CROSSFADE
         if (crossfade_status == CROSSFADE_ACTIVE)
             crossfade_status = CROSSFADE_CONTINUE;
@@ -860,6 +899,13 @@ void pcmbuf_play_stop(void)
     boost_codec_thread(10);
 }
 
+/* Set the track change pre-decode margin in milliseconds, 0 turns it off */
+void pcmbuf_set_predecode(unsigned int ms)
+{
+    predecode_ms = ms;
+    pcmbuf_update_watermark(0);
+}
+
 void pcmbuf_pause(bool pause)
 {
     logf("pcmbuf_pause: %s", pause?"pause":"play");
@@ -893,7 +939,7 @@ static void mixfader_init(struct mixfader *faderp, int32_t start_factor,
 
     int32_t dfact2 = 2*abs(end_factor - start_factor);
     faderp->factor = start_factor;
-    faderp->ferr   = dfact2 / 2;
+    faderp->ferr   = faderp->nsamp2 / 2;
     faderp->dfquo  = dfact2 / faderp->nsamp2;
     faderp->dfrem  = dfact2 - faderp->dfquo*faderp->nsamp2;
     faderp->dfinc  = end_factor < start_factor ? -1 : +1;
@@ -906,25 +952,202 @@ static inline bool mixfader_finished(const struct mixfader *faderp)
     return faderp->factor == faderp->endfac;
 }
 
-/* Step fader by one sample */
-static inline void mixfader_step(struct mixfader *faderp)
+/* Step fader by n samples */
+static inline void mixfader_advance(struct mixfader *faderp, int32_t n)
 {
     if (mixfader_finished(faderp))
         return;
 
-    faderp->factor += faderp->dfquo;
-    faderp->ferr += faderp->dfrem;
+    /* Same as n single steps: dfrem < nsamp2, so each step carries at most
+       once */
+    faderp->factor += faderp->dfquo * n;
+    faderp->ferr += faderp->dfrem * n;
 
     if (faderp->ferr >= faderp->nsamp2)
     {
-        faderp->factor += faderp->dfinc;
-        faderp->ferr -= faderp->nsamp2;
+        int32_t carry = faderp->ferr / faderp->nsamp2;
+        faderp->factor += faderp->dfinc * carry;
+        faderp->ferr -= carry * faderp->nsamp2;
+    }
+
+    /* Stop at the end of the envelope */
+    if ((faderp->factor - faderp->endfac) * faderp->dfinc > 0)
+        faderp->factor = faderp->endfac;
+}
+
+/* Gain is applied in blocks of this many bytes, the factor being stepped
+   once per block */
+#define MIXFADE_BLOCK_SIZE  (32 * PCMBUF_SAMPLE_SIZE)
+
+/* Apply a gain factor to size bytes of samples, into out or mixed with
+   the samples already in out. out and in may be the same for fading in
+   place. */
+#if defined(CPU_ARM) && ARM_ARCH >= 6
+static void mixfade_write(int16_t *out, const int16_t *in, int32_t amp,
+                          size_t size)
+{
+    uint32_t s, tmp;
+
+    asm volatile (
+    "1:                             \n"
+        "ldr    %3, [%1], #4        \n"
+        "subs   %2, %2, #4          \n"
+        "smulwt %4, %5, %3          \n"
+        "smulwb %3, %5, %3          \n"
+        "pkhbt  %4, %3, %4, asl #16 \n"
+        "str    %4, [%0], #4        \n"
+        "bhi    1b                  \n"
+        : "+r"(out), "+r"(in), "+r"(size),
+          "=&r"(s), "=&r"(tmp)
+        : "r"(amp)
+        : "memory");
+}
+
+static void mixfade_mix(int16_t *out, const int16_t *in, int32_t amp,
+                        size_t size)
+{
+    uint32_t s, d, tmp;
+
+    asm volatile (
+    "1:                             \n"
+        "ldr    %3, [%1], #4        \n"
+        "ldr    %4, [%0]            \n"
+        "subs   %2, %2, #4          \n"
+        "smulwt %5, %6, %3          \n"
+        "smulwb %3, %6, %3          \n"
+        "pkhbt  %5, %3, %5, asl #16 \n"
+        "qadd16 %4, %4, %5          \n"
+        "str    %4, [%0], #4        \n"
+        "bhi    1b                  \n"
+        : "+r"(out), "+r"(in), "+r"(size),
+          "=&r"(s), "=&r"(d), "=&r"(tmp)
+        : "r"(amp)
+        : "memory");
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+/* in * amp >> 16 for 0 <= amp < 65536 - the high half of the signed
+   product is off by in when amp doesn't fit a signed 16-bit lane */
+static FORCE_INLINE __m128i mixfade_mul(__m128i in, __m128i amp,
+                                        __m128i fix)
+{
+    return _mm_add_epi16(_mm_mulhi_epi16(in, amp), _mm_and_si128(in, fix));
+}
+
+static void mixfade_write(int16_t *out, const int16_t *in, int32_t amp,
+                          size_t size)
+{
+    if (amp >= MIXFADE_UNITY)
+    {
+        memmove(out, in, size);
+        return;
+    }
+
+    if (amp <= 0)
+    {
+        memset(out, 0, size);
+        return;
+    }
+
+    __m128i a = _mm_set1_epi16((int16_t)amp);
+    __m128i fix = _mm_set1_epi16(amp >= 0x8000 ? -1 : 0);
+
+    for (; size >= 16; size -= 16, in += 8, out += 8)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)in);
+        _mm_storeu_si128((__m128i *)out, mixfade_mul(x, a, fix));
+    }
+
+    for (; size; size -= 2)
+        *out++ = *in++ * amp >> 16;
+}
+
+static void mixfade_mix(int16_t *out, const int16_t *in, int32_t amp,
+                        size_t size)
+{
+    __m128i a = _mm_set1_epi16((int16_t)amp);
+    __m128i fix = _mm_set1_epi16(amp >= 0x8000 ? -1 : 0);
+
+    if (amp <= 0)
+        return;
+
+    for (; size >= 16; size -= 16, in += 8, out += 8)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)in);
+        __m128i y = _mm_loadu_si128((const __m128i *)out);
+
+        if (amp < MIXFADE_UNITY)
+            x = mixfade_mul(x, a, fix);
+
+        _mm_storeu_si128((__m128i *)out, _mm_adds_epi16(y, x));
+    }
+
+    for (; size; size -= 2, out++)
+        *out = clip_sample_16(*out + (*in++ * amp >> 16));
+}
+#else
+static void mixfade_write(int16_t *out, const int16_t *in, int32_t amp,
+                          size_t size)
+{
+    if (amp >= MIXFADE_UNITY)
+    {
+        memmove(out, in, size);
+        return;
+    }
+
+    if (amp <= 0)
+    {
+        memset(out, 0, size);
+        return;
+    }
+
+    for (; size; size -= PCMBUF_SAMPLE_SIZE)
+    {
+        int32_t left  = *in++ * amp >> 16;
+        int32_t right = *in++ * amp >> 16;
+        *out++ = left;
+        *out++ = right;
     }
 }
 
-static FORCE_INLINE int32_t mixfade_sample(const struct mixfader *faderp, int32_t s)
+static void mixfade_mix(int16_t *out, const int16_t *in, int32_t amp,
+                        size_t size)
 {
-    return (faderp->factor * s + MIXFADE_UNITY/2) >> MIXFADE_UNITY_BITS;
+    if (amp <= 0)
+        return;
+
+    for (; size; size -= PCMBUF_SAMPLE_SIZE)
+    {
+        int32_t left  = out[0] + (*in++ * amp >> 16);
+        int32_t right = out[1] + (*in++ * amp >> 16);
+        *out++ = clip_sample_16(left);
+        *out++ = clip_sample_16(right);
+    }
+}
+#endif /* CPU_* */
+
+/* Run the fader over size bytes, a block at a time */
+static void mixfade_run(struct mixfader *faderp, int16_t *out,
+                        const int16_t *in, size_t size, bool mix)
+{
+    while (size)
+    {
+        /* Once the envelope is done the gain is constant for the rest */
+        size_t amount = mixfader_finished(faderp) ?
+                            size : MIN(size, MIXFADE_BLOCK_SIZE);
+
+        if (mix)
+            mixfade_mix(out, in, faderp->factor, amount);
+        else
+            mixfade_write(out, in, faderp->factor, amount);
+
+        mixfader_advance(faderp, amount / PCMBUF_SAMPLE_SIZE);
+
+        out = SKIPBYTES(out, amount);
+        in = SKIPBYTES(in, amount);
+        size -= amount;
+    }
 }
 
 /* Cancel crossfade operation */
@@ -1042,42 +1265,25 @@ static void crossfade_mix_fade(struct mixfader *faderp, size_t size,
         if (alloced)
         {
             /* Fade the input buffer into the new destination chunk */
-            for (size_t s = amount; s != 0; s -= PCMBUF_SAMPLE_SIZE)
-            {
-                *outbuf++ = mixfade_sample(faderp, *inbuf++);
-                *outbuf++ = mixfade_sample(faderp, *inbuf++);
-                mixfader_step(faderp);
-            }
-
+            mixfade_run(faderp, outbuf, inbuf, amount, false);
             commit_write_buffer(amount);
         }
         else if (inbuf)
         {
             /* Fade the input buffer and mix into the destination chunk */
-            for (size_t s = amount; s != 0; s -= PCMBUF_SAMPLE_SIZE)
-            {
-                int32_t left  = outbuf[0];
-                int32_t right = outbuf[1];
-                left  += mixfade_sample(faderp, *inbuf++);
-                right += mixfade_sample(faderp, *inbuf++);
-                *outbuf++ = clip_sample_16(left);
-                *outbuf++ = clip_sample_16(right);
-                mixfader_step(faderp);
-            }
+            mixfade_run(faderp, outbuf, inbuf, amount, true);
         }
         else
         {
             /* Fade the chunk in place */
-            for (size_t s = amount; s != 0; s -= PCMBUF_SAMPLE_SIZE)
-            {
-                int32_t left  = outbuf[0];
-                int32_t right = outbuf[1];
-                *outbuf++ = mixfade_sample(faderp, left);
-                *outbuf++ = mixfade_sample(faderp, right);
-                mixfader_step(faderp);
-            }
+            mixfade_run(faderp, outbuf, outbuf, amount, false);
         }
 
+        if (inbuf)
+            inbuf = SKIPBYTES(inbuf, amount);
+
+        outbuf = SKIPBYTES(outbuf, amount);
+
         if (outbuf < chunkend)
         {
             index += amount;
@@ -1242,11 +1448,12 @@ static void pcmbuf_finish_crossfade_enable(void)
     /* Copy the pending setting over now */
     crossfade_setting = crossfade_enable_request;
 
-    pcmbuf_watermark = (crossfade_setting != CROSSFADE_ENABLE_OFF && pcmbuf_size) ?
+    pcmbuf_update_watermark(
+        (crossfade_setting != CROSSFADE_ENABLE_OFF && pcmbuf_size) ?
         /* If crossfading, try to keep the buffer full other than 1 second */
         (pcmbuf_size - BYTERATE) :
         /* Otherwise, just use the default */
-        PCMBUF_WATERMARK;
+        PCMBUF_WATERMARK);
 }
 
 void pcmbuf_request_crossfade_enable(int setting)
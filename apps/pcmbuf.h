@@ -48,6 +48,7 @@ enum pcm_track_change_type
 };
 void pcmbuf_monitor_track_change(bool monitor);
 void pcmbuf_start_track_change(enum pcm_track_change_type type);
+void pcmbuf_set_predecode(unsigned int ms);
 
 /* Crossfade */
 #ifdef HAVE_CROSSFADE
@@ -3996,6 +3996,13 @@ void audio_set_cuesheet(bool enable)
     }
 }
 
+/* Set how much decoded audio is kept ahead to cover a track change, in
+   milliseconds */
+void audio_set_track_predecode(int ms)
+{
+    pcmbuf_set_predecode(ms);
+}
+
 #ifdef HAVE_DISK_STORAGE
 /* Set the audio antiskip buffer margin in SECONDS */
 void audio_set_buffer_margin(int seconds)
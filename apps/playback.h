@@ -79,6 +79,7 @@ void audio_pre_ff_rewind(void);
 void audio_skip(int direction);
 
 void audio_set_cuesheet(bool enable);
+void audio_set_track_predecode(int ms);
 #ifdef HAVE_CROSSFADE
 void audio_set_crossfade(int enable);
 #endif
@@ -78,6 +78,7 @@
 #include "playlist.h"
 #include "ata_idle_notify.h"
 #include "file.h"
+#include "dir.h"
 #include "action.h"
 #include "mv.h"
 #include "debug.h"
@@ -144,6 +145,18 @@
 
 #define PLAYLIST_COMMAND_SIZE (MAX_PATH+12)
 
+/*
+ * The track offsets of the last large playlist file loaded into the current
+ * playlist are saved to PLAYLIST_INDEX_FILE, so resuming or replaying it
+ * reads them back instead of scanning the whole file again. The index is
+ * tied to the playlist through its path, size, modification time and a
+ * handful of content samples spread over the file.
+ */
+#define PLAYLIST_INDEX_MAGIC        0x504c4932 /* "PLI2" */
+#define PLAYLIST_INDEX_MIN_AMOUNT   1000 /* smaller ones scan fast enough */
+#define PLAYLIST_INDEX_SAMPLES      16
+#define PLAYLIST_INDEX_SAMPLE_SIZE  32
+
 /*
     Each playlist index has a flag associated with it which identifies what
     type of track it is.  These flags are stored in the 4 high order bits of
@@ -689,6 +702,175 @@ static void display_playlist_count(int count, const unsigned char *fmt,
     splashf(0, P2STR(fmt), count, str(LANG_OFF_ABORT));
 }
 
+struct playlist_index_header
+{
+    uint32_t magic;
+    uint32_t filesize;
+    uint32_t mtime;
+    uint32_t crc;
+    uint32_t amount;
+};
+
+/*
+ * modification time of the playlist file, 0 if it can't be found
+ */
+static uint32_t pl_index_mtime(struct playlist_info* playlist)
+{
+    char dirname[MAX_PATH];
+    struct dirent *entry;
+    uint32_t mtime = 0;
+
+    strlcpy(dirname, playlist->filename, sizeof(dirname));
+    char *name = strrchr(dirname, '/');
+    if (!name)
+        return 0;
+    *name++ = '\0';
+
+    DIR *dir = opendir(dirname[0] ? dirname : "/");
+    if (!dir)
+        return 0;
+
+    while ((entry = readdir(dir)))
+    {
+        if (!strcasecmp(entry->d_name, name))
+        {
+            struct dirinfo info = dir_get_info(dir, entry);
+            mtime = info.mtime;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return mtime;
+}
+
+/*
+ * fingerprint of the playlist file a saved index belongs to
+ */
+static uint32_t pl_index_crc(struct playlist_info* playlist, off_t size,
+                             char* buffer)
+{
+    uint32_t crc = crc_32(playlist->filename, strlen(playlist->filename), -1);
+    off_t step = 0;
+
+    if (size > PLAYLIST_INDEX_SAMPLE_SIZE)
+        step = (size - PLAYLIST_INDEX_SAMPLE_SIZE) / (PLAYLIST_INDEX_SAMPLES - 1);
+
+    for (int i = 0; i < PLAYLIST_INDEX_SAMPLES; i++)
+    {
+        ssize_t nread = -1;
+        if (lseek(playlist->fd, step * i, SEEK_SET) >= 0)
+            nread = read(playlist->fd, buffer, PLAYLIST_INDEX_SAMPLE_SIZE);
+        if (nread > 0)
+            crc = crc_32(buffer, nread, crc);
+    }
+
+    return crc;
+}
+
+/*
+ * load the track offsets from a saved index if it matches the playlist file,
+ * the indices are copied through buffer since they may move while read()
+ * yields
+ */
+static bool pl_load_index(struct playlist_info* playlist,
+                          char* buffer, size_t buflen)
+{
+    struct playlist_index_header hdr;
+    size_t chunk = buflen / sizeof(*playlist->indices);
+    bool ok = false;
+
+    if (playlist != &current_playlist || playlist->amount != 0 ||
+        buflen < PLAYLIST_INDEX_SAMPLE_SIZE)
+        return false;
+
+    int fd = open(PLAYLIST_INDEX_FILE, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    off_t size = filesize(playlist->fd);
+
+    if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+        hdr.magic != PLAYLIST_INDEX_MAGIC ||
+        hdr.filesize != (uint32_t)size ||
+        hdr.mtime != pl_index_mtime(playlist) ||
+        hdr.amount > (uint32_t)playlist->max_playlist_size ||
+        hdr.crc != pl_index_crc(playlist, size, buffer))
+        goto exit;
+
+    while (playlist->amount < (int)hdr.amount)
+    {
+        size_t count = MIN(chunk, hdr.amount - playlist->amount);
+        size_t bytes = count * sizeof(*playlist->indices);
+
+        if (read(fd, buffer, bytes) != (ssize_t)bytes)
+        {
+            playlist->amount = 0;
+            goto exit;
+        }
+
+        memcpy(&playlist->indices[playlist->amount], buffer, bytes);
+        playlist->amount += count;
+    }
+
+    dc_init_filerefs(playlist, 0, playlist->amount);
+    ok = true;
+    NOTEF("%s: %d tracks from index", __func__, playlist->amount);
+
+exit:
+    close(fd);
+    return ok;
+}
+
+/*
+ * save the track offsets of a freshly scanned playlist file. The magic is
+ * written last so an interrupted save never looks valid.
+ */
+static void pl_save_index(struct playlist_info* playlist,
+                          char* buffer, size_t buflen)
+{
+    struct playlist_index_header hdr;
+    size_t chunk = buflen / sizeof(*playlist->indices);
+    bool ok = true;
+
+    if (playlist != &current_playlist ||
+        playlist->amount < PLAYLIST_INDEX_MIN_AMOUNT ||
+        buflen < PLAYLIST_INDEX_SAMPLE_SIZE)
+        return;
+
+    int fd = open(PLAYLIST_INDEX_FILE, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+        return;
+
+    hdr.magic = 0;
+    hdr.filesize = filesize(playlist->fd);
+    hdr.mtime = pl_index_mtime(playlist);
+    hdr.crc = pl_index_crc(playlist, hdr.filesize, buffer);
+    hdr.amount = playlist->amount;
+
+    if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+        ok = false;
+
+    for (int i = 0; ok && i < playlist->amount; i += chunk)
+    {
+        size_t count = MIN(chunk, (size_t)(playlist->amount - i));
+        size_t bytes = count * sizeof(*playlist->indices);
+
+        memcpy(buffer, &playlist->indices[i], bytes);
+        if (write(fd, buffer, bytes) != (ssize_t)bytes)
+            ok = false;
+    }
+
+    if (ok)
+    {
+        hdr.magic = PLAYLIST_INDEX_MAGIC;
+        lseek(fd, 0, SEEK_SET);
+        write(fd, &hdr, sizeof(hdr));
+    }
+
+    close(fd);
+}
+
 /*
  * calculate track offsets within a playlist file
  */
@@ -718,6 +900,12 @@ static int add_indices_to_playlist(struct playlist_info* playlist,
     i = lseek(playlist->fd, 0, SEEK_CUR);
 
     splash(0, ID2P(LANG_WAIT));
+
+    if (pl_load_index(playlist, buffer, buflen))
+        goto exit;
+
+    /* pl_index_crc() moved the file position */
+    lseek(playlist->fd, i, SEEK_SET);
     store_index = true;
 
     while(1)
@@ -759,6 +947,8 @@ static int add_indices_to_playlist(struct playlist_info* playlist,
         i+= count;
     }
 
+    pl_save_index(playlist, buffer, buflen);
+
 exit:
     playlist_write_unlock(playlist);
     return result;
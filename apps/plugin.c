@@ -837,6 +837,12 @@ static const struct plugin_api rockbox_api = {
 #endif
     playlist_get_first_index,
     playlist_get_display_index,
+    inflate,
+    inflate_buffer_reader,
+    inflate_buffer_writer,
+    inflate_getsize_writer,
+    &inflate_size,
+    &inflate_align,
 };
 
 static int plugin_buffer_handle;
@@ -109,6 +109,7 @@ int plugin_open(const char *plugin, const char *parameter);
 #include "settings_list.h"
 #include "timefuncs.h"
 #include "crc32.h"
+#include "inflate.h"
 #include "rbpaths.h"
 #include "core_alloc.h"
 #include "screen_access.h"
@@ -163,7 +164,7 @@ int plugin_open(const char *plugin, const char *parameter);
  * when this happens please take the opportunity to sort in
  * any new functions "waiting" at the end of the list.
  */
-#define PLUGIN_API_VERSION 270
+#define PLUGIN_API_VERSION 273
 
 /* 239 Marks the removal of ARCHOS HWCODEC and CHARCELL */
 
@@ -974,6 +975,15 @@ struct plugin_api {
 #endif
     int (*playlist_get_first_index)(const struct playlist_info* playlist);
     int (*playlist_get_display_index)(void);
+    int (*inflate)(struct inflate* it, int st, inflate_reader read, void* rctx,
+                   inflate_writer write, void* wctx);
+    uint32_t (*inflate_buffer_reader)(void* block, uint32_t block_size, void* ctx);
+    uint32_t (*inflate_buffer_writer)(const void* block, uint32_t block_size,
+                                      void* ctx);
+    uint32_t (*inflate_getsize_writer)(const void* block, uint32_t block_size,
+                                       void* ctx);
+    const uint32_t *inflate_size;
+    const uint32_t *inflate_align;
 };
 
 /* plugin header */
@@ -68,6 +68,7 @@
 // SKY handling - still the wrong place.
 #include "r_data.h"
 #include "r_sky.h"
+#include "r_plane.h"
 #include "p_inter.h"
 #include "g_game.h"
 
@@ -2778,14 +2779,17 @@ boolean G_CheckDemoStatus (void)
       int endtime = I_GetTime ();
       // killough -- added fps information and made it work for longer demos:
       unsigned realtics = endtime-starttime;
-      int fd=open(GAMEBASE "timedemo.txt",O_WRONLY | O_CREAT,0666);
-      fdprintf (fd,"Timed %d gametics in %d realtics = %d frames per second",
-               (unsigned) gametic, realtics,
-               (unsigned) gametic * TICRATE/ realtics);
+      // one frame per tic, singletics is on; tenths of fps for the report
+      unsigned fps10 = realtics ? (unsigned) gametic * TICRATE * 10 / realtics : 0;
+      int fd=open(GAMEBASE "timedemo.txt",O_WRONLY | O_CREAT | O_TRUNC,0666);
+      fdprintf (fd,"Timed %d gametics in %d realtics = %u.%u frames per second"
+                   " (flats on %d core%s)\n",
+               (unsigned) gametic, realtics, fps10/10, fps10%10,
+               R_PlaneCores(), R_PlaneCores() > 1 ? "s" : "");
       close(fd);
-      I_Error ("%d gametics in %d realtics",
-               (unsigned) gametic,realtics,
-               (unsigned) gametic * TICRATE / realtics);
+      I_Error ("Timedemo: %u.%u fps, %d core%s",
+               fps10/10, fps10%10,
+               R_PlaneCores(), R_PlaneCores() > 1 ? "s" : "");
       return false;
    }
 
@@ -56,6 +56,7 @@
 #include "d_net.h"
 #include "g_game.h"
 #include "z_zone.h"
+#include "r_plane.h"
 
 #ifdef __GNUG__
 #pragma implementation "i_system.h"
@@ -123,6 +124,7 @@ void I_Quit (void)
    I_ShutdownSound();
    I_ShutdownMusic();
    I_ShutdownGraphics();
+   R_ShutdownPlanes();
 #if defined(HAVE_LCD_COLOR) && !defined(SIMULATOR) && !defined(RB_PROFILE)
    rb->timer_unregister();
 #endif
@@ -1161,6 +1161,8 @@ void I_InitGraphics(void)
    d_screens[0] = fastscreen;
 #else
    // Don't know if this will fit in other IRAMs
-   d_screens[0] = malloc (LCD_WIDTH * LCD_HEIGHT * sizeof(unsigned char));
+   // Cache aligned, so R_DrawPlanes can split it between the cores
+   d_screens[0] = CACHEALIGN_UP((byte *)malloc (LCD_WIDTH * LCD_HEIGHT *
+                     sizeof(unsigned char) + CACHEALIGN_SIZE - 1));
 #endif
 }
@@ -34,6 +34,7 @@
 #include "doomstat.h"
 #include "w_wad.h"
 #include "r_main.h"
+#include "r_draw.h"
 #include "v_video.h"
 #include "st_stuff.h"
 #include "g_game.h"
@@ -131,36 +132,58 @@ void R_DrawColumn (void)
    //
    // killough 2/1/98: more performance tuning
 
-   if (dc_texheight == 128)
+   // The common cases draw four pixels per iteration, which
+   // keeps source, colormap and the stride in registers and saves the
+   // loop overhead on the tall columns that dominate a frame.
+
    {
-      while(count--)
+      register const byte *source = dc_source;
+      register const lighttable_t *colormap = dc_colormap;
+      register const int stride = SCREENWIDTH;
+      register unsigned heightmask = dc_texheight-1; // CPhipps - specify type
+
+      if (dc_texheight == 0)
       {
-         *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
-         frac += fracstep;
-         dest += SCREENWIDTH;
+         /* cph - another special case */
+         for (; count >= 4; count -= 4)
+         {
+            dest[0]        = colormap[source[frac>>FRACBITS]];
+            frac += fracstep;
+            dest[stride]   = colormap[source[frac>>FRACBITS]];
+            frac += fracstep;
+            dest[stride*2] = colormap[source[frac>>FRACBITS]];
+            frac += fracstep;
+            dest[stride*3] = colormap[source[frac>>FRACBITS]];
+            frac += fracstep;
+            dest += stride*4;
+         }
+         while (count--)
+         {
+            *dest = colormap[source[frac>>FRACBITS]];
+            frac += fracstep;
+            dest += stride;
+         }
       }
-   }
-   else if (dc_texheight == 0)
-   {
-      /* cph - another special case */
-      while (count--)
+      else if (! (dc_texheight & heightmask) )   // power of 2 -- killough
       {
-         *dest = dc_colormap[dc_source[frac>>FRACBITS]];
-         frac += fracstep;
-         dest += SCREENWIDTH;
-      }
-   }
-   else
-   {
-      register unsigned heightmask = dc_texheight-1; // CPhipps - specify type
-      if (! (dc_texheight & heightmask) )   // power of 2 -- killough
-      {
-         while (count>0)   // texture height is a power of 2 -- killough
+         // this includes the usual 128 high wall textures
+         for (; count >= 4; count -= 4)
          {
-            *dest = dc_colormap[dc_source[(frac>>FRACBITS) & heightmask]];
-            dest += SCREENWIDTH;
+            dest[0]        = colormap[source[(frac>>FRACBITS) & heightmask]];
             frac += fracstep;
-            count--;
+            dest[stride]   = colormap[source[(frac>>FRACBITS) & heightmask]];
+            frac += fracstep;
+            dest[stride*2] = colormap[source[(frac>>FRACBITS) & heightmask]];
+            frac += fracstep;
+            dest[stride*3] = colormap[source[(frac>>FRACBITS) & heightmask]];
+            frac += fracstep;
+            dest += stride*4;
+         }
+         while (count--)
+         {
+            *dest = colormap[source[(frac>>FRACBITS) & heightmask]];
+            frac += fracstep;
+            dest += stride;
          }
       }
       else
@@ -182,8 +205,8 @@ void R_DrawColumn (void)
 
             // heightmask is the Tutti-Frutti fix -- killough
 
-            *dest = dc_colormap[dc_source[frac>>FRACBITS]];
-            dest += SCREENWIDTH;
+            *dest = colormap[source[frac>>FRACBITS]];
+            dest += stride;
             if ((frac += fracstep) >= (int)heightmask)
                frac -= heightmask;
             count--;
@@ -510,21 +533,7 @@ void R_InitTranslationTables (void)
 //  and the inner loop has to step in texture space u and v.
 //
 
-int  ds_y IBSS_ATTR;
-int  ds_x1 IBSS_ATTR;
-int  ds_x2 IBSS_ATTR;
-
-lighttable_t *ds_colormap IBSS_ATTR;
-
-fixed_t ds_xfrac IBSS_ATTR;
-fixed_t ds_yfrac IBSS_ATTR;
-fixed_t ds_xstep IBSS_ATTR;
-fixed_t ds_ystep IBSS_ATTR;
-
-// start of a 64*64 tile image
-byte *ds_source IBSS_ATTR;
-
-void R_DrawSpan (void)
+void R_DrawSpan (const draw_span_vars_t *dsvars)
 {
 #ifdef CPU_COLDFIRE
    // only slightly faster
@@ -550,37 +559,52 @@ void R_DrawSpan (void)
    : /* outputs */
    : /* inputs */
       [ten] "d"(10),
-      [count] "d" (ds_x2-ds_x1+1),
-      [xfrac] "a" (ds_xfrac),
-      [yfrac] "a" (ds_yfrac),
-      [source] "a" (ds_source),
-      [colormap] "a" (ds_colormap),
-      [dest] "a" (topleft+ds_y*SCREENWIDTH +ds_x1),
-      [ds_xstep] "d" (ds_xstep),
-      [ds_ystep] "d" (ds_ystep)
+      [count] "d" (dsvars->x2-dsvars->x1+1),
+      [xfrac] "a" (dsvars->xfrac),
+      [yfrac] "a" (dsvars->yfrac),
+      [source] "a" (dsvars->source),
+      [colormap] "a" (dsvars->colormap),
+      [dest] "a" (topleft+dsvars->y*SCREENWIDTH +dsvars->x1),
+      [ds_xstep] "d" (dsvars->xstep),
+      [ds_ystep] "d" (dsvars->ystep)
    : /* clobbers */
       "d1", "d2", "d4"
    );
 #else
-   register unsigned count = ds_x2 - ds_x1 + 1,xfrac = ds_xfrac,yfrac = ds_yfrac;
+   register unsigned count = dsvars->x2 - dsvars->x1 + 1;
+   register unsigned xfrac = dsvars->xfrac, yfrac = dsvars->yfrac;
+   register const unsigned xstep = dsvars->xstep, ystep = dsvars->ystep;
+
+   register const byte *source = dsvars->source;
+   register const byte *colormap = dsvars->colormap;
+   register byte *dest = topleft + dsvars->y*SCREENWIDTH + dsvars->x1;
 
-   register byte *source = ds_source;
-   register byte *colormap = ds_colormap;
-   register byte *dest = topleft + ds_y*SCREENWIDTH + ds_x1;
+#define SPANSPOT() (((xfrac >> 16) & 63) | ((yfrac >> 10) & 4032))
 
-   while (count)
+   // four pixels per iteration, as in R_DrawColumn
+   for (; count >= 4; count -= 4)
+   {
+      dest[0] = colormap[source[SPANSPOT()]];
+      xfrac += xstep;
+      yfrac += ystep;
+      dest[1] = colormap[source[SPANSPOT()]];
+      xfrac += xstep;
+      yfrac += ystep;
+      dest[2] = colormap[source[SPANSPOT()]];
+      xfrac += xstep;
+      yfrac += ystep;
+      dest[3] = colormap[source[SPANSPOT()]];
+      xfrac += xstep;
+      yfrac += ystep;
+      dest += 4;
+   }
+   while (count--)
    {
-      register unsigned xtemp = xfrac >> 16;
-      register unsigned ytemp = yfrac >> 10;
-      register unsigned spot;
-      ytemp &= 4032;
-      xtemp &= 63;
-      spot = xtemp | ytemp;
-      xfrac += ds_xstep;
-      yfrac += ds_ystep;
-      *dest++ = colormap[source[spot]];
-      count--;
+      *dest++ = colormap[source[SPANSPOT()]];
+      xfrac += xstep;
+      yfrac += ystep;
    }
+#undef SPANSPOT
 #endif
 }
 
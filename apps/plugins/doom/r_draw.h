@@ -49,6 +49,9 @@ extern int      dc_texheight;    // killough
 // first pixel in a column
 extern const byte     *dc_source;
 
+// top left pixel of the view
+extern byte *topleft;
+
 // The span blitting interface.
 // Hook in assembler or system specific BLT here.
 
@@ -63,24 +66,23 @@ void R_DrawTranslatedColumn(void);
 
 void R_VideoErase(unsigned ofs, int count);
 
-extern lighttable_t *ds_colormap;
-
-extern int     ds_y;
-extern int     ds_x1;
-extern int     ds_x2;
-extern fixed_t ds_xfrac;
-extern fixed_t ds_yfrac;
-extern fixed_t ds_xstep;
-extern fixed_t ds_ystep;
+// Everything a span needs, passed along rather than kept in globals
+// so floors and ceilings can be drawn on both cores at once.
+typedef struct
+{
+   int           y, x1, x2;
+   fixed_t       xfrac, yfrac;
+   fixed_t       xstep, ystep;
+   const byte    *source;       // start of a 64*64 tile image
+   lighttable_t  *colormap;
+} draw_span_vars_t;
 
-// start of a 64*64 tile image
-extern byte *ds_source;
 extern byte playernumtotrans[MAXPLAYERS]; // CPhipps - what translation table for what player
 extern byte *translationtables;
 extern byte *dc_translation;
 
 // Span blitting for rows, floor/ceiling. No Spectre effect needed.
-void R_DrawSpan(void) ICODE_ATTR;
+void R_DrawSpan(const draw_span_vars_t *dsvars) ICODE_ATTR;
 
 void R_InitBuffer(int width, int height);
 
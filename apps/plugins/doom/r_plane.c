@@ -75,57 +75,87 @@ short *openings,*lastopening;
 
 short floorclip[MAX_SCREENWIDTH], ceilingclip[MAX_SCREENWIDTH];
 
-// spanstart holds the start of a plane span; initialized to 0 at start
-
-static int spanstart[MAX_SCREENHEIGHT];                // killough 2/8/98
-
 //
 // texture mapping
 //
 
-static lighttable_t **planezlight;
-static fixed_t planeheight;
-
 // killough 2/8/98: make variables static
 
 static fixed_t basexscale, baseyscale;
-static fixed_t cachedheight[MAX_SCREENHEIGHT];
-static fixed_t cacheddistance[MAX_SCREENHEIGHT];
-static fixed_t cachedxstep[MAX_SCREENHEIGHT];
-static fixed_t cachedystep[MAX_SCREENHEIGHT];
-static fixed_t xoffs, yoffs;    // killough 2/28/98: flat offsets
 
-fixed_t yslope[MAX_SCREENHEIGHT], distscale[MAX_SCREENWIDTH];
+// Everything R_MapPlane changes while drawing a flat. There is one of
+// these per core drawing flats, see R_DrawPlanes.
 
-//
-// R_InitPlanes
-// Only at game startup.
-//
-void R_InitPlanes (void)
+typedef struct
 {
-}
+   // spanstart holds the start of a plane span; initialized to 0 at start
+   int spanstart[MAX_SCREENHEIGHT];                // killough 2/8/98
+
+   fixed_t cachedheight[MAX_SCREENHEIGHT];
+   fixed_t cacheddistance[MAX_SCREENHEIGHT];
+   fixed_t cachedxstep[MAX_SCREENHEIGHT];
+   fixed_t cachedystep[MAX_SCREENHEIGHT];
+
+   lighttable_t **planezlight;
+   fixed_t planeheight;
+   fixed_t xoffs, yoffs;    // killough 2/28/98: flat offsets
+
+   draw_span_vars_t dsvars;
+} planestate_t;
+
+static planestate_t planestate;
+
+#if NUM_CORES > 1 && defined(HAVE_SEMAPHORE_OBJECTS)
+/*
+ * The COP draws the flats left of a split column while the CPU draws the
+ * ones right of it. Caches aren't coherent, so the split sits on a cache
+ * line boundary of the screen and both cores write back their caches
+ * before handing over.
+ */
+#define PLANES_ON_COP
+
+static struct cop_planes
+{
+   planestate_t ps;
+   int stop;                // last column for the COP
+   bool quit;
+} CACHEALIGN_ATTR cop_planes;
+
+static struct semaphore cop_start SHAREDBSS_ATTR;
+static struct semaphore cop_done SHAREDBSS_ATTR;
+static unsigned int cop_thread_id;
+static long cop_stack[CACHEALIGN_UP(DEFAULT_STACK_SIZE/sizeof(long))]
+                      CACHEALIGN_AT_LEAST_ATTR(4);
+#endif
+
+static int planecores = 1;    // cores used for the last frame
+
+fixed_t yslope[MAX_SCREENHEIGHT], distscale[MAX_SCREENWIDTH];
 
 //
 // R_MapPlane
 //
 // Uses global vars:
-//  planeheight
-//  ds_source
 //  basexscale
 //  baseyscale
 //  viewx
 //  viewy
+//
+// and from the plane state:
+//  planeheight
+//  dsvars.source
 //  xoffs
 //  yoffs
 //
 // BASIC PRIMITIVE
 //
 
-static void R_MapPlane(int y, int x1, int x2)
+static void R_MapPlane(planestate_t *ps, int y, int x1, int x2)
 {
    angle_t angle;
    fixed_t distance, length;
    unsigned index;
+   draw_span_vars_t *dsvars = &ps->dsvars;
 
 #ifdef RANGECHECK
 
@@ -133,40 +163,40 @@ static void R_MapPlane(int y, int x1, int x2)
       I_Error ("R_MapPlane: %i, %i at %i",x1,x2,y);
 #endif
 
-   if (planeheight != cachedheight[y])
+   if (ps->planeheight != ps->cachedheight[y])
    {
-      cachedheight[y] = planeheight;
-      distance = cacheddistance[y] = FixedMul (planeheight, yslope[y]);
-      ds_xstep = cachedxstep[y] = FixedMul (distance,basexscale);
-      ds_ystep = cachedystep[y] = FixedMul (distance,baseyscale);
+      ps->cachedheight[y] = ps->planeheight;
+      distance = ps->cacheddistance[y] = FixedMul (ps->planeheight, yslope[y]);
+      dsvars->xstep = ps->cachedxstep[y] = FixedMul (distance,basexscale);
+      dsvars->ystep = ps->cachedystep[y] = FixedMul (distance,baseyscale);
    }
    else
    {
-      distance = cacheddistance[y];
-      ds_xstep = cachedxstep[y];
-      ds_ystep = cachedystep[y];
+      distance = ps->cacheddistance[y];
+      dsvars->xstep = ps->cachedxstep[y];
+      dsvars->ystep = ps->cachedystep[y];
    }
 
    length = FixedMul (distance,distscale[x1]);
    angle = (viewangle + xtoviewangle[x1])>>ANGLETOFINESHIFT;
 
    // killough 2/28/98: Add offsets
-   ds_xfrac =  viewx + FixedMul(finecosine[angle], length) + xoffs;
-   ds_yfrac = -viewy - FixedMul(finesine[angle],   length) + yoffs;
+   dsvars->xfrac =  viewx + FixedMul(finecosine[angle], length) + ps->xoffs;
+   dsvars->yfrac = -viewy - FixedMul(finesine[angle],   length) + ps->yoffs;
 
-   if (!(ds_colormap = fixedcolormap))
+   if (!(dsvars->colormap = fixedcolormap))
    {
       index = distance >> LIGHTZSHIFT;
       if (index >= MAXLIGHTZ )
          index = MAXLIGHTZ-1;
-      ds_colormap = planezlight[index];
+      dsvars->colormap = ps->planezlight[index];
    }
 
-   ds_y = y;
-   ds_x1 = x1;
-   ds_x2 = x2;
+   dsvars->y = y;
+   dsvars->x1 = x1;
+   dsvars->x2 = x2;
 
-   R_DrawSpan();
+   R_DrawSpan(dsvars);
 }
 
 //
@@ -190,7 +220,10 @@ void R_ClearPlanes(void)
    lastopening = openings;
 
    // texture calculation
-   memset (cachedheight, 0, sizeof(cachedheight));
+   memset (planestate.cachedheight, 0, sizeof(planestate.cachedheight));
+#ifdef PLANES_ON_COP
+   memset (cop_planes.ps.cachedheight, 0, sizeof(cop_planes.ps.cachedheight));
+#endif
 
    // left to right mapping
    angle = (viewangle-ANG90)>>ANGLETOFINESHIFT;
@@ -310,123 +343,221 @@ visplane_t *R_CheckPlane(visplane_t *pl, int start, int stop)
 // R_MakeSpans
 //
 
-static void R_MakeSpans(int x, int t1, int b1, int t2, int b2)
+static void R_MakeSpans(planestate_t *ps, int x, int t1, int b1, int t2, int b2)
 {
    for (; t1 < t2 && t1 <= b1; t1++)
-      R_MapPlane(t1, spanstart[t1], x-1);
+      R_MapPlane(ps, t1, ps->spanstart[t1], x-1);
    for (; b1 > b2 && b1 >= t1; b1--)
-      R_MapPlane(b1, spanstart[b1] ,x-1);
+      R_MapPlane(ps, b1, ps->spanstart[b1] ,x-1);
    while (t2 < t1 && t2 <= b2)
-      spanstart[t2++] = x;
+      ps->spanstart[t2++] = x;
    while (b2 > b1 && b2 >= t2)
-      spanstart[b2--] = x;
+      ps->spanstart[b2--] = x;
 }
 
-// New function, by Lee Killough
+#define R_IsSkyPlane(pl) ((pl)->picnum == skyflatnum || (pl)->picnum & PL_SKYFLAT)
+#define R_FlatLump(pl) (firstflat + flattranslation[(pl)->picnum])
 
-static void R_DoDrawPlane(visplane_t *pl)
+static void R_DrawSkyPlane(const visplane_t *pl)
 {
    register int x;
-   if (pl->minx <= pl->maxx)
-   {
-      if (pl->picnum == skyflatnum || pl->picnum & PL_SKYFLAT)
-      { // sky flat
-         int texture;
-         angle_t an, flip;
+   int texture;
+   angle_t an, flip;
 
-         // killough 10/98: allow skies to come from sidedefs.
-         // Allows scrolling and/or animated skies, as well as
-         // arbitrary multiple skies per level without having
-         // to use info lumps.
+   // killough 10/98: allow skies to come from sidedefs.
+   // Allows scrolling and/or animated skies, as well as
+   // arbitrary multiple skies per level without having
+   // to use info lumps.
 
-         an = viewangle;
+   an = viewangle;
 
-         if (pl->picnum & PL_SKYFLAT)
-         {
-            // Sky Linedef
-            const line_t *l = &lines[pl->picnum & ~PL_SKYFLAT];
+   if (pl->picnum & PL_SKYFLAT)
+   {
+      // Sky Linedef
+      const line_t *l = &lines[pl->picnum & ~PL_SKYFLAT];
 
-            // Sky transferred from first sidedef
-            const side_t *s = *l->sidenum + sides;
+      // Sky transferred from first sidedef
+      const side_t *s = *l->sidenum + sides;
 
-            // Texture comes from upper texture of reference sidedef
-            texture = texturetranslation[s->toptexture];
+      // Texture comes from upper texture of reference sidedef
+      texture = texturetranslation[s->toptexture];
 
-            // Horizontal offset is turned into an angle offset,
-            // to allow sky rotation as well as careful positioning.
-            // However, the offset is scaled very small, so that it
-            // allows a long-period of sky rotation.
+      // Horizontal offset is turned into an angle offset,
+      // to allow sky rotation as well as careful positioning.
+      // However, the offset is scaled very small, so that it
+      // allows a long-period of sky rotation.
 
-            an += s->textureoffset;
+      an += s->textureoffset;
 
-            // Vertical offset allows careful sky positioning.
+      // Vertical offset allows careful sky positioning.
 
-            dc_texturemid = s->rowoffset - 28*FRACUNIT;
+      dc_texturemid = s->rowoffset - 28*FRACUNIT;
 
-            // We sometimes flip the picture horizontally.
-            //
-            // Doom always flipped the picture, so we make it optional,
-            // to make it easier to use the new feature, while to still
-            // allow old sky textures to be used.
+      // We sometimes flip the picture horizontally.
+      //
+      // Doom always flipped the picture, so we make it optional,
+      // to make it easier to use the new feature, while to still
+      // allow old sky textures to be used.
 
-            flip = l->special==272 ? 0u : ~0u;
-         }
-         else
-         {    // Normal Doom sky, only one allowed per level
-            dc_texturemid = skytexturemid;    // Default y-offset
-            texture = skytexture;             // Default texture
-            flip = 0;                         // Doom flips it
-         }
+      flip = l->special==272 ? 0u : ~0u;
+   }
+   else
+   {    // Normal Doom sky, only one allowed per level
+      dc_texturemid = skytexturemid;    // Default y-offset
+      texture = skytexture;             // Default texture
+      flip = 0;                         // Doom flips it
+   }
 
-         /* Sky is always drawn full bright, i.e. colormaps[0] is used.
-          * Because of this hack, sky is not affected by INVUL inverse mapping.
-          * Until Boom fixed this. Compat option added in MBF. */
-
-         if (comp[comp_skymap] || !(dc_colormap = fixedcolormap))
-            dc_colormap = fullcolormap;          // killough 3/20/98
-         dc_texheight = textureheight[skytexture]>>FRACBITS; // killough
-         // proff 09/21/98: Changed for high-res
-         dc_iscale = FRACUNIT*200/viewheight;
-
-         // killough 10/98: Use sky scrolling offset, and possibly flip picture
-         for (x = pl->minx; (dc_x = x) <= pl->maxx; x++)
-            if ((dc_yl = pl->top[x]) <= (dc_yh = pl->bottom[x]))
-            {
-               dc_source = R_GetColumn(texture, ((an + xtoviewangle[x])^flip) >>
-                                       ANGLETOSKYSHIFT);
-               colfunc();
-            }
+   /* Sky is always drawn full bright, i.e. colormaps[0] is used.
+    * Because of this hack, sky is not affected by INVUL inverse mapping.
+    * Until Boom fixed this. Compat option added in MBF. */
+
+   if (comp[comp_skymap] || !(dc_colormap = fixedcolormap))
+      dc_colormap = fullcolormap;          // killough 3/20/98
+   dc_texheight = textureheight[skytexture]>>FRACBITS; // killough
+   // proff 09/21/98: Changed for high-res
+   dc_iscale = FRACUNIT*200/viewheight;
+
+   // killough 10/98: Use sky scrolling offset, and possibly flip picture
+   for (x = pl->minx; (dc_x = x) <= pl->maxx; x++)
+      if ((dc_yl = pl->top[x]) <= (dc_yh = pl->bottom[x]))
+      {
+         dc_source = R_GetColumn(texture, ((an + xtoviewangle[x])^flip) >>
+                                 ANGLETOSKYSHIFT);
+         colfunc();
       }
-      else
-      {     // regular flat
+}
 
-         int stop, light;
+//
+// R_DrawFlatColumns
+// Draws columns start to stop of a regular flat, which has been locked
+// in pl->source. Spans crossing start or stop are cut there, so each
+// core can draw its own range of columns of the same plane.
+//
 
-         ds_source = W_CacheLumpNum(firstflat + flattranslation[pl->picnum]);
+static void R_DrawFlatColumns(planestate_t *ps, const visplane_t *pl,
+                              int start, int stop)
+{
+   register int x;
+   int light;
 
-         xoffs = pl->xoffs;  // killough 2/28/98: Add offsets
-         yoffs = pl->yoffs;
-         planeheight = D_abs(pl->height-viewz);
-         light = (pl->lightlevel >> LIGHTSEGSHIFT) + extralight;
+   ps->dsvars.source = pl->source;
 
-         if (light >= LIGHTLEVELS)
-            light = LIGHTLEVELS-1;
+   ps->xoffs = pl->xoffs;  // killough 2/28/98: Add offsets
+   ps->yoffs = pl->yoffs;
+   ps->planeheight = D_abs(pl->height-viewz);
+   light = (pl->lightlevel >> LIGHTSEGSHIFT) + extralight;
 
-         if (light < 0)
-            light = 0;
+   if (light >= LIGHTLEVELS)
+      light = LIGHTLEVELS-1;
 
-         stop = pl->maxx + 1;
-         planezlight = zlight[light];
-         pl->top[pl->minx-1] = pl->top[stop] = 0xffff;
+   if (light < 0)
+      light = 0;
 
-         for (x = pl->minx ; x <= stop ; x++)
-            R_MakeSpans(x,pl->top[x-1],pl->bottom[x-1],pl->top[x],pl->bottom[x]);
+   ps->planezlight = zlight[light];
 
-         W_UnlockLumpNum(firstflat + flattranslation[pl->picnum]);
-      }
+   // An empty column before start and after stop closes all spans there,
+   // like the pads around top[] used to for the whole plane
+   R_MakeSpans(ps, start, 0xffff, 0, pl->top[start], pl->bottom[start]);
+   for (x = start+1 ; x <= stop ; x++)
+      R_MakeSpans(ps, x, pl->top[x-1], pl->bottom[x-1], pl->top[x], pl->bottom[x]);
+   R_MakeSpans(ps, stop+1, pl->top[stop], pl->bottom[stop], 0xffff, 0);
+}
+
+// Draws what lies between columns start and stop of all flats
+
+static void R_DrawFlats(planestate_t *ps, int start, int stop)
+{
+   const visplane_t *pl;
+   int i;
+   for (i=0;i<MAXVISPLANES;i++)
+      for (pl=visplanes[i]; pl; pl=pl->next)
+         if (pl->minx <= pl->maxx && !R_IsSkyPlane(pl))
+         {
+            int x1 = MAX(pl->minx, start), x2 = MIN(pl->maxx, stop);
+            if (x1 <= x2)
+               R_DrawFlatColumns(ps, pl, x1, x2);
+         }
+}
+
+#ifdef PLANES_ON_COP
+static void R_PlaneCopThread(void)
+{
+   while (1)
+   {
+      rb->semaphore_wait(&cop_start, TIMEOUT_BLOCK);
+      rb->commit_discard_dcache(); /* see what the CPU left for us */
+      if (cop_planes.quit)
+         break;
+
+      R_DrawFlats(&cop_planes.ps, 0, cop_planes.stop);
+
+      rb->commit_discard_dcache(); /* and hand our pixels over */
+      rb->semaphore_release(&cop_done);
    }
 }
 
+// Returns the first column the CPU draws, or 0 if the COP can't help.
+// No cache line of the screen may hold pixels of both halves.
+
+static int R_PlaneSplit(void)
+{
+   int split = (viewwidth/2) & ~(CACHEALIGN_SIZE-1);
+
+   if (!cop_thread_id || split <= 0 ||
+       (((uintptr_t)topleft | SCREENWIDTH) & (CACHEALIGN_SIZE-1)))
+      return 0;
+
+   return split;
+}
+#endif
+
+//
+// R_InitPlanes
+// Only at game startup.
+//
+void R_InitPlanes (void)
+{
+#ifdef PLANES_ON_COP
+   if (cop_thread_id)
+      return;
+
+   rb->semaphore_init(&cop_start, 1, 0);
+   rb->semaphore_init(&cop_done, 1, 0);
+   cop_planes.quit = false;
+   rb->commit_discard_dcache();
+
+   cop_thread_id = rb->create_thread(R_PlaneCopThread, cop_stack,
+                       sizeof(cop_stack), 0, "doom planes"
+                       IF_PRIO(, PRIORITY_USER_INTERFACE) IF_COP(, COP));
+#endif
+}
+
+//
+// R_ShutdownPlanes
+// Stops the COP again, safe to call more than once.
+//
+void R_ShutdownPlanes (void)
+{
+#ifdef PLANES_ON_COP
+   if (!cop_thread_id)
+      return;
+
+   cop_planes.quit = true;
+   rb->commit_discard_dcache();
+   rb->semaphore_release(&cop_start);
+   rb->thread_wait(cop_thread_id);
+   rb->commit_discard_dcache();
+   cop_thread_id = 0;
+#endif
+}
+
+// How many cores drew the flats of the last frame
+int R_PlaneCores (void)
+{
+   return planecores;
+}
+
 //
 // RDrawPlanes
 // At the end of each frame.
@@ -436,7 +567,45 @@ void R_DrawPlanes (void)
 {
    visplane_t *pl;
    int i;
+   int split = 0;
+
+   // Skies first, they use the column drawer and its globals. Planes
+   // don't overlap, so the order doesn't matter. All flats get locked
+   // up front, the zone mustn't change while the COP draws from it.
+   for (i=0;i<MAXVISPLANES;i++)
+      for (pl=visplanes[i]; pl; pl=pl->next)
+         if (pl->minx <= pl->maxx)
+         {
+            if (R_IsSkyPlane(pl))
+               R_DrawSkyPlane(pl);
+            else
+               pl->source = W_CacheLumpNum(R_FlatLump(pl));
+         }
+
+#ifdef PLANES_ON_COP
+   split = R_PlaneSplit();
+   if (split)
+   {
+      cop_planes.stop = split-1;
+      rb->commit_discard_dcache();
+      rb->semaphore_release(&cop_start);
+   }
+#endif
+
+   R_DrawFlats(&planestate, split, viewwidth-1);
+
+#ifdef PLANES_ON_COP
+   if (split)
+   {
+      rb->semaphore_wait(&cop_done, TIMEOUT_BLOCK);
+      rb->commit_discard_dcache();
+   }
+#endif
+
+   planecores = split ? 2 : 1;
+
    for (i=0;i<MAXVISPLANES;i++)
       for (pl=visplanes[i]; pl; pl=pl->next)
-         R_DoDrawPlane(pl);
+         if (pl->minx <= pl->maxx && !R_IsSkyPlane(pl))
+            W_UnlockLumpNum(R_FlatLump(pl));
 }
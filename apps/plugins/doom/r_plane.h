@@ -48,6 +48,8 @@ extern short floorclip[], ceilingclip[];
 extern fixed_t yslope[], distscale[];
 
 void R_InitPlanes(void);
+void R_ShutdownPlanes(void);
+int R_PlaneCores(void);
 void R_ClearPlanes(void);
 void R_DrawPlanes (void);
 
@@ -261,11 +261,14 @@ bool Dhandle_ver (int dver)
          return 0;
    }
    // Start adding to myargv
-   if(argvlist.timedemo && (gamemode == shareware))
+   // Every IWAD has a demo3, a demo picked from the demos directory
+   // below gets timed instead
+   if(argvlist.timedemo)
    {
          singletics = true;
          timingdemo = true;            // show stats after quit
-         G_DeferedPlayDemo("demo3");
+         if(!argvlist.demonum)
+            G_DeferedPlayDemo("demo3");
          singledemo = true;            // quit after one demo
    }
 
@@ -140,15 +140,9 @@ static const char *png_error_messages[PNG_ERROR_MAX-PNG_ERROR_MIN+1] =
 };
 
 /*
-The two functions below (LodePNG_decompress and LodePNG_compress) directly call the
-LodeZlib_decompress and LodeZlib_compress functions. The only purpose of the functions
-below, is to provide the ability to let LodePNG use a different Zlib encoder by only
-changing the two functions below, instead of changing it inside the vareous places
-in the other LodePNG functions.
-
-*out must be NULL and *outsize must be 0 initially, and after the function is done,
-*out must point to the decompressed data, *outsize must be the size of it, and must
-be the size of the useful data in bytes, not the alloc size.
+LodePNG_decompress inflates the zlib stream in 'in' into 'out' using the core
+inflate implementation. On entry *outsize is the space available at 'out', on
+return it is the size of the decompressed data.
 */
 
 static unsigned LodePNG_decompress(unsigned char* out,
@@ -156,12 +150,35 @@ static unsigned LodePNG_decompress(unsigned char* out,
                                    const unsigned char* in,
                                    size_t insize)
 {
+    /* the inflate state lives at the tail of the output area; it is
+     * only needed until the stream ends */
+    size_t state_size = *rb->inflate_size + *rb->inflate_align - 1;
+    void *state;
     int err;
-    err = tinf_zlib_uncompress((void *)out,
-                               (unsigned int*)outsize,
-                               (const void*)in,
-                               (unsigned int)insize);
-    return err;
+
+    if (*outsize < state_size)
+        return OUT_OF_MEMORY;
+
+    state = out + *outsize - state_size;
+    ALIGN_BUFFER(state, state_size, *rb->inflate_align);
+
+    struct inflate_bufferctx rctx = {
+        .buf = (void *)in,
+        .end = (void *)(in + insize),
+    };
+    struct inflate_bufferctx wctx = {
+        .buf = out,
+        .end = state,
+    };
+
+    err = rb->inflate(state, INFLATE_ZLIB,
+                      rb->inflate_buffer_reader, &rctx,
+                      rb->inflate_buffer_writer, &wctx);
+    if (err)
+        return (wctx.buf == wctx.end) ? OUT_OF_MEMORY : TINF_DATA_ERROR;
+
+    *outsize = (unsigned char *)wctx.buf - out;
+    return 0;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
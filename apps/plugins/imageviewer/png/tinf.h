@@ -37,6 +37,8 @@
 /* removed from original file:
  * tinf_gzip_uncompress() prototype
  * tinf_init() prototype
+ * tinf_uncompress(), tinf_zlib_uncompress() and tinf_adler32() prototypes;
+ * decompression is done by the core inflate
  */
 
 #ifndef TINF_H_INCLUDED
@@ -60,14 +62,6 @@ extern "C" {
 
 /* function prototypes */
 
-int TINFCC tinf_uncompress(void *dest, unsigned int *destLen,
-                           const void *source, unsigned int sourceLen);
-
-int TINFCC tinf_zlib_uncompress(void *dest, unsigned int *destLen,
-                                const void *source, unsigned int sourceLen);
-
-unsigned int TINFCC tinf_adler32(const void *data, unsigned int length);
-
 unsigned int TINFCC tinf_crc32(const void *data, unsigned int length);
 
 #ifdef __cplusplus
@@ -958,6 +958,17 @@ LUA_API int lua_gc (lua_State *L, int what, int data) {
       g->gcstepmul = data;
       break;
     }
+    case LUA_GCIDLE: {  /* rocklua: collect while there's time to spare */
+      long deadline = *rb->current_tick + data;
+      while (TIME_BEFORE(*rb->current_tick, deadline)) {
+        if (!luaC_idlestep(L)) {
+          res = 1;  /* nothing left to do */
+          break;
+        }
+        yield();
+      }
+      break;
+    }
     default: res = -1;  /* invalid option */
   }
   lua_unlock(L);
@@ -763,27 +763,23 @@ LUALIB_API int (luaL_loadstring) (lua_State *L, const char *s) {
 /* }====================================================== */
 
 
+extern void *rock_realloc(void *ptr, size_t osize, size_t nsize); /* tlsf_helper.c */
+
 static void *l_alloc (void *ud, void *ptr, size_t osize, size_t nsize) {
-  (void) osize;
   lua_State *L = (lua_State *)ud;
   void *nptr;
 
-  if (nsize == 0) {
-    free(ptr);
-    return NULL;
-  }
-
-  nptr = realloc(ptr, nsize);
-  if (nptr == NULL) {
+  nptr = rock_realloc(ptr, osize, nsize);
+  if (nptr == NULL && nsize != 0) {
     if(L != NULL)
     {
       luaC_fullgc(L); /* emergency full collection. */
-      nptr = realloc(ptr, nsize); /* try allocation again */
+      nptr = rock_realloc(ptr, osize, nsize); /* try allocation again */
     }
 
     if (nptr == NULL) {
       LUA_OOM(L); /* if defined.. signal OOM condition */
-      nptr = realloc(ptr, nsize); /* try allocation again */
+      nptr = rock_realloc(ptr, osize, nsize); /* try allocation again */
     }
   }
 
@@ -201,9 +201,9 @@ static int luaB_gcinfo (lua_State *L) {
 
 static int luaB_collectgarbage (lua_State *L) {
   static const char *const opts[] = {"stop", "restart", "collect",
-    "count", "step", "setpause", "setstepmul", NULL};
+    "count", "step", "setpause", "setstepmul", "idle", NULL};
   static const int optsnum[] = {LUA_GCSTOP, LUA_GCRESTART, LUA_GCCOLLECT,
-    LUA_GCCOUNT, LUA_GCSTEP, LUA_GCSETPAUSE, LUA_GCSETSTEPMUL};
+    LUA_GCCOUNT, LUA_GCSTEP, LUA_GCSETPAUSE, LUA_GCSETSTEPMUL, LUA_GCIDLE};
   int o = luaL_checkoption(L, 1, "collect", opts);
   int ex = luaL_optint(L, 2, 0);
   int res = lua_gc(L, optsnum[o], ex);
@@ -213,7 +213,8 @@ static int luaB_collectgarbage (lua_State *L) {
       lua_pushnumber(L, res + ((lua_Number)b/1024));
       return 1;
     }
-    case LUA_GCSTEP: {
+    case LUA_GCSTEP:
+    case LUA_GCIDLE: {
       lua_pushboolean(L, res);
       return 1;
     }
@@ -652,6 +652,25 @@ void luaC_step (lua_State *L) {
 }
 
 
+/*
+** rocklua: one step of collector work done ahead of time, while the
+** script is idle anyway. Only a cycle that is running or about to be due
+** gets worked on, an idle script shouldn't keep collecting for nothing.
+** Returns 0 when there's nothing to do (right now).
+*/
+int luaC_idlestep (lua_State *L) {
+  global_State *g = G(L);
+  if (is_block_gc(L))
+    return 0;
+  if (g->gcstate == GCSpause &&
+      g->totalbytes < g->GCthreshold - (g->GCthreshold - g->estimate) / 2)
+    return 0;  /* less than halfway to the next cycle */
+  g->GCthreshold = g->totalbytes;  /* no debt, just the step */
+  luaC_step(L);
+  return g->gcstate != GCSpause;
+}
+
+
 int luaC_sweepstrgc (lua_State *L) {
   global_State *g = G(L);
   if (g->gcstate == GCSsweepstring) {
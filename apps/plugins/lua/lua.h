@@ -229,6 +229,7 @@ LUA_API int  (lua_status) (lua_State *L);
 #define LUA_GCSTEP		5
 #define LUA_GCSETPAUSE		6
 #define LUA_GCSETSTEPMUL	7
+#define LUA_GCIDLE		8	/* rocklua: steps for up to 'data' ticks */
 
 LUA_API int (lua_gc) (lua_State *L, int what, int data);
 
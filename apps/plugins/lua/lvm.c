@@ -462,7 +462,17 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         continue;
       }
       case OP_GETTABLE: {
-        Protect(luaV_gettable(L, RB(i), RKC(i), ra));
+        TValue *rb = RB(i);
+        TValue *rc = RKC(i);
+        if (ttistable(rb) && ttisnumber(rc)) {  /* array part fast path */
+          Table *h = hvalue(rb);
+          unsigned int k = cast(unsigned int, nvalue(rc)) - 1;
+          if (k < cast(unsigned int, h->sizearray) && !ttisnil(&h->array[k])) {
+            setobj2s(L, ra, &h->array[k]);
+            continue;
+          }
+        }
+        Protect(luaV_gettable(L, rb, rc, ra));
         continue;
       }
       case OP_SETGLOBAL: {
@@ -479,7 +489,20 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         continue;
       }
       case OP_SETTABLE: {
-        Protect(luaV_settable(L, ra, RKB(i), RKC(i)));
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttistable(ra) && ttisnumber(rb)) {  /* array part fast path */
+          Table *h = hvalue(ra);
+          unsigned int k = cast(unsigned int, nvalue(rb)) - 1;
+          if (k < cast(unsigned int, h->sizearray) &&
+              (!ttisnil(&h->array[k]) || h->metatable == NULL)) {
+            setobj2t(L, &h->array[k], rc);
+            h->flags = 0;
+            luaC_barriert(L, h, rc);
+            continue;
+          }
+        }
+        Protect(luaV_settable(L, ra, rb, rc));
         continue;
       }
       case OP_NEWTABLE: {
@@ -596,7 +619,11 @@ void luaV_execute (lua_State *L, int nexeccalls) {
       case OP_EQ: {
         TValue *rb = RKB(i);
         TValue *rc = RKC(i);
-        Protect(
+        if (ttisnumber(rb) && ttisnumber(rc)) {  /* loop conditions */
+          if (luai_numeq(nvalue(rb), nvalue(rc)) == GETARG_A(i))
+            dojump(L, pc, GETARG_sBx(*pc));
+        }
+        else Protect(
           if (equalobj(L, rb, rc) == GETARG_A(i))
             dojump(L, pc, GETARG_sBx(*pc));
         )
@@ -604,16 +631,28 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         continue;
       }
       case OP_LT: {
-        Protect(
-          if (luaV_lessthan(L, RKB(i), RKC(i)) == GETARG_A(i))
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttisnumber(rb) && ttisnumber(rc)) {
+          if (luai_numlt(nvalue(rb), nvalue(rc)) == GETARG_A(i))
+            dojump(L, pc, GETARG_sBx(*pc));
+        }
+        else Protect(
+          if (luaV_lessthan(L, rb, rc) == GETARG_A(i))
             dojump(L, pc, GETARG_sBx(*pc));
         )
         pc++;
         continue;
       }
       case OP_LE: {
-        Protect(
-          if (lessequal(L, RKB(i), RKC(i)) == GETARG_A(i))
+        TValue *rb = RKB(i);
+        TValue *rc = RKC(i);
+        if (ttisnumber(rb) && ttisnumber(rc)) {
+          if (luai_numle(nvalue(rb), nvalue(rc)) == GETARG_A(i))
+            dojump(L, pc, GETARG_sBx(*pc));
+        }
+        else Protect(
+          if (lessequal(L, rb, rc) == GETARG_A(i))
             dojump(L, pc, GETARG_sBx(*pc));
         )
         pc++;
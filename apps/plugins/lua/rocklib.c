@@ -83,7 +83,12 @@ RB_WRAP(schedule_cpu_boost)
 RB_WRAP(sleep)
 {
     unsigned ticks = (unsigned) lua_tonumber(L, 1);
-    rb->sleep(ticks);
+    long deadline = *rb->current_tick + ticks;
+    /* scripts sleep once per frame, spend that time on garbage collection
+       rather than pausing for it in the middle of the next frame */
+    lua_gc(L, LUA_GCIDLE, ticks);
+    ticks = deadline - *rb->current_tick;
+    rb->sleep((long) ticks > 0 ? ticks : 0);
     return 0;
 }
 
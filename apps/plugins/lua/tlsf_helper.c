@@ -98,3 +98,103 @@ void *get_new_area(size_t *size)
     *size = 0;
     return ((void *) ~0u);
 }
+
+/* Small object arena
+ *
+ * Most of what Lua allocates are small objects of a few sizes: strings,
+ * tables, closures, upvalues. Those are served from per-size free lists
+ * carved out of one block taken from tlsf, which is quicker than tlsf and
+ * saves its per-block overhead. Lua always passes the size of a block it
+ * frees or resizes, so arena blocks need no header. Once the arena is used
+ * up, small objects come from tlsf again.
+ */
+#define ARENA_GRAIN     8
+#define ARENA_CLASSES   8                  /* 8 .. 64 bytes */
+#define ARENA_MAXOBJ    (ARENA_GRAIN * ARENA_CLASSES)
+#define ARENA_MAXSIZE   (64 * 1024)        /* and an 8th of the plugin buffer */
+#define ARENA_CLASS(n)  (((n) - 1) / ARENA_GRAIN)
+
+static struct
+{
+    char *start, *top, *end;
+    void *free[ARENA_CLASSES];
+} arena;
+
+static void arena_init(void)
+{
+    size_t size = MIN(pluginbuf_size / 8, ARENA_MAXSIZE) & ~(ARENA_GRAIN - 1);
+
+    arena.start = tlsf_malloc(size);
+    if (arena.start == NULL)
+        arena.start = (char *) ~0u; /* don't try again */
+    else
+        arena.end = arena.start + size;
+    arena.top = arena.start;
+}
+
+static void *arena_alloc(size_t size)
+{
+    int c = ARENA_CLASS(size);
+    void *p = arena.free[c];
+
+    if (p)
+        arena.free[c] = *(void **) p;
+    else if ((size_t) (arena.end - arena.top) >= (size_t) (c + 1) * ARENA_GRAIN)
+    {
+        p = arena.top;
+        arena.top += (c + 1) * ARENA_GRAIN;
+    }
+
+    return p;
+}
+
+static void arena_free(void *p, size_t size)
+{
+    int c = ARENA_CLASS(size);
+    *(void **) p = arena.free[c];
+    arena.free[c] = p;
+}
+
+/* lua_Alloc semantics, minus the emergency collection done in l_alloc */
+void *rock_realloc(void *ptr, size_t osize, size_t nsize)
+{
+    void *nptr;
+
+    if (ptr != NULL && (char *) ptr >= arena.start && (char *) ptr < arena.end)
+    {
+        if (nsize == 0)
+        {
+            arena_free(ptr, osize);
+            return NULL;
+        }
+
+        if (nsize <= ARENA_MAXOBJ && ARENA_CLASS(nsize) == ARENA_CLASS(osize))
+            return ptr;
+
+        nptr = rock_realloc(NULL, 0, nsize);
+        if (nptr != NULL)
+        {
+            memcpy(nptr, ptr, MIN(osize, nsize));
+            arena_free(ptr, osize);
+        }
+        return nptr;
+    }
+
+    if (nsize == 0)
+    {
+        tlsf_free(ptr);
+        return NULL;
+    }
+
+    if (ptr == NULL && nsize <= ARENA_MAXOBJ)
+    {
+        /* set up once tlsf has claimed the plugin buffer */
+        if (arena.start == NULL && pluginbuf_size != 0)
+            arena_init();
+
+        if (arena.end != NULL && (nptr = arena_alloc(nsize)) != NULL)
+            return nptr;
+    }
+
+    return tlsf_realloc(ptr, nsize);
+}
@@ -0,0 +1,137 @@
+--[[
+             __________               __   ___.
+   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+                     \/            \/     \/    \/            \/
+ $Id$
+ Lua VM Benchmark
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+ This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ KIND, either express or implied.
+]]--
+
+-- Times the things scripts spend most of their time on: loops, tables,
+-- strings and garbage. Results are shown and written to /lua_bench.txt,
+-- run it before and after a change on the same device to compare.
+
+local N = 100000
+local filename = "/lua_bench.txt"
+
+local function for_loop()
+    local s = 0
+    for i = 1, N * 4 do s = s + i end
+    return s
+end
+
+local function while_loop()
+    local i, s = 0, 0
+    while i < N * 4 do i = i + 1; s = s + i end
+    return s
+end
+
+local function array_part()
+    local t, s = {}, 0
+    for i = 1, N do t[i] = i end
+    for r = 1, 3 do
+        for i = 1, #t do s = s + t[i] end
+        for i = 1, #t do t[i] = t[i] + r end
+    end
+    return s
+end
+
+local function hash_part()
+    local t, s = {}, 0
+    local keys = {}
+    for i = 1, 256 do keys[i] = "key" .. i end
+    for i = 1, N do
+        local k = keys[i % 256 + 1]
+        t[k] = (t[k] or 0) + i
+    end
+    for _, v in pairs(t) do s = s + v end
+    return s
+end
+
+local function strings()
+    local parts = {}
+    for i = 1, N / 10 do
+        parts[#parts + 1] = string.format("%d:%s", i, tostring(i * 3))
+    end
+    return #table.concat(parts, ",")
+end
+
+local function closures()
+    local s = 0
+    for i = 1, N / 2 do
+        local f = function(x) return x + i end
+        local t = {i, i + 1}
+        s = s + f(t[2])
+    end
+    return s
+end
+
+-- a script's main loop: some garbage per frame, then sleep till the next
+-- one. The worst frame shows how long the collector held things up.
+local function frames()
+    local worst, total = 0, 0
+    local keep = {}
+    for frame = 1, 100 do
+        local start = rb.current_tick()
+        for i = 1, 200 do
+            keep[(frame * 200 + i) % 2000 + 1] = {frame, i, "f" .. i}
+        end
+        local took = rb.current_tick() - start
+        total = total + took
+        if took > worst then worst = took end
+        rb.sleep(1)
+    end
+    return total, worst
+end
+
+local tests = {
+    {"for loop",   for_loop},
+    {"while loop", while_loop},
+    {"array part", array_part},
+    {"hash part",  hash_part},
+    {"strings",    strings},
+    {"closures",   closures},
+}
+
+local function ms(ticks)
+    return ticks * 1000 / rb.HZ
+end
+
+local results = {"Lua benchmark (ms):\n"}
+
+rb.splash(0, "Running benchmark...")
+collectgarbage("collect")
+
+local overall = 0
+for _, test in ipairs(tests) do
+    local start = rb.current_tick()
+    test[2]()
+    local took = rb.current_tick() - start
+    overall = overall + took
+    results[#results + 1] = string.format("%-12s %6d\n", test[1], ms(took))
+end
+results[#results + 1] = string.format("%-12s %6d\n", "total", ms(overall))
+
+local total, worst = frames()
+results[#results + 1] = string.format("\n100 frames: %d, worst %d\n",
+                                      ms(total), ms(worst))
+results[#results + 1] = string.format("Lua heap: %d Kb\n",
+                                      collectgarbage("count"))
+
+local report = table.concat(results)
+
+local file = io.open(filename, "w+") -- overwrite
+if file then
+    file:write(report)
+    file:close()
+end
+
+rb.splash_scroller(10 * rb.HZ, report)
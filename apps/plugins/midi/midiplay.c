@@ -384,6 +384,10 @@ static int32_t gmbuf[BUF_SIZE] ALIGNED_ATTR(4);
 
 static volatile size_t samples_in_buf;
 
+/* time spent synthesizing, against the samples it produced */
+static long synth_ticks;
+static long synth_samples;
+
 static volatile bool midi_end = false;
 static volatile bool quit = false;
 
@@ -410,12 +414,14 @@ static inline void synthbuf(void)
 #if defined(HAVE_ADJUSTABLE_CPU_FREQ)
     rb->cpu_boost(true);
 #endif
+    long start_tick = *rb->current_tick;
     /* synth samples for as many whole ticks as we can fit in the buffer */
     while (available > 0)
     {
         if ((dst.remcount <= 0) && !midi_end)
         {
             int nsamples = synthSamples(samp_buf, number_of_samples);
+            synth_samples += nsamples;
             if (nsamples < number_of_samples)
                 number_of_samples -= nsamples;
             else if (!tick())
@@ -438,6 +444,8 @@ static inline void synthbuf(void)
             break;
     }
 
+    synth_ticks += *rb->current_tick - start_tick;
+
     /* how many samples did we write to the buffer? */
     samples_in_buf = BUF_SIZE - available;
 #ifndef SYNC
@@ -474,7 +482,162 @@ static void get_more(const void** start, size_t* size)
     *size = samples_in_buf*sizeof(int32_t);
 }
 
-static int midimain(const void * filename)
+#define POLYPHONY_LOG HOME_DIR "/midi_polyphony.txt"
+#define BENCH_SECONDS 2
+
+static int log_fd = -1;
+
+/* A line on the screen, and in the log when it is open */
+static void report(const char *fmt, ...)
+{
+    char buf[50];
+    va_list ap;
+
+    va_start(ap, fmt);
+    rb->vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    midi_debug("%s", buf);
+
+    if (log_fd >= 0)
+        rb->fdprintf(log_fd, "%s\n", buf);
+}
+
+/*
+ * The synth's cost grows with the number of voices, so the share of real
+ * time it took for the voices it had to play tells how many it could
+ * keep up with. That includes the DSP, so it errs on the safe side.
+ */
+static void report_polyphony(void)
+{
+    long audio_ticks = synth_samples / (SAMPLE_RATE / HZ);
+
+    if (audio_ticks < HZ || synth_ticks <= 0)
+        return; /* too short to tell */
+
+    /* in 1/10 voices */
+    long avg_voices = voice_samples_rendered * 10 / synth_samples;
+
+    report("Voices: %d max, %ld.%ld avg, %d used at most",
+           MAX_VOICES, avg_voices / 10, avg_voices % 10, peak_voices_used);
+    report("CPU load %ld%%, sustains ~%ld voices",
+           synth_ticks * 100 / audio_ticks,
+           avg_voices * audio_ticks / synth_ticks / 10);
+}
+
+/*
+ * Renders BENCH_SECONDS of held notes through the synth and the DSP, with
+ * one more voice each time, until that takes longer than real time or all
+ * the voices are playing.
+ */
+static void bench_polyphony(void)
+{
+    long const audio_ticks = BENCH_SECONDS * HZ;
+    int a, count, sustained = 0;
+
+    for (a = 0; a < MAX_VOICES; a++)
+        voices[a].isUsed = false;
+
+    rb->dsp_configure(dsp, DSP_FLUSH, 0);
+    report("Benchmark, %d s per step", BENCH_SECONDS);
+
+#if defined(HAVE_ADJUSTABLE_CPU_FREQ)
+    rb->cpu_boost(true);
+#endif
+    for (count = 1; count <= MAX_VOICES; count++)
+    {
+        long samples = 0;
+        long start_tick = *rb->current_tick;
+
+        while (samples < BENCH_SECONDS * SAMPLE_RATE)
+        {
+            if (!holdNotes(count))
+                break;
+
+            src.remcount = synthSamples(samp_buf, MAX_SAMPLES);
+            src.pin[0]    = &samp_buf[0];
+            src.pin[1]    = &samp_buf[1];
+            src.proc_mask = 0;
+            samples += src.remcount;
+
+            while (src.remcount > 0)
+            {
+                dst.remcount = 0;
+                dst.bufcount = BUF_SIZE;
+                dst.p16out = (int16_t *)gmbuf;
+                rb->dsp_process(dsp, &src, &dst);
+                if (dst.remcount <= 0)
+                    break;
+            }
+
+            rb->yield();
+        }
+
+        if (samples < BENCH_SECONDS * SAMPLE_RATE)
+        {
+            report("No melodic patch to play");
+            break;
+        }
+
+        long ticks = *rb->current_tick - start_tick;
+
+        report("%2d voices: %3ld%% CPU", count, ticks * 100 / audio_ticks);
+
+        if (ticks > audio_ticks)
+            break;
+
+        sustained = count;
+    }
+#if defined(HAVE_ADJUSTABLE_CPU_FREQ)
+    rb->cpu_boost(false);
+#endif
+
+    for (a = 0; a < MAX_VOICES; a++)
+        voices[a].isUsed = false;
+
+    if (sustained == MAX_VOICES)
+        report("Keeps up with all %d voices", MAX_VOICES);
+    else
+        report("Keeps up with %d voices", sustained);
+}
+
+static int wait_for_key(void)
+{
+    int button;
+
+    do
+        button = rb->button_get(true);
+    while (button & (BUTTON_REL | BUTTON_REPEAT));
+
+    return button;
+}
+
+/*
+ * The end of the benchmark mode: reports how the playback went, runs the
+ * benchmark and appends both to POLYPHONY_LOG, then waits for a key.
+ */
+static void show_polyphony(const char *filename)
+{
+    log_fd = rb->open(POLYPHONY_LOG, O_WRONLY | O_CREAT | O_APPEND, 0666);
+
+    if (log_fd >= 0)
+        rb->fdprintf(log_fd, "%s\n", filename);
+
+    report_polyphony();
+    bench_polyphony();
+
+    if (log_fd >= 0)
+    {
+        rb->close(log_fd);
+        log_fd = -1;
+    }
+
+    midi_debug("Press any key");
+    rb->button_clear_queue();
+    wait_for_key();
+}
+
+static int midimain(const void * filename, bool bench)
 {
     int a, notes_used, vol;
     bool is_playing = true;  /* false = paused */
@@ -503,6 +666,9 @@ static int midimain(const void * filename)
         return -1;
     }
 
+    startSynthThread();
+    atexit(stopSynthThread);
+
     rb->talk_force_shutup();
     rb->pcm_play_stop();
 #if INPUT_SRC_CAPS != 0
@@ -670,17 +836,57 @@ static int midimain(const void * filename)
     rb->pcmbuf_fade(false, false);
     rb->mixer_channel_stop(PCM_MIXER_CHAN_PLAYBACK);
 
+    if (bench)
+        show_polyphony(filename);
+    stopSynthThread();
+
     return 0;
 }
 
+/* Started without a file: play one, or play one as the polyphony
+ * benchmark. Returns false to quit. */
+static bool start_menu(char *filename, size_t size, bool *bench)
+{
+    MENUITEM_STRINGLIST(menu, "MIDI Player", NULL,
+                        "Play .MID file", "Polyphony benchmark", "Quit");
+    int selection = 0;
+
+    switch (rb->do_menu(&menu, &selection, NULL, false))
+    {
+        case 0:
+        case 1:
+            break;
+        default:
+            return false;
+    }
+
+    struct browse_context browse = {
+        .dirfilter = SHOW_ALL,
+        .flags = BROWSE_SELECTONLY | BROWSE_NO_CONTEXT_MENU,
+        .title = "Select a MIDI file",
+        .icon = Icon_Audio,
+        .root = "/",
+        .buf = filename,
+        .bufsize = size,
+    };
+
+    rb->rockbox_browse(&browse);
+
+    *bench = (selection == 1);
+    return (browse.flags & BROWSE_SELECTED);
+}
+
 enum plugin_status plugin_start(const void* parameter)
 {
+    static char filename[MAX_PATH];
+    bool bench = false;
     int retval;
 
     if (parameter == NULL)
     {
-        rb->splash(HZ*2, " Play .MID file ");
-        return PLUGIN_OK;
+        if (!start_menu(filename, sizeof(filename), &bench))
+            return PLUGIN_OK;
+        parameter = filename;
     }
     rb->lcd_setfont(FONT_SYSFIXED);
 
@@ -691,7 +897,7 @@ enum plugin_status plugin_start(const void* parameter)
     rb->profile_thread();
 #endif
 
-    retval = midimain(parameter);
+    retval = midimain(parameter, bench);
 
 #ifdef RB_PROFILE
     rb->profstop();
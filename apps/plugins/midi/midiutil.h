@@ -45,7 +45,14 @@
    mainly because they have to use 44100Hz sample rate, this could be
    improved to increase MAX_VOICES for targets that can do 22kHz */
 #define SAMPLE_RATE HW_SAMPR_MIN_GE_22
+#if NUM_CORES > 1 && defined(HAVE_SEMAPHORE_OBJECTS)
+/* the COP renders half of the voices, see synth.c */
 #if HW_SAMPR_CAPS & SAMPR_CAP_22
+#define MAX_VOICES 32
+#else
+#define MAX_VOICES 24 /* General MIDI minimum */
+#endif
+#elif HW_SAMPR_CAPS & SAMPR_CAP_22
 #define MAX_VOICES 24 /* General MIDI minimum */
 #else
 #define MAX_VOICES 16
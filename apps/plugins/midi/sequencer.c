@@ -279,6 +279,64 @@ static inline void pressNote(int ch, int note, int vol)
     }
 }
 
+/*
+ * Keeps count voices sounding, restarting the ones that ended, for the
+ * polyphony benchmark. The notes go to the melodic channels in turn, each
+ * playing one of the patches the file loaded. Returns false when there is
+ * no melodic patch to play.
+ */
+bool holdNotes(int count)
+{
+    int a, i, used = 0;
+
+    for (a = 0; a < MAX_VOICES; a++)
+        if (voices[a].isUsed)
+            used++;
+
+    if (used >= count)
+        return true;
+
+    for (i = 0; i < count; i++)
+    {
+        int ch = i % 15;
+        int note = 48 + i / 15;
+
+        if (ch >= 9)
+            ch++; /* skip the drums */
+
+        for (a = 0; a < MAX_VOICES; a++)
+            if (voices[a].isUsed && voices[a].ch == ch &&
+                voices[a].note == note)
+                break;
+
+        if (a < MAX_VOICES)
+            continue;
+
+        if (patchSet[chPat[ch]] == NULL)
+        {
+            /* any loaded patch, looking from a different one on each
+               channel */
+            int pat = 0, tries;
+
+            for (tries = 0; tries < 128; tries++)
+            {
+                pat = (ch * 8 + tries) & 127;
+                if (patchSet[pat] != NULL)
+                    break;
+            }
+
+            if (tries == 128)
+                return false;
+
+            chPat[ch] = pat;
+        }
+
+        pressNote(ch, note, 100);
+    }
+
+    return true;
+}
+
 static void releaseNote(int ch, int note)
 {
     if (ch == 9)
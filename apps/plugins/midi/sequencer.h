@@ -27,5 +27,8 @@ void rewindFile(void);
 void seekForward(int nSec);
 void seekBackward(int nSec);
 
+/* used by the polyphony benchmark */
+bool holdNotes(int count);
+
 extern long tempo;
 
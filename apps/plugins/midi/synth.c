@@ -258,6 +258,77 @@ void setPoint(struct SynthObject * so, int pt)
         so->curOffset = 0;
 }
 
+/*
+ * Number of samples from cp on that need none of the loop, overrun and
+ * ADSR handling below, so that synthVoice() can render them in one run.
+ * The position only moves one way until then. The envelope does too, or
+ * it swings around the sustain level, as it does for held notes. Returns
+ * the first envelope step in *env_step and in *env_flip what turns each
+ * step into the next one: step = flip - step.
+ */
+static inline unsigned int runLength(const struct SynthObject * so,
+                                     unsigned int cp, unsigned int limit,
+                                     unsigned int start_loop, bool looping,
+                                     int * env_step, int * env_flip)
+{
+    unsigned int run;
+    const int delta = so->delta;
+
+    if(so->curRate <= 0)
+        return 0;
+
+    if(delta > 0)
+    {
+        if(cp >= limit || (looping && cp < start_loop))
+            return 0;
+        run = (limit - 1 - cp) / delta;
+    }
+    else if(delta < 0 && looping)
+    {
+        /* ping-pong loop on its way back */
+        if(cp >= limit || cp < start_loop)
+            return 0;
+        run = (cp - start_loop) / -delta;
+    }
+    else
+        return 0;
+
+    if(so->ch == 9) /* no ADSR for drums */
+    {
+        *env_step = *env_flip = 0;
+        return run;
+    }
+
+    const int cur = so->curOffset, target = so->targetOffset;
+    const int rate = so->curRate;
+    unsigned int env;
+
+    if(cur < 0)
+        return 0;
+
+    if(cur < target)
+    {
+        *env_step = rate;
+        env = (target - cur) / rate;
+    }
+    else
+    {
+        *env_step = -rate;
+        env = (cur - MAX(target, 0)) / rate;
+    }
+    *env_flip = 2 * *env_step;
+
+    if(env == 0 && so->curPoint == 2 && cur - rate < target
+       && cur - (cur < target ? 0 : rate) >= 0)
+    {
+        /* sustaining: one step over the target and one step back */
+        *env_flip = 0;
+        return run;
+    }
+
+    return MIN(run, env);
+}
+
 static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned int samples)
 {
     struct GWaveform * wf;
@@ -285,8 +356,51 @@ static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned i
     bool rampdown = (so->state == STATE_RAMPDOWN);
     const bool ch_9 = (so->ch == 9);
 
-    while(LIKELY(samples-- > 0))
+    /* wherever the looping code below can kick in, a run has to stop */
+    const unsigned int run_limit = (mode_mask28 && end_loop < num_samples) ?
+                                   end_loop : num_samples;
+
+    while(LIKELY(samples > 0))
     {
+        if(LIKELY(!rampdown))
+        {
+            int env_step, env_flip;
+            unsigned int run = runLength(so, cp_temp, run_limit, start_loop,
+                mode_mask24 && so->loopState == STATE_LOOPING,
+                &env_step, &env_flip);
+            if(run > samples)
+                run = samples;
+
+            if(LIKELY(run > 0))
+            {
+                /* same as below, but nothing to check along the way */
+                const int delta = so->delta;
+                int env = so->curOffset;
+
+                samples -= run;
+                do
+                {
+                    cp_temp += delta;
+                    s1 = sample_data[cp_temp >> FRACTSIZE];
+                    s2 = sample_data[(cp_temp >> FRACTSIZE)+1];
+                    s1 +=((signed)((s2 - s1) * (cp_temp & ((1<<FRACTSIZE)-1)))>>FRACTSIZE);
+                    env += env_step;
+                    env_step = env_flip - env_step;
+                    s1 = s1 * (env >> 22) >> 8;
+                    s1 = s1 * volscale >> 14;
+                    s2 = s1 * pan;
+                    s1 = (s1 << 7) - s2;
+                    *(out++) += s1;
+                    *(out++) += s2;
+                } while(--run);
+                so->curOffset = env;
+                continue;
+            }
+        }
+
+        /* one sample at a time near loop points, envelope steps and the end */
+        samples--;
+
         /* Is voice being ramped? */
         if(UNLIKELY(rampdown))
         {
@@ -443,17 +557,147 @@ static inline void synthVoice(struct SynthObject * so, int32_t * out, unsigned i
     return;
 }
 
+/* for the polyphony report at the end of playback */
+uint64_t voice_samples_rendered;
+int peak_voices_used;
+
+#if NUM_CORES > 1 && defined(HAVE_SEMAPHORE_OBJECTS)
+/*
+ * The COP renders every other voice into a buffer of its own while the
+ * CPU does the rest, then the CPU mixes both. Caches aren't coherent, so
+ * the COP works on a copy of its voices which the CPU only touches after
+ * the COP is done, and both write back their caches before handing over.
+ */
+#define COP_VOICES (MAX_VOICES/2) /* the odd ones */
+#define COP_MIN_VOICES 4          /* not worth the handover below that */
+
+static struct cop_work
+{
+    struct SynthObject voices[COP_VOICES];
+    int32_t buf[MAX_SAMPLES * 2];
+    size_t nsamples;
+    bool quit;
+} CACHEALIGN_ATTR cop_work;
+
+static struct semaphore cop_start SHAREDBSS_ATTR;
+static struct semaphore cop_done SHAREDBSS_ATTR;
+static unsigned int cop_thread_id;
+static long cop_stack[CACHEALIGN_UP(DEFAULT_STACK_SIZE/sizeof(long))]
+                      CACHEALIGN_AT_LEAST_ATTR(4);
+
+static void synthCopThread(void)
+{
+    unsigned int i;
+
+    while(1)
+    {
+        rb->semaphore_wait(&cop_start, TIMEOUT_BLOCK);
+        rb->commit_discard_dcache(); /* see what the CPU left for us */
+        if(cop_work.quit)
+            break;
+
+        rb->memset(cop_work.buf, 0, cop_work.nsamples * 2 * sizeof(int32_t));
+        for(i=0; i < COP_VOICES; i++)
+        {
+            cop_work.voices[i] = voices[2*i + 1];
+            if(cop_work.voices[i].isUsed)
+                synthVoice(&cop_work.voices[i], cop_work.buf, cop_work.nsamples);
+        }
+
+        rb->commit_discard_dcache(); /* and hand our results over */
+        rb->semaphore_release(&cop_done);
+    }
+}
+
+void startSynthThread(void)
+{
+    if(cop_thread_id)
+        return;
+
+    rb->semaphore_init(&cop_start, 1, 0);
+    rb->semaphore_init(&cop_done, 1, 0);
+    cop_work.quit = false;
+    rb->commit_discard_dcache();
+
+    cop_thread_id = rb->create_thread(synthCopThread, cop_stack,
+                        sizeof(cop_stack), 0, "midi synth"
+                        IF_PRIO(, PRIORITY_PLAYBACK) IF_COP(, COP));
+}
+
+void stopSynthThread(void)
+{
+    if(!cop_thread_id)
+        return;
+
+    cop_work.quit = true;
+    rb->commit_discard_dcache();
+    rb->semaphore_release(&cop_start);
+    rb->thread_wait(cop_thread_id);
+    rb->commit_discard_dcache();
+    cop_thread_id = 0;
+}
+
+static void synthVoicesOnBothCores(int32_t *buf_ptr, size_t nsamples)
+{
+    unsigned int i;
+
+    cop_work.nsamples = nsamples;
+    rb->commit_discard_dcache();
+    rb->semaphore_release(&cop_start);
+
+    for(i=0; i < MAX_VOICES; i += 2)
+    {
+        if(voices[i].isUsed)
+            synthVoice(&voices[i], buf_ptr, nsamples);
+    }
+
+    rb->semaphore_wait(&cop_done, TIMEOUT_BLOCK);
+    rb->commit_discard_dcache();
+
+    for(i=0; i < COP_VOICES; i++)
+        voices[2*i + 1] = cop_work.voices[i];
+    for(i=0; i < nsamples * 2; i++)
+        buf_ptr[i] += cop_work.buf[i];
+}
+#else
+void startSynthThread(void)
+{
+}
+
+void stopSynthThread(void)
+{
+}
+#endif /* NUM_CORES > 1 */
+
 /* synth num_samples samples and write them to the */
 /* buffer pointed to by buf_ptr                    */
 size_t synthSamples(int32_t *buf_ptr, size_t num_samples) ICODE_ATTR;
 size_t synthSamples(int32_t *buf_ptr, size_t num_samples)
 {
     unsigned int i;
+    int used = 0;
     struct SynthObject *voicept;
     size_t nsamples = MIN(num_samples, MAX_SAMPLES);
 
     rb->memset(buf_ptr, 0, nsamples * 2 * sizeof(int32_t));
 
+    for(i=0; i < MAX_VOICES; i++)
+    {
+        if(voices[i].isUsed)
+            used++;
+    }
+    voice_samples_rendered += used * nsamples;
+    if(used > peak_voices_used)
+        peak_voices_used = used;
+
+#if NUM_CORES > 1 && defined(HAVE_SEMAPHORE_OBJECTS)
+    if(cop_thread_id && used >= COP_MIN_VOICES)
+    {
+        synthVoicesOnBothCores(buf_ptr, nsamples);
+        return nsamples;
+    }
+#endif
+
     for(i=0; i < MAX_VOICES; i++)
     {
         voicept=&voices[i];
@@ -21,6 +21,11 @@
 int initSynth(struct MIDIfile * mf, char * filename, char * drumConfig);
 void setPoint(struct SynthObject * so, int pt);
 size_t synthSamples(int32_t *buf_ptr, size_t num_samples);
+void startSynthThread(void);
+void stopSynthThread(void);
+
+extern uint64_t voice_samples_rendered;
+extern int peak_voices_used;
 
 void resetControllers(void);
 
@@ -53,7 +53,8 @@ static size_t audio_buffer_free;
 bool quit;
 int playingtime IBSS_ATTR;
 MODULE *module IBSS_ATTR;
-char gmbuf[BUF_SIZE*NBUF];
+/* 16 byte aligned for the SIMD output stage */
+char gmbuf[BUF_SIZE*NBUF] __attribute__((aligned(16)));
 
 
 int textlines;
@@ -510,6 +511,8 @@ static void applysettings(void)
     md_pansep = settings.pansep;
     md_reverb = settings.reverb;
     md_mode = DMODE_STEREO | DMODE_16BITS | DMODE_SOFT_MUSIC | DMODE_SOFT_SNDFX;
+    /* Only has an effect where the mixer was built with SIMD kernels */
+    md_mode |= DMODE_SIMDMIXER;
 
     if ( settings.interp )
     {
@@ -642,6 +645,261 @@ static int settings_menu(void)
     return 0;
 }
 
+#ifdef USETHREADS
+/* double buffering thread */
+static void thread(void)
+{
+    struct queue_event ev = {
+         .id = 0,
+    };
+
+    while (1)
+    {
+        if (rb->queue_empty(&thread_q))
+        {
+            synthbuf();
+            rb->yield();
+        }
+        else rb->queue_wait(&thread_q, &ev);
+        switch (ev.id) {
+            case EV_EXIT:
+                return;
+        }
+    }
+}
+
+static bool start_render_thread(void)
+{
+    rb->queue_init(&thread_q, true);
+    thread_id = rb->create_thread(thread, thread_stack,
+        sizeof(thread_stack), 0, "render buffering thread"
+        IF_PRIO(, PRIORITY_PLAYBACK)
+        IF_COP(, CPU));
+    return thread_id != 0;
+}
+
+static void stop_render_thread(void)
+{
+    rb->queue_post(&thread_q, EV_EXIT, 0);
+    rb->thread_wait(thread_id);
+    rb->queue_delete(&thread_q);
+}
+#endif
+
+/*****************************************************************************
+* Render benchmark
+*
+* Renders the start of the current module twice to WAV files, once with the
+* scalar mixer and once with DMODE_SIMDMIXER set, reloading the module before
+* each pass so both start from the same state. Only the time spent in the
+* mixer is counted, and the second pass is compared sample by sample against
+* the first.
+*/
+
+#define BENCH_SECONDS 60
+#define MENU_BENCHMARK 1
+
+static const char * const bench_file[2] =
+{
+    "/mikmod_scalar.wav",
+    "/mikmod_simd.wav",
+};
+
+struct bench_result
+{
+    long ticks;
+    long samples;
+    long diffs;
+    int maxdiff;
+};
+
+static unsigned char wav_header[44] =
+{
+    'R','I','F','F',     //  0 - ChunkID
+     0,0,0,0,            //  4 - ChunkSize (filesize-8)
+     'W','A','V','E',    //  8 - Format
+     'f','m','t',' ',    // 12 - SubChunkID
+     16,0,0,0,           // 16 - SubChunk1ID  // 16 for PCM
+     1,0,                // 20 - AudioFormat (1=16-bit)
+     2,0,                // 22 - NumChannels
+     0,0,0,0,            // 24 - SampleRate in Hz
+     0,0,0,0,            // 28 - Byte Rate (SampleRate*NumChannels*(BitsPerSample/8)
+     4,0,                // 32 - BlockAlign (== NumChannels * BitsPerSample/8)
+     16,0,               // 34 - BitsPerSample
+     'd','a','t','a',    // 36 - Subchunk2ID
+     0,0,0,0             // 40 - Subchunk2Size
+};
+
+static inline void int2le32(unsigned char* buf, int32_t x)
+{
+    buf[0] = (x & 0xff);
+    buf[1] = (x & 0xff00) >> 8;
+    buf[2] = (x & 0xff0000) >> 16;
+    buf[3] = (x & 0xff000000) >> 24;
+}
+
+static void close_wav(int fd)
+{
+    int filesize = rb->filesize(fd);
+
+    int2le32(wav_header+4, filesize-8);
+    int2le32(wav_header+24, md_mixfreq);
+    int2le32(wav_header+28, md_mixfreq * 4);
+    int2le32(wav_header+40, filesize-44);
+
+    rb->lseek(fd, 0, SEEK_SET);
+    rb->write(fd, wav_header, sizeof(wav_header));
+    rb->close(fd);
+}
+
+static bool bench_pass(int pass, struct bench_result *res)
+{
+    SWORD *out = (SWORD *)gmbuf;
+    SWORD *ref = (SWORD *)(gmbuf + BUF_SIZE);
+    long frames = 0, limit = (long)md_mixfreq * BENCH_SECONDS;
+    int fd, reffd = -1, i;
+
+    memset(res, 0, sizeof(*res));
+
+    module = Player_Load(np_file, 64, 0);
+    if (!module)
+        return false;
+
+    fd = rb->creat(bench_file[pass], 0666);
+    if (fd < 0)
+    {
+        Player_Free(module);
+        module = NULL;
+        return false;
+    }
+    rb->write(fd, wav_header, sizeof(wav_header));
+
+    if (pass > 0)
+    {
+        reffd = rb->open(bench_file[0], O_RDONLY);
+        if (reffd >= 0)
+            rb->lseek(reffd, sizeof(wav_header), SEEK_SET);
+    }
+
+    if (pass > 0)
+        md_mode |= DMODE_SIMDMIXER;
+    else
+        md_mode &= ~DMODE_SIMDMIXER;
+    Player_Start(module);
+
+    while (Player_Active() && frames < limit)
+    {
+        long start = *rb->current_tick;
+        VC_WriteBytes((SBYTE *)out, BUF_SIZE);
+        res->ticks += *rb->current_tick - start;
+
+        if (reffd >= 0 && rb->read(reffd, ref, BUF_SIZE) == BUF_SIZE)
+        {
+            for (i = 0; i < BUF_SIZE / 2; i++)
+            {
+                int d = out[i] - (SWORD)letoh16(ref[i]);
+                if (d)
+                {
+                    if (d < 0)
+                        d = -d;
+                    if (d > res->maxdiff)
+                        res->maxdiff = d;
+                    res->diffs++;
+                }
+            }
+        }
+
+        for (i = 0; i < BUF_SIZE / 2; i++)
+            out[i] = htole16(out[i]);
+        rb->write(fd, out, BUF_SIZE);
+
+        frames += BUF_SIZE / 4;
+        rb->yield();
+    }
+    res->samples = frames;
+
+    Player_Stop();
+    Player_Free(module);
+    module = NULL;
+
+    if (reffd >= 0)
+        rb->close(reffd);
+    close_wav(fd);
+    return true;
+}
+
+static void render_benchmark(void)
+{
+    struct bench_result res[2];
+    char statustext[LINE_LENGTH];
+    int pass;
+
+    /* The mixer is not reentrant, so the render thread has to go first */
+    rb->mixer_channel_stop(PCM_MIXER_CHAN_PLAYBACK);
+#ifdef USETHREADS
+    stop_render_thread();
+#endif
+
+    Player_Stop();
+    Player_Free(module);
+    module = NULL;
+
+    rb->lcd_clear_display();
+    rb->lcd_putsxy(1, 1, "Rendering...");
+    rb->lcd_update();
+
+    for (pass = 0; pass < 2; pass++)
+    {
+        if (!bench_pass(pass, &res[pass]))
+        {
+            rb->splashf(HZ*2, "Cannot write %s", bench_file[pass]);
+            break;
+        }
+    }
+
+    if (pass == 2)
+    {
+        rb->lcd_clear_display();
+        for (pass = 0; pass < 2; pass++)
+        {
+            long ms = res[pass].ticks * 1000 / HZ;
+            long audio_ms = res[pass].samples * 1000LL / md_mixfreq;
+            sprintf(statustext, "%s: %ld ms, %ldx",
+                    pass ? "SIMD" : "Scalar", ms,
+                    ms ? audio_ms / ms : 0);
+            rb->lcd_putsxy(1, 1 + 10*pass, statustext);
+        }
+        sprintf(statustext, "Diff: %ld samples, max %d",
+                res[1].diffs, res[1].maxdiff);
+        rb->lcd_putsxy(1, 21, statustext);
+        rb->lcd_update();
+        rb->button_clear_queue();
+        rb->button_get(true);
+    }
+
+    /* Restore the settings' mixer mode and restart the song */
+    applysettings();
+    memset(gmbuf, 0, sizeof(gmbuf));
+    module = Player_Load(np_file, 64, 0);
+    if (module)
+        Player_Start(module);
+    else
+    {
+        rb->splashf(HZ, "%s", MikMod_strerror(MikMod_errno));
+        quit = true;
+    }
+#ifdef USETHREADS
+    /* Restarted even without a module, playfile() stops it on the way out */
+    if (!start_render_thread())
+    {
+        rb->splash(HZ, "Cannot create thread!");
+        quit = true;
+    }
+#endif
+    if (!quit)
+        rb->mixer_channel_play_data(PCM_MIXER_CHAN_PLAYBACK, get_more, NULL, 0);
+}
+
 /**
   Show the main menu
  */
@@ -652,6 +910,7 @@ static int main_menu(void)
 
     MENUITEM_STRINGLIST(main_menu,"Mikmod Main Menu",NULL,
                         ID2P(LANG_SETTINGS),
+                        "Render Benchmark",
                         ID2P(LANG_RETURN),
                         ID2P(LANG_MENU_QUIT));
     while (1)
@@ -664,9 +923,12 @@ static int main_menu(void)
             break;
 
         case 1:
-            return 0;
+            return MENU_BENCHMARK;
 
         case 2:
+            return 0;
+
+        case 3:
             return -1;
 
         case MENU_ATTACHED_USB:
@@ -678,29 +940,6 @@ static int main_menu(void)
     }
 }
 
-#ifdef USETHREADS
-/* double buffering thread */
-static void thread(void)
-{
-    struct queue_event ev = {
-         .id = 0,
-    };
-
-    while (1)
-    {
-        if (rb->queue_empty(&thread_q))
-        {
-            synthbuf();
-            rb->yield();
-        }
-        else rb->queue_wait(&thread_q, &ev);
-        switch (ev.id) {
-            case EV_EXIT:
-                return;
-        }
-    }
-}
-#endif
 
 static void mm_errorhandler(void)
 {
@@ -739,11 +978,7 @@ static int playfile(char* filename)
     rb->cpu_boost(settings.boost);
 #endif
 #ifdef USETHREADS
-    rb->queue_init(&thread_q, true);
-    if ((thread_id = rb->create_thread(thread, thread_stack,
-        sizeof(thread_stack), 0, "render buffering thread"
-        IF_PRIO(, PRIORITY_PLAYBACK)
-        IF_COP(, CPU))) == 0)
+    if (!start_render_thread())
     {
         rb->splash(HZ, "Cannot create thread!");
         return PLUGIN_ERROR;
@@ -869,6 +1104,11 @@ static int playfile(char* filename)
 
         case ACTION_WPS_MENU:
             menureturn = main_menu();
+            if ( menureturn == MENU_BENCHMARK )
+            {
+                render_benchmark();
+                menureturn = 0;
+            }
             if ( menureturn != 0 )
             {
                 quit = true;
@@ -895,9 +1135,7 @@ static int playfile(char* filename)
     }
 
 #ifdef USETHREADS
-    rb->queue_post(&thread_q, EV_EXIT, 0);
-    rb->thread_wait(thread_id);
-    rb->queue_delete(&thread_q);
+    stop_render_thread();
 #endif
 #ifdef HAVE_ADJUSTABLE_CPU_FREQ
     rb->cpu_boost(false);
@@ -724,6 +724,15 @@ extern MikMod_callback_t vc_callback;
 /*========== SIMD mixing routines */
 #undef HAVE_ALTIVEC
 #undef HAVE_SSE2
+#undef HAVE_NEON
+#undef HAVE_ARMV6
+
+/* Rockbox: hosted builds run on CPUs that always have the vector unit the
+   compiler targets, so the SIMD mixers are worth having there. */
+#if !defined(MIKMOD_SIMD) && (CONFIG_PLATFORM & PLATFORM_HOSTED)
+#define MIKMOD_SIMD
+#endif
+
 #if defined(MIKMOD_SIMD)
 
 #if (defined(__ppc__) || defined(__ppc64__)) && defined(__VEC__) && !(defined(__GNUC__) && (__GNUC__ < 3))
@@ -732,6 +741,9 @@ extern MikMod_callback_t vc_callback;
 #elif defined(__GNUC__) && defined(__SSE2__) /* x86 / x86_64 */
 #define HAVE_SSE2
 
+#elif defined(__GNUC__) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define HAVE_NEON
+
 #elif defined(_MSC_VER) && (_MSC_VER >= 1300) && (defined(_M_IX86) || defined(_M_AMD64))
 /* FIXME: emmintrin.h requires VC6 processor pack or VC2003+ */
 #define HAVE_SSE2
@@ -740,9 +752,14 @@ extern MikMod_callback_t vc_callback;
 #pragma warning(disable:4391)
 #pragma warning(disable:4244)
 
-#endif /* AltiVec/SSE2 */
+#endif /* AltiVec/SSE2/NEON */
 #endif /* MIKMOD_SIMD */
 
+/* ARMv6 saturation and halfword packing, used by the scalar output stage */
+#if defined(CPU_ARM) && (ARM_ARCH >= 6)
+#define HAVE_ARMV6
+#endif
+
 /*========== SIMD mixing helper functions =============*/
 
 #if defined(_WIN64)
@@ -843,9 +860,27 @@ static __inline __m128i mm_hiqq(const __m128i a) {
 #define simd_m128i __m128i
 #define simd_m128 __m128
 
+#elif defined HAVE_NEON
+
+#include <arm_neon.h>
+
+/* NEON has no alignment requirements, but the callers still line buffers
+   up on 16 bytes for the benefit of the other instruction sets. */
+#define EXTRACT_SAMPLE_SIMD(srce, var, size) var = vshrq_n_s32(vld1q_s32((const int32_t *)(srce)), BITSHIFT+16-size);
+#define EXTRACT_SAMPLE_SIMD_F(srce, var, size, mul) var = vmulq_f32(vcvtq_f32_s32(vshrq_n_s32(vld1q_s32((const int32_t *)(srce)), BITSHIFT-size)), mul);
+#define EXTRACT_SAMPLE_SIMD_0(srce, var) EXTRACT_SAMPLE_SIMD(srce, var, 0)
+#define EXTRACT_SAMPLE_SIMD_8(srce, var) EXTRACT_SAMPLE_SIMD(srce, var, 8)
+#define EXTRACT_SAMPLE_SIMD_16(srce, var) EXTRACT_SAMPLE_SIMD(srce, var, 16)
+#define PUT_SAMPLE_SIMD_W(dste, v1, v2)  vst1q_s16((int16_t *)(dste), vcombine_s16(vqmovn_s32(v1), vqmovn_s32(v2)));
+#define PUT_SAMPLE_SIMD_B(dste, v1, v2, v3, v4)  vst1q_s8((int8_t *)(dste), vaddq_s8(vcombine_s8(vqmovn_s16(vcombine_s16(vqmovn_s32(v1), vqmovn_s32(v2))), vqmovn_s16(vcombine_s16(vqmovn_s32(v3), vqmovn_s32(v4)))), vdupq_n_s8(-128)));
+#define PUT_SAMPLE_SIMD_F(dste, v1)  vst1q_f32((float *)(dste), v1);
+#define LOAD_PS1_SIMD(ptr) vld1q_dup_f32(ptr)
+#define simd_m128i int32x4_t
+#define simd_m128 float32x4_t
+
 #endif
 
-#if defined(HAVE_SSE2) || defined(HAVE_ALTIVEC)
+#if defined(HAVE_SSE2) || defined(HAVE_ALTIVEC) || defined(HAVE_NEON)
 /* MikMod_amalloc() returns a 16 byte aligned zero-filled
    memory in SIMD-enabled builds.
  - the returned memory can be freed with MikMod_afree()
@@ -37,7 +37,7 @@
 #include "string.h"
 #include "mikmod_internals.h"
 
-#if defined(HAVE_SSE2) || defined(HAVE_ALTIVEC)
+#if defined(HAVE_SSE2) || defined(HAVE_ALTIVEC) || defined(HAVE_NEON)
 #undef WIN32_ALIGNED_MALLOC
 #if defined(_WIN32) && !defined(_WIN32_WCE)
 # if defined(_WIN64) /* OK with MSVC and MinGW */
@@ -95,7 +95,7 @@ void MikMod_afree(void *data)
 	free((void *) *(size_t*)((unsigned char *)data - PTRSIZE));
 #endif
 }
-#endif /* (HAVE_SSE2) || (HAVE_ALTIVEC) */
+#endif /* (HAVE_SSE2) || (HAVE_ALTIVEC) || (HAVE_NEON) */
 
 void* MikMod_realloc(void *data, size_t size)
 {
@@ -126,7 +126,7 @@ static	SLONG *RVbufR1=NULL,*RVbufR2=NULL,*RVbufR3=NULL,*RVbufR4=NULL,
 #define NATIVE SLONG
 #endif
 
-#if defined HAVE_SSE2 || defined HAVE_ALTIVEC
+#if defined HAVE_SSE2 || defined HAVE_ALTIVEC || defined HAVE_NEON
 
 # if !defined(NATIVE_64BIT_INT)
 static SINTPTR_T MixSIMDMonoNormal(const SWORD* srce,SLONG* dest,SINTPTR_T idx,SINTPTR_T increment,SINTPTR_T todo)
@@ -249,7 +249,31 @@ static SINTPTR_T MixSIMDStereoNormal(const SWORD* srce,SLONG* dest,SINTPTR_T idx
 			idx += increment;
 		}
 	}
-#endif /* HAVE_ALTIVEC */
+
+#elif defined HAVE_NEON
+	remain = todo&3;
+	{
+		SWORD s[8];
+		SWORD lr[4] = {vol[0], vol[1], vol[0], vol[1]};
+		int16x4_t v0 = vld1_s16(lr);
+
+		for(todo>>=2;todo; todo--)
+		{
+			int16x8_t v1;
+
+			s[0] = s[1] = srce[idx >> FRACBITS];
+			s[2] = s[3] = srce[(idx += increment) >> FRACBITS];
+			s[4] = s[5] = srce[(idx += increment) >> FRACBITS];
+			s[6] = s[7] = srce[(idx += increment) >> FRACBITS];
+			v1 = vld1q_s16(s);
+
+			vst1q_s32((int32_t*)(dest+0), vmlal_s16(vld1q_s32((int32_t*)(dest+0)), vget_low_s16(v1), v0));
+			vst1q_s32((int32_t*)(dest+4), vmlal_s16(vld1q_s32((int32_t*)(dest+4)), vget_high_s16(v1), v0));
+			dest+=8;
+			idx += increment;
+		}
+	}
+#endif /* HAVE_NEON */
 
 	/* Remaining bits */
 	while(remain--) {
@@ -263,12 +287,98 @@ static SINTPTR_T MixSIMDStereoNormal(const SWORD* srce,SLONG* dest,SINTPTR_T idx
 }
 #endif
 
+#if defined HAVE_SSE2 || defined HAVE_NEON
+
+#define INTERP_SAMPLE(idx) \
+	((SLONG)srce[(idx)>>FRACBITS]+ \
+	 ((SLONG)(srce[((idx)>>FRACBITS)+1]-srce[(idx)>>FRACBITS]) \
+	  *((idx)&FRACMASK)>>FRACBITS))
+
+/* Linear interpolation is a gather from the sample, so it stays scalar. The
+   interpolated value always lies between two 16 bit sample points, which
+   lets the volume multiply-accumulate run on four frames at a time exactly
+   like MixSIMDStereoNormal. Volume ramping is left to the caller. */
+static SINTPTR_T MixSIMDStereoInterp(const SWORD* srce,SLONG* dest,SINTPTR_T idx,SINTPTR_T increment,SINTPTR_T todo)
+{
+	SWORD vol[2] = {vnf->lvolsel, vnf->rvolsel};
+	SLONG sample;
+	SINTPTR_T remain;
+
+	/* Dest can be misaligned */
+	while(todo && !IS_ALIGNED_16(dest)) {
+		sample=INTERP_SAMPLE(idx);
+		idx += increment;
+		*dest++ += vol[0] * sample;
+		*dest++ += vol[1] * sample;
+		todo--;
+	}
+
+	remain = todo&3;
+
+#if defined HAVE_SSE2
+	{
+		__m128i v0 = _mm_set_epi16(0, vol[1],
+					   0, vol[0],
+					   0, vol[1],
+					   0, vol[0]);
+		for(todo>>=2;todo; todo--)
+		{
+			SWORD s0 = (SWORD)INTERP_SAMPLE(idx);
+			SWORD s1 = (SWORD)INTERP_SAMPLE(idx+increment);
+			SWORD s2 = (SWORD)INTERP_SAMPLE(idx+2*increment);
+			SWORD s3 = (SWORD)INTERP_SAMPLE(idx+3*increment);
+			__m128i v1 = _mm_set_epi16(0, s1, 0, s1, 0, s0, 0, s0);
+			__m128i v2 = _mm_set_epi16(0, s3, 0, s3, 0, s2, 0, s2);
+			__m128i v3 = _mm_load_si128((__m128i*)(dest+0));
+			__m128i v4 = _mm_load_si128((__m128i*)(dest+4));
+			_mm_store_si128((__m128i*)(dest+0), _mm_add_epi32(v3, _mm_madd_epi16(v0, v1)));
+			_mm_store_si128((__m128i*)(dest+4), _mm_add_epi32(v4, _mm_madd_epi16(v0, v2)));
+			dest+=8;
+			idx += 4*increment;
+		}
+	}
+#elif defined HAVE_NEON
+	{
+		SWORD s[8];
+		SWORD lr[4] = {vol[0], vol[1], vol[0], vol[1]};
+		int16x4_t v0 = vld1_s16(lr);
+
+		for(todo>>=2;todo; todo--)
+		{
+			int16x8_t v1;
+
+			s[0] = s[1] = (SWORD)INTERP_SAMPLE(idx);
+			s[2] = s[3] = (SWORD)INTERP_SAMPLE(idx+increment);
+			s[4] = s[5] = (SWORD)INTERP_SAMPLE(idx+2*increment);
+			s[6] = s[7] = (SWORD)INTERP_SAMPLE(idx+3*increment);
+			v1 = vld1q_s16(s);
+
+			vst1q_s32((int32_t*)(dest+0), vmlal_s16(vld1q_s32((int32_t*)(dest+0)), vget_low_s16(v1), v0));
+			vst1q_s32((int32_t*)(dest+4), vmlal_s16(vld1q_s32((int32_t*)(dest+4)), vget_high_s16(v1), v0));
+			dest+=8;
+			idx += 4*increment;
+		}
+	}
+#endif /* HAVE_NEON */
+
+	/* Remaining bits */
+	while(remain--) {
+		sample=INTERP_SAMPLE(idx);
+		idx += increment;
+
+		*dest++ += vol[0] * sample;
+		*dest++ += vol[1] * sample;
+	}
+	return idx;
+}
+#endif /* HAVE_SSE2 || HAVE_NEON */
+
 /*========== 32 bit sample mixers - only for 32 bit platforms */
 #ifndef NATIVE_64BIT_INT
 
 static SLONG Mix32MonoNormal(const SWORD* srce,SLONG* dest,SLONG idx,SLONG increment,SLONG todo)
 {
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
+#if defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON
 	if (md_mode & DMODE_SIMDMIXER) {
 		return MixSIMDMonoNormal(srce, dest, idx, increment, todo);
 	}
@@ -292,7 +402,7 @@ static SLONG Mix32MonoNormal(const SWORD* srce,SLONG* dest,SLONG idx,SLONG incre
 /* Hint : changes SLONG / SLONGLONG mess with intptr */
 static SLONG Mix32StereoNormal(const SWORD* srce,SLONG* dest,SLONG idx,SLONG increment,SLONG todo)
 {
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
+#if defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON
 	if (md_mode & DMODE_SIMDMIXER) {
 		return MixSIMDStereoNormal(srce, dest, idx, increment, todo);
 	}
@@ -404,6 +514,12 @@ static SLONG Mix32StereoInterp(const SWORD* srce,SLONG* dest,SLONG idx,SLONG inc
 			return idx;
 	}
 
+#if defined HAVE_SSE2 || defined HAVE_NEON
+	if (md_mode & DMODE_SIMDMIXER) {
+		return MixSIMDStereoInterp(srce, dest, idx, increment, todo);
+	}
+#endif
+
 	while(todo--) {
 		sample=(SLONG)srce[idx>>FRACBITS]+
 			((SLONG)(srce[(idx>>FRACBITS)+1]-srce[idx>>FRACBITS])
@@ -588,6 +704,12 @@ static SLONGLONG MixStereoInterp(const SWORD* srce,SLONG* dest,SLONGLONG idx,SLO
 			return idx;
 	}
 
+#if defined HAVE_SSE2 || defined HAVE_NEON
+	if (md_mode & DMODE_SIMDMIXER) {
+		return MixSIMDStereoInterp(srce, dest, idx, increment, todo);
+	}
+#endif
+
 	while(todo--) {
 		sample=(SLONG)srce[idx>>FRACBITS]+
 			((SLONG)(srce[(idx>>FRACBITS)+1]-srce[idx>>FRACBITS])
@@ -801,6 +923,39 @@ static void Mix32ToFP(float* dste,const SLONG *srce,NATIVE count)
 #define CHECK_SAMPLE(var,bound) var=(var>=bound)?bound-1:(var<-bound)?-bound:var
 #define PUT_SAMPLE(var) *dste++=var
 
+#if defined HAVE_ARMV6
+/* ssat does the shift and the clipping of EXTRACT_SAMPLE/CHECK_SAMPLE in
+   one instruction; pkhbt then packs two results for a single word store. */
+static void Mix32To16(SWORD* dste,const SLONG *srce,NATIVE count)
+{
+	SLONG x1,x2;
+	ULONG *dstw;
+
+	if(((long)dste & 2) && count) {
+		x1 = *srce++;
+		asm ("ssat %0, #16, %0, asr %1" : "+r"(x1) : "i"(BITSHIFT));
+		*dste++ = x1;
+		count--;
+	}
+
+	dstw = (ULONG *)dste;
+	for(count-=2;count>=0;count-=2) {
+		x1 = *srce++;
+		x2 = *srce++;
+		asm ("ssat  %0, #16, %0, asr %2 \n"
+		     "ssat  %1, #16, %1, asr %2 \n"
+		     "pkhbt %0, %0, %1, lsl #16 \n"
+		     : "+r"(x1), "+r"(x2) : "i"(BITSHIFT));
+		*dstw++ = x1;
+	}
+
+	if(count & 1) {
+		x1 = *srce;
+		asm ("ssat %0, #16, %0, asr %1" : "+r"(x1) : "i"(BITSHIFT));
+		*(SWORD *)dstw = x1;
+	}
+}
+#else
 static void Mix32To16(SWORD* dste,const SLONG *srce,NATIVE count)
 {
 	SLONG x1,x2,x3,x4;
@@ -822,6 +977,7 @@ static void Mix32To16(SWORD* dste,const SLONG *srce,NATIVE count)
 		PUT_SAMPLE(x1);
 	}
 }
+#endif /* HAVE_ARMV6 */
 
 static void Mix32To8(SBYTE* dste,const SLONG *srce,NATIVE count)
 {
@@ -846,7 +1002,7 @@ static void Mix32To8(SBYTE* dste,const SLONG *srce,NATIVE count)
 	}
 }
 
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
+#if defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON
 
 /* Mix 32bit input to floating point. 32 samples per iteration */
 /* PC: ?, Mac OK */
@@ -1064,7 +1220,7 @@ static void AddChannel(SLONG* ptr,NATIVE todo)
 								   (s,ptr,vnf->current,vnf->increment,done);
 					else
 					{
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
+#if defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON
 					    if (md_mode & DMODE_SIMDMIXER)
 						vnf->current=MixSIMDStereoNormal
 								   (s,ptr,vnf->current,vnf->increment,done);
@@ -1097,7 +1253,7 @@ static void AddChannel(SLONG* ptr,NATIVE todo)
 								   (s,ptr,vnf->current,vnf->increment,done);
 					else
 					{
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
+#if defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON
 					    if (md_mode & DMODE_SIMDMIXER)
 						vnf->current=MixSIMDStereoNormal
 								   (s,ptr,vnf->current,vnf->increment,done);
@@ -1217,7 +1373,7 @@ void VC1_WriteSamples(SBYTE* buf,ULONG todo)
 				vc_callback((unsigned char*)vc_tickbuf, portion);
 			}
 
-#if defined HAVE_ALTIVEC || defined HAVE_SSE2
+#if defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON
 			if (md_mode & DMODE_SIMDMIXER)
 			{
 				if(vc_mode & DMODE_FLOAT)
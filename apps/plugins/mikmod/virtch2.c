@@ -312,7 +312,7 @@ static SLONGLONG MixMonoNormal(const SWORD* const srce,SLONG* dest,SLONGLONG idx
 
 /* Slowest part... */
 
-#if defined HAVE_SSE2 || defined HAVE_ALTIVEC
+#if defined HAVE_SSE2 || defined HAVE_ALTIVEC || defined HAVE_NEON
 
 static __inline SWORD GetSample(const SWORD* const srce, SLONGLONG idx)
 {
@@ -426,7 +426,31 @@ static SLONGLONG MixSIMDStereoNormal(const SWORD* const srce,SLONG* dest,SLONGLO
 			idx += increment;
 		}
 	}
-#endif /* HAVE_ALTIVEC */
+
+#elif defined HAVE_NEON
+	remain = todo&3;
+	{
+		SWORD s[8];
+		SWORD lr[4] = {vol[0], vol[1], vol[0], vol[1]};
+		int16x4_t v0 = vld1_s16(lr);
+
+		for(todo>>=2;todo; todo--)
+		{
+			int16x8_t v1;
+
+			s[0] = s[1] = GetSample(srce, idx);
+			s[2] = s[3] = GetSample(srce, idx += increment);
+			s[4] = s[5] = GetSample(srce, idx += increment);
+			s[6] = s[7] = GetSample(srce, idx += increment);
+			v1 = vld1q_s16(s);
+
+			vst1q_s32((int32_t*)(dest+0), vmlal_s16(vld1q_s32((int32_t*)(dest+0)), vget_low_s16(v1), v0));
+			vst1q_s32((int32_t*)(dest+4), vmlal_s16(vld1q_s32((int32_t*)(dest+4)), vget_high_s16(v1), v0));
+			dest+=8;
+			idx += increment;
+		}
+	}
+#endif /* HAVE_NEON */
 
 	/* Remaining bits */
 	while(remain--) {
@@ -515,7 +539,7 @@ static SLONGLONG MixStereoNormal(const SWORD* const srce,SLONG* dest,SLONGLONG i
 	return idx;
 }
 
-#else /* HAVE_SSE2 || HAVE_ALTIVEC */
+#else /* HAVE_SSE2 || HAVE_ALTIVEC || HAVE_NEON */
 static SLONGLONG MixStereoNormal(const SWORD* const srce,SLONG* dest,SLONGLONG idx,SLONGLONG increment,ULONG todo)
 {
 	SWORD sample=0;
@@ -558,7 +582,7 @@ static SLONGLONG MixStereoNormal(const SWORD* const srce,SLONG* dest,SLONGLONG i
 
 	return idx;
 }
-#endif /* HAVE_SSE2 || HAVE_ALTIVEC */
+#endif /* HAVE_SSE2 || HAVE_ALTIVEC || HAVE_NEON */
 
 
 static SLONGLONG MixStereoSurround(const SWORD* srce,SLONG* dest,SLONGLONG idx,SLONGLONG increment,ULONG todo)
@@ -864,11 +888,11 @@ static void Mix32To16_Stereo_SIMD_4Tap(SWORD* dste, const SLONG* srce, NATIVE co
 	/* Check unaligned dste buffer. srce is always aligned. */
 	while(!IS_ALIGNED_16(dste))
 	{
+		if(count < (NATIVE)SAMPLING_FACTOR) return;
 		Mix32To16_Stereo(dste, srce, SAMPLING_FACTOR);
 		dste+=2;
 		srce+=8;
-		count--;
-		if(!count) return;
+		count-=SAMPLING_FACTOR;
 	}
 
 	/* dste and srce aligned. srce is always aligned. */
@@ -925,7 +949,6 @@ static void Mix32To16_Stereo_SIMD_4Tap(SWORD* dste, const SLONG* srce, NATIVE co
 		srce+=32; /* 32 = 4 * 8  */
 	}
 
-	/* FIXME: THIS PART WRITES PAST DST !! */
 	if (remain)
 	{
 		Mix32To16_Stereo(dste, srce, remain);
@@ -942,11 +965,11 @@ static void Mix32To16_Stereo_SIMD_4Tap(SWORD* dste, const SLONG* srce, NATIVE co
 	/* Check unaligned dste buffer. srce is always aligned. */
 	while(!IS_ALIGNED_16(dste))
 	{
+		if(count < (NATIVE)SAMPLING_FACTOR) return;
 		Mix32To16_Stereo(dste, srce, SAMPLING_FACTOR);
 		dste+=2;
 		srce+=8;
-		count--;
-		if(!count) return;
+		count-=SAMPLING_FACTOR;
 	}
 
 	/* dste and srce aligned. srce is always aligned. */
@@ -1003,6 +1026,56 @@ static void Mix32To16_Stereo_SIMD_4Tap(SWORD* dste, const SLONG* srce, NATIVE co
 	}
 }
 
+#elif defined HAVE_NEON
+#define SHIFT_MIX_TO_16 (BITSHIFT + 16 - 16)
+
+/* Average of four stereo frames, given as pairwise sums l02 r02 l13 r13 */
+static inline int32x2_t neon_avg4(int32x4_t v)
+{
+	return vshr_n_s32(vadd_s32(vget_low_s32(v), vget_high_s32(v)), 2);
+}
+
+static void Mix32To16_Stereo_SIMD_4Tap(SWORD* dste, const SLONG* srce, NATIVE count)
+{
+	int remain = count;
+
+	/* Keep the same output alignment as the SSE2 and AltiVec versions */
+	while(!IS_ALIGNED_16(dste))
+	{
+		if(count < (NATIVE)SAMPLING_FACTOR) return;
+		Mix32To16_Stereo(dste, srce, SAMPLING_FACTOR);
+		dste+=2;
+		srce+=8;
+		count-=SAMPLING_FACTOR;
+	}
+
+	remain = count & 15;
+	for(count>>=4;count;count--)
+	{
+		const int32_t *s = (const int32_t *)srce;
+		int32x2_t f0 = neon_avg4(vaddq_s32(vshrq_n_s32(vld1q_s32(s+0),  SHIFT_MIX_TO_16),
+		                                   vshrq_n_s32(vld1q_s32(s+4),  SHIFT_MIX_TO_16)));
+		int32x2_t f1 = neon_avg4(vaddq_s32(vshrq_n_s32(vld1q_s32(s+8),  SHIFT_MIX_TO_16),
+		                                   vshrq_n_s32(vld1q_s32(s+12), SHIFT_MIX_TO_16)));
+		int32x2_t f2 = neon_avg4(vaddq_s32(vshrq_n_s32(vld1q_s32(s+16), SHIFT_MIX_TO_16),
+		                                   vshrq_n_s32(vld1q_s32(s+20), SHIFT_MIX_TO_16)));
+		int32x2_t f3 = neon_avg4(vaddq_s32(vshrq_n_s32(vld1q_s32(s+24), SHIFT_MIX_TO_16),
+		                                   vshrq_n_s32(vld1q_s32(s+28), SHIFT_MIX_TO_16)));
+
+		/* 4 averaged stereo samples, 32bit to 16bit with saturation */
+		vst1q_s16((int16_t *)dste, vcombine_s16(vqmovn_s32(vcombine_s32(f0, f1)),
+		                                        vqmovn_s32(vcombine_s32(f2, f3))));
+
+		dste+=8;
+		srce+=32; /* 32 = 4 * 8  */
+	}
+
+	if (remain)
+	{
+		Mix32To16_Stereo(dste, srce, remain);
+	}
+}
+
 #endif
 
 
@@ -1259,7 +1332,7 @@ int VC2_Init(void)
 
 	if(md_mode & DMODE_STEREO) {
 		Mix32toFP  = Mix32ToFP_Stereo;
-#if ((defined HAVE_ALTIVEC || defined HAVE_SSE2) && (SAMPLING_FACTOR == 4))
+#if ((defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON) && (SAMPLING_FACTOR == 4))
 		if (md_mode & DMODE_SIMDMIXER)
 			Mix32to16  = Mix32To16_Stereo_SIMD_4Tap;
 		else
@@ -1285,6 +1358,16 @@ int VC2_PlayStart(void)
 {
 	md_mode|=DMODE_INTERP;
 
+	/* DMODE_SIMDMIXER may have changed since VC2_Init() */
+	if(vc_mode & DMODE_STEREO) {
+#if ((defined HAVE_ALTIVEC || defined HAVE_SSE2 || defined HAVE_NEON) && (SAMPLING_FACTOR == 4))
+		if (md_mode & DMODE_SIMDMIXER)
+			Mix32to16  = Mix32To16_Stereo_SIMD_4Tap;
+		else
+#endif
+			Mix32to16  = Mix32To16_Stereo;
+	}
+
 	samplesthatfit = TICKLSIZE;
 	if(vc_mode & DMODE_STEREO) samplesthatfit >>= 1;
 	tickleft = 0;
@@ -46,6 +46,35 @@ struct dynarec_block {
 
 extern struct dynarec_block *address_map[1<<HASH_SIGNIFICANT_LOWER_BITS];
 extern int blockclen;
+#elif !defined(ASM_CPU_EMULATE)
+#define BLOCKCACHE
+#endif
+
+#ifdef BLOCKCACHE
+struct blockcache
+{
+    int enabled;
+    unsigned long hits, misses, retranslations, flushes;
+    /* the running block */
+    int abort;
+    const byte *code;
+    unsigned long len;
+};
+
+extern struct blockcache blockcache;
+
+void blockcache_init(void);
+void blockcache_flush(void);
+
+/* Ends the running block after the current instruction: memory map
+ * changes, I/O register accesses and writes into the block itself */
+#define blockcache_abort() (blockcache.abort = 1)
+#define blockcache_written(p) \
+    ((unsigned long)((const byte *)(p) - blockcache.code) < blockcache.len \
+        ? blockcache_abort() : 0)
+#else
+#define blockcache_abort() ((void)0)
+#define blockcache_written(p) ((void)0)
 #endif
 
 void cpu_reset(void);
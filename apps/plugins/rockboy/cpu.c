@@ -22,7 +22,17 @@ bool plugbuf;
 #define PUSH(w) ( (SP -= 2), (writew(xSP, (w))) )
 #define POP(w) ( ((w) = readw(xSP)), (SP += 2) )
 
+#ifdef BLOCKCACHE
+/* Inside a cached block opcodes and immediates come straight from the
+ * host page the block lives in */
+#define FETCH ( bcmap ? bcmap[PC++] : readb(PC++) )
+#define IMM8 ( bcmap ? bcmap[PC] : readb(PC) )
+#define IMM16 ( bcmap ? bcmap[PC] | (bcmap[PC+1]<<8) : readw(xPC) )
+#else
 #define FETCH (readb(PC++))
+#define IMM8 (readb(PC))
+#define IMM16 (readw(xPC))
+#endif
 
 
 #define INC(r) { ((r)++); \
@@ -204,8 +214,8 @@ label: op(b); break;
 
 
 
-#define JR ( PC += 1+(n8)readb(PC) )
-#define JP ( PC = readw(PC) )
+#define JR ( PC += 1+(n8)IMM8 )
+#define JP ( PC = IMM16 )
 
 #define CALL ( PUSH(PC+2), JP )
 
@@ -234,6 +244,155 @@ int blockcount;
 #define MAXBLOCK 6
 #endif
 
+#ifdef BLOCKCACHE
+/*
+ * Translated block cache.
+ *
+ * A block is a straight run of up to BC_MAX_INSNS instructions that ends
+ * with the first branch, HALT, STOP, EI, DI or direct I/O access and never
+ * leaves the 4k page it starts in. Blocks are keyed by the host address of
+ * their first opcode, which stands for both the bank and the PC. On a hit
+ * the whole block runs without interrupt checks in between and the timers
+ * are advanced once at its end. Blocks in RAM carry a checksum of their
+ * bytes and are retranslated when it changes. The running block is cut
+ * short when its cycles reach what is left of the budget, on a memory map
+ * change (bank switch), on any I/O register access (through (HL) or (BC)
+ * as well) and when it writes into its own bytes.
+ */
+#define BC_HASH_BITS 10
+#define BC_HASH_MASK ((1<<BC_HASH_BITS)-1)
+#define BC_MAX_BLOCKS 2048
+#define BC_MAX_INSNS 16
+
+/* low bits: instruction length, 0 for invalid opcodes */
+#define BC_LEN 3
+#define BC_END 4
+
+static const byte bc_op_info[256] ICONST_ATTR =
+{
+    1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+    6, 3, 1, 1, 1, 1, 2, 1, 6, 1, 1, 1, 1, 1, 2, 1,
+    6, 3, 1, 1, 1, 1, 2, 1, 6, 1, 1, 1, 1, 1, 2, 1,
+    6, 3, 1, 1, 1, 1, 2, 1, 6, 1, 1, 1, 1, 1, 2, 1,
+
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 5, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+
+    5, 1, 7, 7, 7, 1, 2, 5, 5, 5, 7, 2, 7, 7, 2, 5,
+    5, 1, 7, 0, 7, 1, 2, 5, 5, 5, 7, 0, 7, 0, 2, 5,
+    6, 1, 5, 0, 0, 1, 2, 5, 2, 5, 7, 0, 0, 0, 2, 5,
+    6, 1, 5, 5, 0, 1, 2, 5, 2, 1, 7, 5, 0, 0, 2, 5,
+};
+
+struct bc_block
+{
+    const byte *code;
+    struct bc_block *next;
+    un32 sum;
+    byte len;
+    byte insns;
+};
+
+struct blockcache blockcache;
+static struct bc_block *bc_hash[1<<BC_HASH_BITS];
+static struct bc_block *bc_pool;
+static int bc_used;
+
+void blockcache_init(void)
+{
+    bc_pool = malloc(BC_MAX_BLOCKS * sizeof(struct bc_block));
+    blockcache.enabled = bc_pool != NULL;
+    blockcache_flush();
+}
+
+void blockcache_flush(void)
+{
+    memset(bc_hash, 0, sizeof(bc_hash));
+    bc_used = 0;
+    blockcache_abort();
+}
+
+static un32 bc_checksum(const byte *code, int len)
+{
+    un32 sum = 2166136261u;
+
+    while (len--)
+        sum = (sum ^ *code++) * 16777619u;
+    return sum;
+}
+
+static void bc_translate(struct bc_block *b, const byte *code, int pc)
+{
+    int room = 0x1000 - (pc & 0xfff);
+    int len = 0, insns = 0, info;
+
+    while (insns < BC_MAX_INSNS && len < room)
+    {
+        info = bc_op_info[code[len]];
+        if (!info || len + (info & BC_LEN) > room)
+            break;
+        len += info & BC_LEN;
+        insns++;
+        if (info & BC_END)
+            break;
+    }
+    b->code = code;
+    b->len = len;
+    b->insns = insns;
+    b->sum = pc & 0x8000 ? bc_checksum(code, len) : 0;
+}
+
+/* Looks up (or translates) the block at PC. Returns NULL when nothing can
+ * be cached there; a block with no instructions means the same. */
+static const struct bc_block *bc_lookup(void) ICODE_ATTR;
+static const struct bc_block *bc_lookup(void)
+{
+    byte *map = mbc.rmap[PC>>12];
+    struct bc_block *b, **head;
+    const byte *code;
+
+    if (!blockcache.enabled || !map)
+        return NULL;
+
+    code = map + PC;
+    head = &bc_hash[(PC ^ ((unsigned long)map >> 14)) & BC_HASH_MASK];
+    for (b = *head; b; b = b->next)
+        if (b->code == code)
+            break;
+
+    if (!b)
+    {
+        blockcache.misses++;
+        if (bc_used == BC_MAX_BLOCKS)
+        {
+            blockcache.flushes++;
+            blockcache_flush();
+        }
+        b = &bc_pool[bc_used++];
+        b->next = *head;
+        *head = b;
+        bc_translate(b, code, PC);
+    }
+    else if ((PC & 0x8000) && bc_checksum(code, b->len) != b->sum)
+    {
+        blockcache.retranslations++;
+        bc_translate(b, code, PC);
+    }
+    else
+        blockcache.hits++;
+
+    blockcache.abort = 0;
+    return b;
+}
+#endif
+
 
 
 void cpu_reset(void)
@@ -266,6 +425,9 @@ void cpu_reset(void)
     HL = 0x014D;
 
     if (hw.cgb) A = 0x11;
+#ifdef BLOCKCACHE
+    blockcache_flush();
+#endif
 #ifdef DYNAREC
     for(i=0;i<(1<<HASH_SIGNIFICANT_LOWER_BITS);i++)
         address_map[i]=0;
@@ -377,6 +539,11 @@ int cpu_emulate(int cycles)
     static union reg acc IBSS_ATTR;
     static byte b IBSS_ATTR;
     static word w IBSS_ATTR;
+#ifdef BLOCKCACHE
+    const struct bc_block *bcblock;
+    const byte *bcmap;
+    int bcrun, bclen, bcpc;
+#endif
 
     i = cycles;
 next:
@@ -417,6 +584,20 @@ next:
 /*    if (debug_trace) debug_disassemble(PC, 1); */
 #ifdef DYNAREC
     if(PC&0x8000) {
+#endif
+#ifdef BLOCKCACHE
+    bcrun = 0;
+    bcmap = NULL;
+    bcpc = PC;
+    blockcache.len = 0;
+    if ((bcblock = bc_lookup()) && (bcrun = bcblock->insns))
+    {
+        bcmap = mbc.rmap[bcpc>>12];
+        blockcache.code = bcblock->code;
+        blockcache.len = bcblock->len;
+    }
+    bclen = 0;
+block:
 #endif
     op = FETCH;
     clen = cycles_table[op];
@@ -558,28 +739,28 @@ next:
 
     case 0x01: /* LD BC,imm */
 #ifdef DYNAREC
-        W(acc) = readw(xPC);
+        W(acc) = IMM16;
         B=HB(acc);
         C=LB(acc);
 #else
-        BC = readw(xPC);
+        BC = IMM16;
 #endif
         PC += 2;
         break;
     case 0x11: /* LD DE,imm */
 #ifdef DYNAREC
-        W(acc) = readw(xPC);
+        W(acc) = IMM16;
         D=HB(acc);
         E=LB(acc);
 #else        
-        DE = readw(xPC); 
+        DE = IMM16; 
 #endif
         PC += 2; 
         break;
     case 0x21: /* LD HL,imm */
-        HL = readw(xPC); PC += 2; break;
+        HL = IMM16; PC += 2; break;
     case 0x31: /* LD SP,imm */
-        SP = readw(xPC); PC += 2; break;
+        SP = IMM16; PC += 2; break;
 
     case 0x02: /* LD (BC),A */
         writeb(xBC, A); break;
@@ -617,9 +798,9 @@ next:
         A = FETCH; break;
 
     case 0x08: /* LD (imm),SP */
-        writew(readw(xPC), SP); PC += 2; break;
+        writew(IMM16, SP); PC += 2; break;
     case 0xEA: /* LD (imm),A */
-        writeb(readw(xPC), A); PC += 2; break;
+        writeb(IMM16, A); PC += 2; break;
 
     case 0xE0: /* LDH (imm),A */
         writehi(FETCH, A); break;
@@ -636,7 +817,7 @@ next:
     case 0xF9: /* LD SP,HL */
         SP = HL; break;
     case 0xFA: /* LD A,(imm) */
-        A = readb(readw(xPC)); PC += 2; break;
+        A = readb(IMM16); PC += 2; break;
 
         ALU_CASES(0x80, 0xC6, ADD, __ADD)
         ALU_CASES(0x88, 0xCE, ADC, __ADC)
@@ -1001,6 +1182,18 @@ next:
         }
     }
 #endif
+#ifdef BLOCKCACHE
+    /* stop early when out of cycles, on an abort or when the code has
+     * branched away (only possible if the block was rewritten) */
+    if (--bcrun > 0 && !blockcache.abort
+        && (((bclen + clen) << 1) >> cpu.speed) < i
+        && (unsigned)(PC - bcpc) < bcblock->len)
+    {
+        bclen += clen;
+        goto block;
+    }
+    clen += bclen;
+#endif
         
                               
                                                 
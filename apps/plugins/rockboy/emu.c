@@ -8,6 +8,7 @@
 #include "sound.h"
 #include "rtc-gb.h"
 #include "pcm.h"
+#include "fb.h"
 #include "emu.h"
 
 /*
@@ -30,6 +31,38 @@ static void emu_step(void)
     cpu_emulate(cpu.lcdc);
 }
 
+/*
+ * emu_benchmark runs the given number of frames as fast as possible,
+ * without video, sound or input, and returns the ticks it took.
+ */
+long emu_benchmark(int frames)
+{
+    long start = *rb->current_tick;
+    int enabled = fb.enabled, sound = options.sound;
+
+    fb.enabled = 0;
+    options.sound = 0;
+
+    while (frames-- > 0 && !shut)
+    {
+        cpu_emulate(2280);
+        while (R_LY > 0 && R_LY < 144)
+            emu_step();
+
+        if (!(R_LCDC & 0x80))
+            cpu_emulate(32832);
+
+        while (R_LY > 0)
+            emu_step();
+
+        rb->yield();
+    }
+
+    fb.enabled = enabled;
+    options.sound = sound;
+    return *rb->current_tick - start;
+}
+
 /* This mess needs to be moved to another module; it's just here to
  * make things work in the mean time. */
 void emu_run(void)
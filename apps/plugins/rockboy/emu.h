@@ -1,2 +1,3 @@
 void emu_reset(void);
 void emu_run(void) ICODE_ATTR;
+long emu_benchmark(int frames);
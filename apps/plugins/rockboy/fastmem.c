@@ -2,6 +2,7 @@
 
 #include "rockmacros.h"
 #include "fastmem.h"
+#include "cpu-gb.h"
 
 byte readb(int a)
 {
@@ -13,7 +14,11 @@ byte readb(int a)
 void writeb(int a, byte b)
 {
     byte *p = mbc.wmap[a>>12];
-    if (p) p[a] = b;
+    if (p)
+    {
+        p[a] = b;
+        blockcache_written(p + a);
+    }
     else mem_write(a, b);
 }
 
@@ -44,6 +49,8 @@ void writew(int a, int w)
         byte *p = mbc.wmap[a>>12];
         if (p)
         {
+            blockcache_written(p + a);
+            blockcache_written(p + a + 1);
 #ifdef ROCKBOX_LITTLE_ENDIAN
 #ifndef ALLOW_UNALIGNED_IO
             if (a&1)
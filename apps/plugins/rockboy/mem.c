@@ -6,6 +6,7 @@
 #include "hw.h"
 #include "regs.h"
 #include "mem.h"
+#include "cpu-gb.h"
 #include "rtc-gb.h"
 #include "lcd-gb.h"
 #include "lcdc.h"
@@ -86,6 +87,7 @@ void mem_updatemap(void)
     map[0xD] = ram.ibank[n?n:1] - 0xD000;
     map[0xE] = ram.ibank[0] - 0xE000; // XXX
     map[0xF] = NULL;
+    blockcache_abort();
 }
 #pragma GCC diagnostic pop
 
@@ -453,6 +455,7 @@ void mem_write(int a, byte b)
     case 0x8:
         /* if ((R_STAT & 0x03) == 0x03) break; */
         vram_write(a & 0x1FFF, b);
+        blockcache_written(&lcd.vbank[R_VBK&1][a & 0x1FFF]);
         break;
     case 0xA:
         if (!mbc.enableram) break;
@@ -462,15 +465,18 @@ void mem_write(int a, byte b)
             break;
         }
         ram.sbank[mbc.rambank][a & 0x1FFF] = b;
+        blockcache_written(&ram.sbank[mbc.rambank][a & 0x1FFF]);
         break;
     case 0xC:
         if ((a & 0xF000) == 0xC000)
         {
             ram.ibank[0][a & 0x0FFF] = b;
+            blockcache_written(&ram.ibank[0][a & 0x0FFF]);
             break;
         }
         n = R_SVBK & 0x07;
         ram.ibank[n?n:1][a & 0x0FFF] = b;
+        blockcache_written(&ram.ibank[n?n:1][a & 0x0FFF]);
         break;
     case 0xE:
         if (a < 0xFE00)
@@ -485,6 +491,8 @@ void mem_write(int a, byte b)
             break;
         }
         /* return writehi(a & 0xFF, b); */
+        if ((a & 0xFF80) != 0xFF80 || a == 0xFFFF)
+            blockcache_abort();
         if (a >= 0xFF10 && a <= 0xFF3F)
         {
             if(options.sound)
@@ -544,6 +552,8 @@ byte mem_read(int a)
             return 0xFF;
         }
         /* return readhi(a & 0xFF); */
+        if ((a & 0xFF80) != 0xFF80 || a == 0xFFFF)
+            blockcache_abort();
         if (a == 0xFFFF) return REG(0xFF);
         if (a >= 0xFF10 && a <= 0xFF3F)
         {
@@ -13,6 +13,7 @@
 #include "pcm.h"
 #include "emu.h"
 #include "loader.h"
+#include "cpu-gb.h"
 
 #define SLOT_COUNT  50
 #define DESC_SIZE   20
@@ -20,11 +21,16 @@
 /* load/save state function declarations */
 static void do_opt_menu(void);
 static void do_slot_menu(bool is_load);
+static void do_benchmark(void);
 static void munge_name(char *buf, size_t bufsiz);
 
 /* directory ROM save slots belong in */
 #define STATE_DIR ROCKBOX_DIR "/rockboy"
 
+/* the benchmark parks the running game here while it plays */
+#define BENCH_STATE STATE_DIR "/benchmark.rbs"
+#define BENCH_FRAMES 1200
+
 static int getbutton(char *text)
 {
     int fw, fh;
@@ -91,7 +97,7 @@ int do_user_menu(void) {
 
     MENUITEM_STRINGLIST(menu, "Rockboy Menu", NULL,
                         "Load Game", "Save Game",
-                        "Options", "Reset", "Quit");
+                        "Options", "Reset", "Benchmark", "Quit");
 
     rockboy_pcm_init();
 
@@ -114,7 +120,10 @@ int do_user_menu(void) {
                 emu_reset();
                 done=true;
                 break;
-            case 4: /* Quit */
+            case 4: /* Benchmark */
+                do_benchmark();
+                break;
+            case 5: /* Quit */
                 ret = USER_MENU_QUIT;
                 if(options.autosave) sn_save();
                 done=true;
@@ -144,6 +153,86 @@ int do_user_menu(void) {
     return ret;
 }
 
+/*
+ * do_benchmark - time emulation of the current game without video or sound
+ *
+ * Each pass starts from the same saved state; with the block cache
+ * available the game is run once interpreted and once through the cache.
+ * The game is put back where it was afterwards.
+ */
+static void do_benchmark(void)
+{
+    static const char * const names[] = { "Interpreter", "Block cache" };
+    long ticks[2], fps;
+    int fd, pass, passes = 1, line = 0;
+#ifdef BLOCKCACHE
+    int cached = blockcache.enabled;
+
+    if (cached)
+        passes = 2;
+#endif
+
+    if ((fd = open(BENCH_STATE, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
+    {
+        rb->splash(HZ, "Cannot save state");
+        return;
+    }
+    savestate(fd);
+    close(fd);
+
+    rb->splash(0, "Running benchmark...");
+    for (pass = 0; pass < passes; pass++)
+    {
+        if ((fd = open(BENCH_STATE, O_RDONLY)) >= 0)
+        {
+            loadstate(fd);
+            close(fd);
+        }
+#ifdef BLOCKCACHE
+        blockcache.enabled = pass;
+        blockcache.hits = blockcache.misses = 0;
+        blockcache.retranslations = blockcache.flushes = 0;
+        blockcache_flush();
+#endif
+        ticks[pass] = emu_benchmark(BENCH_FRAMES);
+    }
+
+    if ((fd = open(BENCH_STATE, O_RDONLY)) >= 0)
+    {
+        loadstate(fd);
+        close(fd);
+    }
+    rb->remove(BENCH_STATE);
+#ifdef BLOCKCACHE
+    blockcache.enabled = cached;
+#endif
+
+    rb->lcd_setfont(FONT_SYSFIXED);
+    rb->lcd_clear_display();
+    rb->lcd_putsf(0, line++, "%d frames", BENCH_FRAMES);
+    for (pass = 0; pass < passes; pass++)
+    {
+        fps = ticks[pass] ? BENCH_FRAMES * HZ * 10L / ticks[pass] : 0;
+        rb->lcd_putsf(0, line++, "%s: %ld.%ld fps", names[pass],
+                      fps / 10, fps % 10);
+    }
+#ifdef BLOCKCACHE
+    if (cached)
+    {
+        rb->lcd_putsf(0, line++, "Hits: %lu", blockcache.hits);
+        rb->lcd_putsf(0, line++, "Misses: %lu", blockcache.misses);
+        rb->lcd_putsf(0, line++, "Retranslated: %lu",
+                      blockcache.retranslations);
+        rb->lcd_putsf(0, line++, "Flushes: %lu", blockcache.flushes);
+    }
+#endif
+    rb->lcd_update();
+
+    while (rb->button_get(false) != BUTTON_NONE)
+        rb->yield();
+    rb->button_get(true);
+}
+
 /*
  * munge_name - munge a string into a filesystem-safe name
  */
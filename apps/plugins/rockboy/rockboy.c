@@ -25,6 +25,7 @@
 #include "input.h"
 #include "emu.h"
 #include "hw.h"
+#include "cpu-gb.h"
 #include "pcm.h"
 
 int shut,cleanshut;
@@ -547,6 +548,9 @@ static int gnuboy_main(const char *rom)
     loader_init(rom);
     if(shut)
         return PLUGIN_ERROR;
+#ifdef BLOCKCACHE
+    blockcache_init();
+#endif
     rb->lcd_puts(0,3,"Emu reset");
     emu_reset();
     rb->lcd_puts(0,4,"Emu run");
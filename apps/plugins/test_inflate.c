@@ -0,0 +1,170 @@
+/*****************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _// __ \_/ ___\|  |/ /| __ \ / __ \  \/  /
+ *   Jukebox    |    |   ( (__) )  \___|    ( | \_\ ( (__) )    (
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * In-memory inflate benchmark. Decompresses a .gz file repeatedly and
+ * reports the decode throughput.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+#include "plugin.h"
+
+/* gzip file to time when none is given */
+#define DEFAULT_FILE HOME_DIR "/test_inflate.gz"
+
+static int output_y = 0;
+static int font_h;
+
+#define lcd_printf(...) \
+do { \
+    rb->lcd_putsxyf(0, output_y, __VA_ARGS__); \
+    rb->lcd_update_rect(0, output_y, LCD_WIDTH, font_h); \
+    output_y += font_h; \
+} while (0)
+
+/* inflate the whole file once; with no output buffer only the size is
+ * counted, which isolates the decoder from the cost of the stores */
+static int run_inflate(void *state, unsigned char *in, size_t in_size,
+                       unsigned char *out, size_t out_size, size_t *len)
+{
+    struct inflate_bufferctx rctx = {
+        .buf = in,
+        .end = in + in_size,
+    };
+    int ret;
+
+    if (out)
+    {
+        struct inflate_bufferctx wctx = {
+            .buf = out,
+            .end = out + out_size,
+        };
+        ret = rb->inflate(state, INFLATE_GZIP,
+                          rb->inflate_buffer_reader, &rctx,
+                          rb->inflate_buffer_writer, &wctx);
+        *len = (unsigned char *)wctx.buf - out;
+    }
+    else
+    {
+        *len = 0;
+        ret = rb->inflate(state, INFLATE_GZIP,
+                          rb->inflate_buffer_reader, &rctx,
+                          rb->inflate_getsize_writer, len);
+    }
+
+    return ret;
+}
+
+static void time_inflate(const char *name, void *state,
+                         unsigned char *in, size_t in_size,
+                         unsigned char *out, size_t out_size)
+{
+    long t1, t2, t_end;
+    int count = 0;
+    size_t len;
+
+    lcd_printf("timing %s", name);
+    t2 = *(rb->current_tick);
+    while (t2 != (t1 = *(rb->current_tick)));
+    t_end = t1 + 10 * HZ;
+    do {
+        if (run_inflate(state, in, in_size, out, out_size, &len))
+        {
+            lcd_printf("inflate failed");
+            return;
+        }
+        count++;
+        t2 = *(rb->current_tick);
+    } while (TIME_BEFORE(t2, t_end) || count < 10);
+    t2 -= t1;
+
+    /* KiB of output per second */
+    unsigned long kib = (unsigned long)((uint64_t)len * count * HZ /
+                                        (t2 ? t2 : 1) / 1024);
+    lcd_printf("%d runs, %lu KiB/s", count, kib);
+}
+
+/* this is the plugin entry point */
+enum plugin_status plugin_start(const void* parameter)
+{
+    size_t plugin_buf_len;
+    unsigned char * plugin_buf =
+        (unsigned char *)rb->plugin_get_buffer(&plugin_buf_len);
+    static char filename[MAX_PATH];
+    size_t out_len;
+
+    rb->strlcpy(filename, parameter ? parameter : DEFAULT_FILE,
+                sizeof(filename));
+    rb->lcd_set_drawmode(DRMODE_SOLID|DRMODE_INVERSEVID);
+    rb->lcd_fillrect(0, 0, LCD_WIDTH, LCD_HEIGHT);
+    rb->lcd_set_drawmode(DRMODE_SOLID);
+    rb->lcd_getstringsize("A", NULL, &font_h);
+
+    /* decoder state first, then the compressed file, then the output */
+    void *state = plugin_buf;
+    size_t state_size = *rb->inflate_size + *rb->inflate_align - 1;
+    if (state_size > plugin_buf_len)
+    {
+        lcd_printf("out of memory");
+        goto wait;
+    }
+    ALIGN_BUFFER(state, state_size, *rb->inflate_align);
+    plugin_buf += state_size;
+    plugin_buf_len -= state_size;
+
+    int fd = rb->open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        lcd_printf("can't open %s", filename);
+        goto wait;
+    }
+    unsigned long filesize = rb->filesize(fd);
+    if (filesize > plugin_buf_len)
+    {
+        rb->close(fd);
+        lcd_printf("file too large");
+        goto wait;
+    }
+    plugin_buf_len -= filesize;
+    unsigned char *gz_buf = plugin_buf;
+    plugin_buf += filesize;
+    rb->read(fd, gz_buf, filesize);
+    rb->close(fd);
+
+    if (run_inflate(state, gz_buf, filesize, NULL, 0, &out_len))
+    {
+        lcd_printf("not a valid gzip file");
+        goto wait;
+    }
+    lcd_printf("%lu -> %lu bytes", filesize, (unsigned long)out_len);
+
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(true);
+#endif
+    time_inflate("size only", state, gz_buf, filesize, NULL, 0);
+    if (out_len <= plugin_buf_len)
+        time_inflate("to memory", state, gz_buf, filesize,
+                     plugin_buf, plugin_buf_len);
+    else
+        lcd_printf("output too large for memory test");
+#ifdef HAVE_ADJUSTABLE_CPU_FREQ
+    rb->cpu_boost(false);
+#endif
+
+wait:
+    while (rb->get_action(CONTEXT_STD,1) != ACTION_STD_OK) rb->yield();
+    return PLUGIN_OK;
+}
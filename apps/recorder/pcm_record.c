@@ -74,6 +74,7 @@
  * PANIC_SECONDS:     Flood watermark time until full
  * FLUSH_SECONDS:     Flush watermark time until full
  * STREAM_BUF_SIZE:   Size of stream write buffer
+ * STREAM_WR_ALIGN:   File offset alignment of buffered stream writes
  * PRIO_SECONDS:      Max flush time before prio boost
  *
  * Total PCM buffer size should be mem aligned
@@ -95,6 +96,7 @@
 #else /* MEMORYSIZE > 16 */
 #define PANIC_SECONDS           8
 #define FLUSH_SECONDS          10
+#define STREAM_BUF_SIZE    262144
 #endif /* MEMORYSIZE */
 
 /* Default values if not overridden above */
@@ -113,6 +115,9 @@
 #ifndef STREAM_BUF_SIZE
 #define STREAM_BUF_SIZE     65536
 #endif
+#ifndef STREAM_WR_ALIGN
+#define STREAM_WR_ALIGN      4096
+#endif
 #ifndef PRIO_SECONDS
 #define PRIO_SECONDS           10
 #endif
@@ -238,6 +243,7 @@ static size_t         enc_buflen;       /* Length of buffer in slots       */
 
 static unsigned char *stream_buffer;    /* Stream-to-disk write buffer     */
 static ssize_t        stream_buf_used;  /* Stream write buffer occupancy   */
+static off_t          stream_pos;       /* File offset of stream buffer    */
 
 static struct enc_chunk_file *fname_buf;/* Buffer with next file to create */
 
@@ -808,28 +814,43 @@ static inline void stream_discard_buf(void)
     stream_buf_used = 0;
 }
 
-/* Flush stream buffer to disk */
-static bool stream_flush_buf(void)
+/* Write the first 'size' bytes of the stream buffer to disk */
+static bool stream_write_buf(ssize_t size)
 {
-    if (stream_buf_used == 0)
+    if (size == 0)
         return true;
 
-    ssize_t rc = write(rec_fd, stream_buffer, stream_buf_used);
-
-    if (LIKELY(rc == stream_buf_used))
-    {
-        stream_discard_buf();
-        return true;
-    }
+    ssize_t rc = write(rec_fd, stream_buffer, size);
 
     if (rc > 0)
     {
-        /* Some was written; keep in sync */
+        /* Keep in sync with what was actually written */
+        stream_pos += rc;
         stream_buf_used -= rc;
         memmove(stream_buffer, stream_buffer + rc, stream_buf_used);
     }
 
-    return false;
+    return rc == size;
+}
+
+/* Flush stream buffer to disk */
+static bool stream_flush_buf(void)
+{
+    return stream_write_buf(stream_buf_used);
+}
+
+/* Flush the stream buffer only up to the last STREAM_WR_ALIGN boundary in
+ * the file; the tail stays buffered so the filesystem gets whole, aligned
+ * sectors and doesn't have to read-modify-write the ends of each write */
+static bool stream_flush_buf_aligned(void)
+{
+    ssize_t size = ((stream_pos + stream_buf_used) & ~(STREAM_WR_ALIGN - 1))
+                        - stream_pos;
+
+    if (size <= 0)
+        return stream_flush_buf();
+
+    return stream_write_buf(size);
 }
 
 /* Close the output file */
@@ -857,6 +878,7 @@ static bool open_rec_file(bool create)
     }
 
     stream_discard_buf();
+    stream_pos = 0;
     int oflags = create ? O_CREAT|O_TRUNC : 0;
     rec_fd = open(fname_buf->path, O_RDWR|oflags, 0666);
 
@@ -1972,7 +1994,12 @@ static ssize_t enc_stream_read(void *buf, size_t count)
     if (!stream_flush_buf())
         return -1;
 
-    return read(rec_fd, buf, count);
+    ssize_t rc = read(rec_fd, buf, count);
+
+    if (rc > 0)
+        stream_pos += rc;
+
+    return rc;
 }
 
 /* Seek the output steam */
@@ -1981,7 +2008,12 @@ static off_t enc_stream_lseek(off_t offset, int whence)
     if (!stream_flush_buf())
         return -1;
 
-    return lseek(rec_fd, offset, whence);
+    off_t pos = lseek(rec_fd, offset, whence);
+
+    if (pos >= 0)
+        stream_pos = pos;
+
+    return pos;
 }
 
 /* Write to the output stream */
@@ -1991,22 +2023,36 @@ static ssize_t enc_stream_write(const void *buf, size_t count)
     {
         /* Too big to buffer */
         if (stream_flush_buf())
-            return write(rec_fd, buf, count);
+        {
+            ssize_t rc = write(rec_fd, buf, count);
+
+            if (rc > 0)
+                stream_pos += rc;
+
+            return rc;
+        }
     }
 
-    if (!count)
-        return 0;
+    size_t left = count;
 
-    if (stream_buf_used + count > STREAM_BUF_SIZE)
+    while (left)
     {
-        if (!stream_flush_buf() && stream_buf_used + count > STREAM_BUF_SIZE)
-            count = STREAM_BUF_SIZE - stream_buf_used;
-    }
+        /* Top off the buffer and write it out only once full */
+        size_t n = MIN(left, STREAM_BUF_SIZE - (size_t)stream_buf_used);
 
-    memcpy(stream_buffer + stream_buf_used, buf, count);
-    stream_buf_used += count;
+        memcpy(stream_buffer + stream_buf_used, buf, n);
+        stream_buf_used += n;
+        buf += n;
+        left -= n;
 
-    return count;
+        if (stream_buf_used < STREAM_BUF_SIZE)
+            break;
+
+        if (!stream_flush_buf_aligned() && stream_buf_used == STREAM_BUF_SIZE)
+            break; /* Nothing could be written */
+    }
+
+    return count - left;
 }
 
 /* One-time init at startup */
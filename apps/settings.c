@@ -977,6 +977,9 @@ void settings_apply(bool read_disk)
             lang_core_load(buf);
             CHART("<lang_core_load");
         }
+        /* fill what's left of the ui font caches with the language's glyphs */
+        FOR_NB_SCREENS(i)
+            lang_prewarm_font(screens[i].getuifont());
         CHART(">talk_init");
         talk_init(); /* use voice of same language */
         CHART("<talk_init");
@@ -1012,6 +1015,7 @@ void settings_apply(bool read_disk)
 #ifdef HAVE_CROSSFADE
     audio_set_crossfade(global_settings.crossfade);
 #endif
+    audio_set_track_predecode(global_settings.track_predecode);
     replaygain_update();
     dsp_set_crossfeed_type(global_settings.crossfeed);
     dsp_set_crossfeed_direct_gain(global_settings.crossfeed_direct_gain);
@@ -1032,6 +1036,7 @@ void settings_apply(bool read_disk)
     dsp_surround_mix(global_settings.surround_mix);
     dsp_surround_enable(global_settings.surround_enabled);
     dsp_afr_enable(global_settings.afr_enabled);
+    dsp_set_resample_quality(global_settings.resample_quality);
     dsp_pbe_precut(global_settings.pbe_precut);
     dsp_pbe_enable(global_settings.pbe);
 #ifdef HAVE_PITCHCONTROL
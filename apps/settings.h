@@ -899,6 +899,11 @@ struct user_settings
     (CONFIG_KEYPAD == IRIVER_H10_PAD)
     bool clear_settings_on_hold;
 #endif
+
+    /* Decoded audio kept ahead for a track change, in ms (0 = off) */
+    int track_predecode;
+
+    int resample_quality; /* enum resample_quality */
 };
 
 /** global variables **/
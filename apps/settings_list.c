@@ -1751,6 +1751,12 @@ const struct settings_list settings[] = {
                        LANG_AFR, 0,"afr enabled",
                        "off,weak,moderate,strong", dsp_afr_enable, 4,
                        ID2P(LANG_OFF), ID2P(LANG_WEAK),ID2P(LANG_MODERATE),ID2P(LANG_STRONG)),
+    /* sample rate conversion */
+    CHOICE_SETTING(F_SOUNDSETTING|F_NO_WRAP, resample_quality,
+                       LANG_RESAMPLE_QUALITY, 0, "resampler quality",
+                       "cubic,sinc16,sinc32,sinc64", dsp_set_resample_quality, 4,
+                       ID2P(LANG_RESAMPLE_CUBIC), ID2P(LANG_RESAMPLE_SINC_16),
+                       ID2P(LANG_RESAMPLE_SINC_32), ID2P(LANG_RESAMPLE_SINC_64)),
     /* PBE */
     INT_SETTING_NOWRAP(F_SOUNDSETTING, pbe,
                        LANG_PBE, 0,
@@ -2242,6 +2248,10 @@ const struct settings_list settings[] = {
     INT_SETTING(F_TIME_SETTING, resume_rewind, LANG_RESUME_REWIND, 0,
                 "resume rewind", UNIT_SEC, 0, 60, 5,
                 formatter_time_unit_0_is_off, getlang_time_unit_0_is_off, NULL),
+    TABLE_SETTING(F_TIME_SETTING, track_predecode, LANG_TRACK_PREDECODE, 0,
+                  "track change predecode", off, UNIT_MS,
+                  formatter_time_unit_0_is_off, getlang_time_unit_0_is_off,
+                  audio_set_track_predecode, 5, 0,250,500,1000,2000),
    CUSTOM_SETTING(0, root_menu_customized,
                   LANG_ROCKBOX_TITLE, /* lang string here is never actually used */
                   NULL, "root menu order",
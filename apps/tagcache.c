@@ -242,6 +242,9 @@ static const char * const tag_type_str[] = {
 /* Status information of the tagcache. */
 static struct tagcache_stat tc_stat;
 
+/* Bumped whenever something a search could see has changed. */
+static long tc_generation;
+
 /* Queue commands. */
 enum tagcache_queue {
     Q_STOP_SCAN = 0,
@@ -1850,10 +1853,12 @@ bool tagcache_search_add_clause(struct tagcache_search *tcs,
     return true;
 }
 
+static bool get_result(struct tagcache_search *tcs, bool is_numeric,
+                       IF_DIRCACHE(long flag,) char *buf, long bufsz);
+
 static bool get_next(struct tagcache_search *tcs, bool is_numeric, char *buf, long bufsz)
 {
-    struct tagfile_entry entry;
-#if defined(HAVE_TC_RAMCACHE) && defined(HAVE_DIRCACHE)
+#ifdef HAVE_DIRCACHE
     long flag = 0;
 #endif
 
@@ -1906,6 +1911,15 @@ static bool get_next(struct tagcache_search *tcs, bool is_numeric, char *buf, lo
         tcs->entry_count--;
     }
 
+    return get_result(tcs, is_numeric, IF_DIRCACHE(flag,) buf, bufsz);
+}
+
+/* Loads the result at tcs->position into buf */
+static bool get_result(struct tagcache_search *tcs, bool is_numeric,
+                       IF_DIRCACHE(long flag,) char *buf, long bufsz)
+{
+    struct tagfile_entry entry;
+
     tcs->result_seek = tcs->position;
 
     if (is_numeric)
@@ -2018,6 +2032,36 @@ bool tagcache_get_next(struct tagcache_search *tcs, char *buf, long size)
     return false;
 }
 
+/* Loads a result without walking the search: seek and idx_id are the
+ * result_seek and idx_id an earlier tagcache_get_next() returned for
+ * the same tag, while tagcache_get_generation() was unchanged. */
+bool tagcache_get_at(struct tagcache_search *tcs, int32_t seek,
+                     int32_t idx_id, char *buf, long size)
+{
+#ifdef HAVE_DIRCACHE
+    long flag = 0;
+#endif
+
+    if (!tcs->initialized || !tagcache_is_usable())
+        return false;
+
+#if defined(HAVE_TC_RAMCACHE) && defined(HAVE_DIRCACHE)
+    if (tcs->ramsearch && tcs->type == tag_filename)
+    {
+        struct index_entry idx;
+
+        if (get_index(tcs->masterfd, idx_id, &idx, true))
+            flag = idx.flag;
+    }
+#endif
+
+    tcs->position = seek;
+    tcs->idx_id = idx_id;
+
+    return get_result(tcs, TAGCACHE_IS_NUMERIC(tcs->type),
+                      IF_DIRCACHE(flag,) buf, size);
+}
+
 bool tagcache_retrieve(struct tagcache_search *tcs, int idxid,
                        int tag, char *buf, long size)
 {
@@ -3519,6 +3563,7 @@ void tagcache_commit_finalize(void)
 {
     tc_stat.ready = check_all_headers();
     tc_stat.readyvalid = true;
+    tc_generation++;
 }
 
 #if !defined(PLUGIN)
@@ -3539,6 +3584,7 @@ static bool modify_numeric_entry(int masterfd, int idx_id, int tag, long data)
 
     idx.tag_seek[tag] = data;
     idx.flag |= FLAG_DIRTYNUM;
+    tc_generation++;
 
     return write_index(masterfd, idx_id, &idx);
 }
@@ -3671,6 +3717,7 @@ long tagcache_increase_serial(void)
         sleep(1);
 
     old = current_tcmh.serial++;
+    tc_generation++;
     queue_command(CMD_UPDATE_MASTER_HEADER, 0, 0, 0);
 
     return old;
@@ -4010,6 +4057,7 @@ static bool delete_entry(long idx_id)
     int in_use[TAG_COUNT];
 
     logf("delete_entry(): %ld", idx_id);
+    tc_generation++;
 
 #ifdef HAVE_TC_RAMCACHE
     /* At first mark the entry removed from ram cache. */
@@ -5345,6 +5393,11 @@ static int get_progress(void)
         return processed_dir_count * 100 / total_count;
 }
 
+long tagcache_get_generation(void)
+{
+    return tc_generation;
+}
+
 struct tagcache_stat* tagcache_get_stat(void)
 {
     tc_stat.total_entries = current_tcmh.tch.entry_count;
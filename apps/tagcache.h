@@ -177,6 +177,8 @@ bool tagcache_search_add_filter(struct tagcache_search *tcs,
 bool tagcache_search_add_clause(struct tagcache_search *tcs,
                                 struct tagcache_search_clause *clause);
 bool tagcache_get_next(struct tagcache_search *tcs, char *buf, long size);
+bool tagcache_get_at(struct tagcache_search *tcs, int32_t seek,
+                     int32_t idx_id, char *buf, long size);
 bool tagcache_retrieve(struct tagcache_search *tcs, int idxid, 
                        int tag, char *buf, long size);
 void tagcache_search_finish(struct tagcache_search *tcs);
@@ -189,6 +191,7 @@ bool tagcache_modify_numeric_entry(struct tagcache_search *tcs,
                                    int tag, long data);
 
 struct tagcache_stat* tagcache_get_stat(void);
+long tagcache_get_generation(void);
 int tagcache_get_commit_step(void);
 bool tagcache_prepare_shutdown(void);
 void tagcache_shutdown(void);
@@ -217,6 +217,105 @@ static int extra_history[MAX_DIR_LEVELS];
 static int tagtree_handle;
 static size_t tagtree_bufsize, tagtree_buf_used;
 
+/* Result cache: all results of a browse level in search order, so that
+ * going back up to a level or paging through it doesn't rerun the search.
+ * One slot per level, indexed by c->currextra.
+ *
+ * The rows of all levels share one pool, allocated when the first cache is
+ * built and sized for the database then, twice its entries for a few
+ * stacked levels. It only takes memory that is free anyway and is given
+ * back whenever buflib needs room. Slots are stacked: a slot's rows follow
+ * those of the slots before it, and (re)filling a slot drops the ones after
+ * it, which were reached through it anyway. Results that don't fit fall
+ * back to searching. */
+#define RCACHE_MAX_ROWS MIN(MEMORYSIZE * 4096, 128 * 1024)
+
+struct rcache_row {
+    int32_t seek;       /* tcs.result_seek */
+    int32_t idx_id;     /* tcs.idx_id */
+};
+
+static int rcache_handle;   /* the rows, pinned while a search uses them */
+static int rcache_pool_rows;
+
+static struct rcache {
+    bool valid;
+    int first;          /* first row in the pool */
+    int count;
+    long generation;    /* tagcache_get_generation() when built */
+    ptrdiff_t si;       /* csi, relative to the tagtree buffer (it moves) */
+    int table;
+    int level;
+    int parent[MAX_TAGS]; /* csi->result_seek[] leading to this level */
+} rcache[MAX_TAGS];
+
+static void rcache_free(struct rcache *rc)
+{
+    rc->valid = false;
+}
+
+/* Drops all levels and the pool */
+static void rcache_flush(void)
+{
+    for (int i = 0; i < MAX_TAGS; i++)
+        rcache_free(&rcache[i]);
+
+    if (rcache_handle > 0)
+        rcache_handle = core_free(rcache_handle);
+    rcache_pool_rows = 0;
+}
+
+static int rcache_move_callback(int handle, void* current, void* new)
+{
+    (void)handle; (void)current; (void)new;
+    return BUFLIB_CB_OK;
+}
+
+static int rcache_shrink_callback(int handle, unsigned hints,
+                                  void* start, size_t old_size)
+{
+    (void)hints; (void)start; (void)old_size;
+
+    if (core_pin_count(handle) > 0)
+        return BUFLIB_CB_CANNOT_SHRINK;
+
+    rcache_flush();
+    return BUFLIB_CB_OK;
+}
+
+static struct buflib_callbacks rcache_ops = {
+    .move_callback = rcache_move_callback,
+    .shrink_callback = rcache_shrink_callback,
+};
+
+static bool rcache_alloc(void)
+{
+    size_t rows = MIN(tagcache_get_stat()->total_entries * 2,
+                      RCACHE_MAX_ROWS);
+
+    /* don't make anyone else shrink for it */
+    rows = MIN(rows, core_allocatable() / 2 / sizeof(struct rcache_row));
+    if (rows == 0)
+        return false;
+
+    rcache_handle = core_alloc_ex(rows * sizeof(struct rcache_row),
+                                  &rcache_ops);
+    if (rcache_handle <= 0)
+    {
+        rcache_handle = 0;
+        return false;
+    }
+
+    rcache_pool_rows = rows;
+    return true;
+}
+
+/* Only valid while rcache_handle is pinned */
+static struct rcache_row *rcache_rows(void)
+{
+    return core_get_data(rcache_handle);
+}
+
 #define UPDATE(x, y) { x = (typeof(x))((char*)(x) + (y)); }
 static int move_callback(int handle, void* current, void* new)
 {
@@ -860,6 +959,14 @@ static int compare(const void *p1, const void *p2)
     return qsort_fn(e1->name, e2->name, MAX_PATH);
 }
 
+/* strnatkey() flags matching qsort_fn */
+static unsigned key_flags;
+
+static size_t make_key(const struct entry *e, char *key, size_t size)
+{
+    return strnatkey(key, e->name, size, key_flags);
+}
+
 static void tagtree_buffer_event(unsigned short id, void *ev_data)
 {
     (void)id;
@@ -1227,6 +1334,7 @@ static void tagtree_unload(struct tree_context *c)
 
     remove_event(PLAYBACK_EVENT_TRACK_BUFFER, tagtree_buffer_event);
     remove_event(PLAYBACK_EVENT_TRACK_FINISH, tagtree_track_finish_event);
+    rcache_flush();
 
     if (c)
     {
@@ -1446,6 +1554,90 @@ static void tcs_get_basename(struct tagcache_search *tcs, bool is_basename)
     }
 }
 
+static bool rcache_match(const struct rcache *rc, int table, int level)
+{
+    if (!rc->valid || rc->generation != tagcache_get_generation()
+        || rc->si != (char *)csi - (char *)core_get_data(tagtree_handle)
+        || rc->table != table || rc->level != level)
+        return false;
+
+    for (int i = 0; i < level; i++)
+    {
+        if (rc->parent[i] != csi->result_seek[i])
+            return false;
+    }
+
+    return true;
+}
+
+/* slot is c->currextra, one past the search level for ALLSUBENTRIES */
+static struct rcache *rcache_init(int slot, int table, int level)
+{
+    struct rcache *rc = &rcache[slot];
+    int first = 0;
+
+    for (int i = slot - 1; i >= 0; i--)
+    {
+        if (rcache[i].valid)
+        {
+            first = rcache[i].first + rcache[i].count;
+            break;
+        }
+    }
+
+    for (int i = slot + 1; i < MAX_TAGS; i++)
+        rcache_free(&rcache[i]);
+
+    if (rcache_handle <= 0 && !rcache_alloc())
+        return NULL;
+
+    if (first >= rcache_pool_rows)
+        return NULL;
+
+    rc->first = first;
+    rc->count = 0;
+    rc->generation = tagcache_get_generation();
+    rc->si = (char *)csi - (char *)core_get_data(tagtree_handle);
+    rc->table = table;
+    rc->level = level;
+    for (int i = 0; i < level; i++)
+        rc->parent[i] = csi->result_seek[i];
+
+    return rc;
+}
+
+/* Appends the current result, gives up on the level when out of room */
+static struct rcache *rcache_add(struct rcache *rc,
+                                 const struct tagcache_search *tcs)
+{
+    if (!rc)
+        return NULL;
+
+    if (rc->first + rc->count >= rcache_pool_rows)
+    {
+        logf("rcache full: %d", rc->count);
+        rcache_free(rc);
+        return NULL;
+    }
+
+    struct rcache_row *row = &rcache_rows()[rc->first + rc->count++];
+    row->seek = tcs->result_seek;
+    row->idx_id = tcs->idx_id;
+
+    return rc;
+}
+
+static bool rcache_get_next(struct rcache *rc, int n,
+                            struct tagcache_search *tcs, char *buf, long size)
+{
+    if (n >= rc->count)
+        return false;
+
+    const struct rcache_row *row = &rcache_rows()[rc->first + n];
+
+    return tagcache_get_at(tcs, row->seek, row->idx_id, buf, size);
+}
+
 static int retrieve_entries(struct tree_context *c, int offset, bool init)
 {
     char tcs_buf[TAGCACHE_BUFSZ];
@@ -1463,6 +1655,11 @@ static int retrieve_entries(struct tree_context *c, int offset, bool init)
     bool is_basename = false;
     int sort_limit;
     int strip;
+    struct rcache *rc_hit = NULL;
+    struct rcache *rc_new = NULL;
+    bool rc_pinned = false;
+    int first_row;
+    int row = 0;
 
     /* Show search progress straight away if the disk needs to spin up,
        otherwise show it after the normal 1/2 second delay */
@@ -1534,6 +1731,26 @@ static int retrieve_entries(struct tree_context *c, int offset, bool init)
             tagcache_search_add_clause(&tcs, csi->clause[i][j]);
     }
 
+    /* Results come from the level's cache if it is still current. Only a
+     * search that runs to the end, as on init, can (re)fill it. */
+    if (c->currextra < MAX_TAGS)
+    {
+        struct rcache *rc = &rcache[c->currextra];
+
+        if (rcache_match(rc, c->currtable, level))
+            rc_hit = rc;
+        else if (init)
+        {
+            rcache_free(rc);
+            rc_new = rcache_init(c->currextra, c->currtable, level);
+        }
+
+        /* keep the rows from being given back while they are used */
+        rc_pinned = (rc_hit || rc_new);
+        if (rc_pinned)
+            core_pin(rcache_handle);
+    }
+
     current_offset = offset;
     current_entry_count = 0;
     c->dirfull = false;
@@ -1586,8 +1803,18 @@ static int retrieve_entries(struct tree_context *c, int offset, bool init)
         total_count += 2;
     }
 
-    while (tagcache_get_next(&tcs, tcs_buf, tcs_bufsz))
+    first_row = total_count;
+    if (rc_hit)
+    {
+        row = MAX(0, offset - first_row);
+        total_count += row;
+    }
+
+    while (rc_hit ? rcache_get_next(rc_hit, row++, &tcs, tcs_buf, tcs_bufsz)
+                  : tagcache_get_next(&tcs, tcs_buf, tcs_bufsz))
     {
+        rc_new = rcache_add(rc_new, &tcs);
+
         if (total_count++ < offset)
             continue;
 
@@ -1659,9 +1886,13 @@ static int retrieve_entries(struct tree_context *c, int offset, bool init)
                     }
 
                     logf("format_str() failed");
+                    if (rc_new)
+                        rcache_free(rc_new);
                     tagcache_search_finish(&tcs);
                     tree_unlock_cache(c);
                     core_unpin(tagtree_handle);
+                    if (rc_pinned)
+                        core_unpin(rcache_handle);
                     return 0;
                 }
             }
@@ -1701,9 +1932,13 @@ entry_skip_formatter:
         {
             if (!show_search_progress(false, total_count))
             {   /* user aborted */
+                if (rc_new)
+                    rcache_free(rc_new);
                 tagcache_search_finish(&tcs);
                 tree_unlock_cache(c);
                 core_unpin(tagtree_handle);
+                if (rc_pinned)
+                    core_unpin(rcache_handle);
                 return current_entry_count;
             }
         }
@@ -1716,11 +1951,20 @@ entry_skip_formatter:
         else
             qsort_fn = sort_inverse ? strncasecmp_inv : strncasecmp;
 
+        key_flags = STRNATKEY_CASEFOLD;
+        if (global_settings.interpret_numbers)
+            key_flags |= STRNATKEY_NUMBERS;
+        if (sort_inverse)
+            key_flags |= STRNATKEY_REVERSE;
+
         struct tagentry *entries = get_entries(c);
-        qsort(&entries[special_entry_count],
-              current_entry_count - special_entry_count,
-              sizeof(struct tagentry),
-              compare);
+        if (!tree_sort_by_key(c, (struct entry *)&entries[special_entry_count],
+                              current_entry_count - special_entry_count,
+                              namebufused, make_key))
+            qsort(&entries[special_entry_count],
+                  current_entry_count - special_entry_count,
+                  sizeof(struct tagentry),
+                  compare);
     }
 
     if (!init)
@@ -1728,19 +1972,34 @@ entry_skip_formatter:
         tagcache_search_finish(&tcs);
         tree_unlock_cache(c);
         core_unpin(tagtree_handle);
+        if (rc_pinned)
+            core_unpin(rcache_handle);
         return current_entry_count;
     }
 
-    while (tagcache_get_next(&tcs, tcs_buf, tcs_bufsz))
+    if (rc_hit)
+        total_count = first_row + rc_hit->count;
+    else while (tagcache_get_next(&tcs, tcs_buf, tcs_bufsz))
     {
         if (!show_search_progress(false, total_count))
+        {
+            if (rc_new)
+                rcache_free(rc_new);
+            rc_new = NULL;
             break;
+        }
+        rc_new = rcache_add(rc_new, &tcs);
         total_count++;
     }
 
     tagcache_search_finish(&tcs);
     tree_unlock_cache(c);
     core_unpin(tagtree_handle);
+    if (rc_pinned)
+        core_unpin(rcache_handle);
+
+    if (rc_new)
+        rc_new->valid = true;
 
     if (!sort && (sort_inverse || sort_limit))
     {
@@ -1966,6 +2225,8 @@ int tagtree_enter(struct tree_context* c, bool is_visible)
                         /* discard history for lower levels when doing runtime searches */
                         if (is_visible)
                             max_history_level = c->dirlevel - 1;
+                        /* ...and cached results, the clause is about to change */
+                        rcache_flush();
 
                         searchstring=csi->clause[i][j]->str;
                         *searchstring = '\0';
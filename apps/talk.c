@@ -133,13 +133,26 @@ struct queue_entry /* one entry of the internal queue */
 static struct buflib_context clip_ctx;
 
 struct clip_cache_metadata {
-    long tick;
-    int handle, voice_id;
+    int handle;
+    int voice_id;    /* next free slot while handle is 0 */
+    int uses;        /* recent uses, aged by each pass of the eviction sweep */
+    bool prefetched; /* loaded ahead of time and not spoken since */
 };
 
+#define CLIP_USES_MAX 3
+
 static int metadata_table_handle;
+/* maps each voice file index to its cache slot + 1, 0 if not cached */
+static int slot_map_handle;
 static unsigned max_clips;
+static int free_slot;        /* head of the free slot list, -1 if full */
+static unsigned clock_hand;  /* next slot the eviction sweep looks at */
+static int thumb_clips;      /* thumbnails currently in the cache */
 static int cache_hits, cache_misses;
+static int clip_loads;
+static long load_ticks, load_ticks_max;
+static int prefetch_loads, prefetch_hits;
+static enum talk_prefetch prefetch_mode = TALK_PREFETCH_OFF;
 
 static struct queue_entry queue[QUEUE_SIZE]; /* queue of scheduled clips */
 static struct queue_entry silence, *last_clip;
@@ -301,76 +314,100 @@ static int index2id(int index)
 }
 #endif
 
-static int free_oldest_clip(void)
+static bool clip_is_queued(int handle)
+{
+    for (int i = queue_read; i != queue_write; i = (i + 1) & QUEUE_MASK)
+        if (queue[i].handle == handle)
+            return true;
+    return false;
+}
+
+/* Frees one cached clip and returns its slot, -1 if none can be freed.
+ * Thumbnails go first as they are rarely spoken twice. Otherwise the
+ * sweep takes the first clip whose use count has aged down to zero, which
+ * keeps the frequently spoken menu clips around. The silence clip and
+ * clips still waiting in the queue are never freed. */
+static int free_clip(void)
 {
-    unsigned i;
-    int oldest = 0;
-    bool thumb = false;
-    long age, now, next_age;
     struct clip_entry* clipbuf;
+    uint16_t *slot_map;
     struct clip_cache_metadata *cc = buflib_get_data(&clip_ctx, metadata_table_handle);
-    for(age = i = 0, now = current_tick; i < max_clips; i++)
+    int slot = -1;
+    unsigned i, n;
+
+    if (thumb_clips > 0)
     {
-        if (cc[i].handle)
+        for (i = 0; i < max_clips && slot < 0; i++)
         {
-            next_age = (now - cc[i].tick);
-            if (thumb && cc[i].voice_id == VOICEONLY_DELIMITER && next_age > age)
-            {
-                /* thumb clips are freed first */
-                age = now - cc[i].tick;
-                oldest = i;
-            }
-            else if (!thumb)
-            {
-                if (cc[i].voice_id == VOICEONLY_DELIMITER)
-                {
-                    age = next_age;
-                    oldest = i;
-                    thumb = true;
-                }
-                else if (next_age > age && cc[i].voice_id != VOICE_PAUSE)
-                {
-                    /* find the last-used clip but never consider silence */
-                    age = next_age;
-                    oldest = i;
-                }
-            }
+            if (cc[i].handle > 0 && cc[i].voice_id == VOICEONLY_DELIMITER
+                && !clip_is_queued(cc[i].handle))
+                slot = i;
         }
     }
-    /* free the last one if no oldest one could be determined */
-    cc = &cc[oldest];
-    cc->handle = buflib_free(&clip_ctx, cc->handle);
-    /* need to clear the LOADED bit too (not for thumb clips) */
-    if (cc->voice_id != VOICEONLY_DELIMITER)
+
+    /* every full pass ages each clip by one so this is bounded */
+    for (n = 0; n < max_clips * (CLIP_USES_MAX + 1) && slot < 0; n++)
     {
+        i = clock_hand;
+        clock_hand = (clock_hand + 1) % max_clips;
+        if (cc[i].handle <= 0 || cc[i].voice_id == VOICE_PAUSE
+            || cc[i].voice_id == VOICEONLY_DELIMITER)
+            continue;
+        if (cc[i].uses > 0)
+            cc[i].uses--;
+        else if (!clip_is_queued(cc[i].handle))
+            slot = i;
+    }
+
+    if (slot < 0)
+        return -1;
+
+    cc = &cc[slot];
+    buflib_free(&clip_ctx, cc->handle);
+    if (cc->voice_id == VOICEONLY_DELIMITER)
+        thumb_clips--;
+    else
+    {   /* need to clear the LOADED bit too (not for thumb clips) */
+        int index = id2index(cc->voice_id);
         clipbuf = core_get_data(index_handle);
-        clipbuf[id2index(cc->voice_id)].size &= ~LOADED_MASK;
+        clipbuf[index].size &= ~LOADED_MASK;
+        slot_map = buflib_get_data(&clip_ctx, slot_map_handle);
+        slot_map[index] = 0;
     }
-    return oldest;
+    cc->handle = 0;
+    cc->voice_id = free_slot;
+    free_slot = slot;
+    return slot;
 }
 
-/* common code for load_initial_clips() and get_clip() */
-static void add_cache_entry(int clip_handle, int table_index, int id)
+/* make sure there is a free slot for add_cache_entry() */
+static bool reserve_cache_slot(void)
+{
+    return free_slot >= 0 || free_clip() >= 0;
+}
+
+/* common code for load_initial_clips(), get_clip() and _talk_file() */
+static void add_cache_entry(int clip_handle, int id)
 {
-    unsigned i;
     struct clip_cache_metadata *cc = buflib_get_data(&clip_ctx, metadata_table_handle);
+    int slot = free_slot;
 
-    if (table_index != -1)
-    {
-        /* explicit slot; use that */
-        cc = &cc[table_index];
-        if (cc->handle > 0) panicf("%s(): Slot already used", __func__);
-    }
-    else
-    {   /* find an empty slot */
-        for(i = 0; cc[i].handle && i < max_clips; i++) ;
-        if (i == max_clips) /* no free slot in the cache table? */
-            i = free_oldest_clip();
-        cc = &cc[i];
-    }
+    if (slot < 0)
+        panicf("%s(): No free slot", __func__);
+
+    cc = &cc[slot];
+    free_slot = cc->voice_id;
     cc->handle = clip_handle;
-    cc->tick = current_tick;
     cc->voice_id = id;
+    cc->prefetched = prefetch_mode != TALK_PREFETCH_OFF;
+    cc->uses = cc->prefetched ? 0 : 1;
+    if (id == VOICEONLY_DELIMITER)
+        thumb_clips++;
+    else
+    {
+        uint16_t *slot_map = buflib_get_data(&clip_ctx, slot_map_handle);
+        slot_map[id2index(id)] = slot + 1;
+    }
 }
 
 static ssize_t read_clip_data(int fd, int index, int clip_handle)
@@ -429,7 +466,8 @@ static void load_initial_clips(int fd)
         if (ret < 0)
             break;
 
-        add_cache_entry(handle, i++, index2id(index));
+        add_cache_entry(handle, index2id(index));
+        i++;
     }
 #endif
 }
@@ -453,12 +491,21 @@ static int get_clip(long id, struct queue_entry *q)
 
     if (!(clipsize & LOADED_MASK))
     {   /* clip needs loading */
-        int fd, handle, oldest = -1;
+        int fd, handle;
         ssize_t ret;
-        cache_misses++;
+        long load_start = current_tick;
+        if (prefetch_mode != TALK_PREFETCH_OFF)
+            prefetch_loads++;
+        else
+            cache_misses++;
         /* free clips from cache until this one succeeds to allocate */
+        if (!reserve_cache_slot())
+            return -1;
         while ((handle = buflib_alloc(&clip_ctx, clipsize)) < 0)
-            oldest = free_oldest_clip();
+        {
+            if (free_clip() < 0)
+                return -1;
+        }
         /* handle should now hold a valid alloc. Load from disk
          * and insert into cache */
         fd = open_voicefile();
@@ -467,19 +514,31 @@ static int get_clip(long id, struct queue_entry *q)
         if (ret < 0)
             return ret;
         /* finally insert into metadata table */
-        add_cache_entry(handle, oldest, id);
+        add_cache_entry(handle, id);
         retval = handle;
+
+        clip_loads++;
+        load_start = current_tick - load_start;
+        load_ticks += load_start;
+        if (load_start > load_ticks_max)
+            load_ticks_max = load_start;
     }
     else
-    {   /* clip is in memory already; find where it was loaded */
-        cache_hits++;
-        struct clip_cache_metadata *cc;
-        static int i;
-        cc = buflib_get_data(&clip_ctx, metadata_table_handle);
-        for (i = 0; cc[i].voice_id != id || !cc[i].handle; i++) ;
-        cc[i].tick = current_tick; /* reset age */
+    {   /* clip is in memory already; the slot map says where */
+        uint16_t *slot_map = buflib_get_data(&clip_ctx, slot_map_handle);
+        struct clip_cache_metadata *cc = buflib_get_data(&clip_ctx, metadata_table_handle);
+        cc = &cc[slot_map[index] - 1];
+        if (prefetch_mode == TALK_PREFETCH_OFF)
+        {
+            cache_hits++;
+            if (cc->prefetched)
+                prefetch_hits++;
+            cc->prefetched = false;
+            if (cc->uses < CLIP_USES_MAX)
+                cc->uses++;
+        }
         clipsize &= ~LOADED_MASK; /* without the extra bit gives true size */
-        retval = cc[i].handle;
+        retval = cc->handle;
     }
 
     q->handle    = retval;
@@ -613,7 +672,10 @@ static bool load_voicefile_data(int fd)
      * other allocs succeed without disabling voice which would require
      * reloading the voice from disk (as we do not shrink our buffer when
      * other code attempts new allocs these would fail) */
-    size_t metadata_alloc_size;
+    size_t metadata_alloc_size, slot_map_size;
+    struct clip_cache_metadata *cc;
+    struct clip_entry *clipbuf;
+    int num_clips = index_handle > 0 ? voicefile.id1_max + voicefile.id2_max : 0;
     ssize_t cap = MIN(MAX_CLIP_BUFFER_SIZE, audio_buffer_available() - (64<<10));
     if (UNLIKELY(cap < 0))
     {
@@ -638,7 +700,33 @@ static bool load_voicefile_data(int fd)
         talk_status = TALK_STATUS_ERR_OOM;
         return false;
     }
-    memset(buflib_get_data(&clip_ctx, metadata_table_handle), 0, metadata_alloc_size);
+    /* thread the free slot list through the empty table */
+    cc = buflib_get_data(&clip_ctx, metadata_table_handle);
+    memset(cc, 0, metadata_alloc_size);
+    for (unsigned i = 0; i < max_clips; i++)
+        cc[i].voice_id = i + 1 < max_clips ? (int)i + 1 : -1;
+    free_slot = max_clips ? 0 : -1;
+    clock_hand = 0;
+    thumb_clips = 0;
+
+    /* without voicefile only thumbnails are cached, they need no map */
+    slot_map_handle = 0;
+    if (num_clips > 0)
+    {
+        slot_map_size = num_clips * sizeof(uint16_t);
+        slot_map_handle = buflib_alloc(&clip_ctx, slot_map_size);
+        if (slot_map_handle <= 0)
+        {
+            talk_status = TALK_STATUS_ERR_OOM;
+            return false;
+        }
+        memset(buflib_get_data(&clip_ctx, slot_map_handle), 0, slot_map_size);
+
+        /* the index may outlive the clip buffer, nothing is loaded anymore */
+        clipbuf = core_get_data(index_handle);
+        for (int i = 0; i < num_clips; i++)
+            clipbuf[i].size &= ~LOADED_MASK;
+    }
 
     load_initial_clips(fd);
     /* make sure to have the silence clip, if available return value can
@@ -744,7 +832,7 @@ static bool talk_is_disabled(void)
 
 static void do_enqueue(bool enqueue)
 {
-    if (!enqueue)
+    if (!enqueue && prefetch_mode == TALK_PREFETCH_OFF)
         talk_shutup(); /* cut off all the pending stuff */
 }
 
@@ -838,7 +926,7 @@ void talk_force_shutup(void)
 /* Shutup the voice, except if force_enqueue_next is set. */
 void talk_shutup(void)
 {
-    if (need_shutup && !force_enqueue_next)
+    if (need_shutup && !force_enqueue_next && prefetch_mode == TALK_PREFETCH_OFF)
         talk_force_shutup();
 }
 
@@ -848,6 +936,9 @@ static void queue_clip(struct queue_entry *clip, bool enqueue)
     struct queue_entry *qe;
     int queue_level;
 
+    if (prefetch_mode != TALK_PREFETCH_OFF)
+        return; /* the clip is cached now, that's all we wanted */
+
     do_enqueue(enqueue);  /* cut off all the pending stuff */
 
     /* Something is being enqueued, force_enqueue_next override is no
@@ -959,9 +1050,11 @@ void talk_init(void)
         max_clips = 16;
         voicefile_size = THUMBNAIL_RESERVE;
     }
-    /* additionally to the clip we need a table to record the age of the clips
-     * so that, when memory is tight, only the most recently used ones are kept */
+    /* additionally to the clip we need a table to record the use of the clips
+     * so that, when memory is tight, only the frequently used ones are kept */
     voicefile_size += sizeof(struct clip_cache_metadata) * max_clips;
+    /* and a map to find a cached clip by its index */
+    voicefile_size += sizeof(uint16_t) * (voicefile.id1_max + voicefile.id2_max);
     /* compensate a bit for buflib alloc overhead. */
     voicefile_size += BUFLIB_ALLOC_OVERHEAD * max_clips + 64;
 
@@ -1063,7 +1156,20 @@ int talk_idarray(const long *ids, bool enqueue)
 /* Make sure the current utterance is not interrupted by the next one. */
 void talk_force_enqueue_next(void)
 {
-    force_enqueue_next = true;
+    if (prefetch_mode == TALK_PREFETCH_OFF)
+        force_enqueue_next = true;
+}
+
+/* While prefetching the talk functions only load the clips they would
+ * speak into the cache; nothing is queued and nothing is cut off */
+void talk_prefetch(enum talk_prefetch mode)
+{
+    prefetch_mode = mode;
+}
+
+enum talk_prefetch talk_get_prefetch(void)
+{
+    return prefetch_mode;
 }
 
 /* play a thumbnail from file */
@@ -1075,11 +1181,13 @@ static int _talk_file(const char* filename,
     int fd;
     int size;
     int handle = -1;
-    int oldest = -1;
 
     /* reload needed? */
     if (talk_is_disabled())
         return -1;
+    /* thumbnails aren't kept around long enough to be worth prefetching */
+    if (prefetch_mode != TALK_PREFETCH_OFF)
+        return 0;
     if (talk_handle <= 0 || index_handle <= 0)
     {
         fd = open_voicefile();
@@ -1098,14 +1206,22 @@ static int _talk_file(const char* filename,
     }
     size = filesize(fd);
 
-    if (size > 0)
+    if (size > 0 && reserve_cache_slot())
     {
         /* free clips from cache until this one succeeds to allocate */
         while ((handle = buflib_alloc(&clip_ctx, size)) < 0)
-            oldest = free_oldest_clip();
+        {
+            if (free_clip() < 0)
+                break;
+        }
 
-        size = read_to_handle_ex(fd, &clip_ctx, handle, 0, size);
+        if (handle >= 0)
+            size = read_to_handle_ex(fd, &clip_ctx, handle, 0, size);
+        else
+            size = 0;
     }
+    else
+        size = 0;
 
     close(fd);
 
@@ -1124,10 +1240,10 @@ static int _talk_file(const char* filename,
         /* finally insert into metadata table. thumb clips go under the
          * VOICEONLY_DELIMITER id so the cache can distinguish them from
          * normal clips */
-        add_cache_entry(handle, oldest, VOICEONLY_DELIMITER);
+        add_cache_entry(handle, VOICEONLY_DELIMITER);
         queue_clip(&clip, true);
     }
-    else
+    else if (handle >= 0)
         buflib_free(&clip_ctx, handle);
 
     return size;
@@ -1696,6 +1812,11 @@ bool talk_get_debug_data(struct talk_debug_data *data)
     data->cached_clips = cached;
     data->cache_hits   = cache_hits;
     data->cache_misses = cache_misses;
+    data->clip_loads     = clip_loads;
+    data->load_ticks     = load_ticks;
+    data->load_ticks_max = load_ticks_max;
+    data->prefetch_loads = prefetch_loads;
+    data->prefetch_hits  = prefetch_hits;
 
     return true;
 }
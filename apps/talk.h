@@ -71,6 +71,13 @@ enum talk_speakmode {
     TALK_SPEAK_SPELL
 };
 
+/* what the list is prefetching clips for, see talk_prefetch() */
+enum talk_prefetch {
+    TALK_PREFETCH_OFF = 0,
+    TALK_PREFETCH_ITEM,       /* neighbours of the selected item */
+    TALK_PREFETCH_NEXT_LEVEL, /* items of the selected submenu */
+};
+
 #define UNIT_SHIFT (32-5) /* this many bits left from UNIT_xx enum */
 
 #define DECIMAL_SHIFT (32 - 8)
@@ -154,6 +161,10 @@ int talk_time_intervals(long time, int unit_idx, bool enqueue);
 /* Enqueue next utterance even if enqueue parameter is false: don't
    interrupt the current utterance. */
 void talk_force_enqueue_next(void);
+/* Load the clips of whatever is spoken next into the cache without
+   speaking them, until called again with TALK_PREFETCH_OFF. */
+void talk_prefetch(enum talk_prefetch mode);
+enum talk_prefetch talk_get_prefetch(void);
 
 /* speaks one or more IDs (from an array)). */
 int talk_idarray(const long *idarray, bool enqueue);
@@ -190,6 +201,9 @@ struct talk_debug_data {
     int  cached_clips;
     int  cache_hits;
     int  cache_misses;
+    int  clip_loads;
+    long load_ticks, load_ticks_max;
+    int  prefetch_loads, prefetch_hits;
     enum talk_status status;
 };
 
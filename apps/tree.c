@@ -205,6 +205,9 @@ static int tree_voice_cb(int selected_item, void * data)
     struct tree_context * local_tc=(struct tree_context *)data;
     char *name;
     int attr=0;
+    /* the contents of a directory aren't known before entering it */
+    if (talk_get_prefetch() == TALK_PREFETCH_NEXT_LEVEL)
+        return 0;
 #ifdef HAVE_TAGCACHE
     bool id3db = *(local_tc->dirfilter) == SHOW_ID3DB;
     char buf[AVERAGE_FILENAME_LENGTH*2];
@@ -354,6 +357,52 @@ void tree_unlock_cache(struct tree_context *t)
     core_unpin(t->cache.entries_handle);
 }
 
+static int compare_keys(const void *p1, const void *p2)
+{
+    const struct entry *e1 = p1;
+    const struct entry *e2 = p2;
+    return strcmp(e1->name, e2->name);
+}
+
+/* Sorts entries (struct entry or anything sharing its size and name member)
+ * by collation keys built once per entry in the unused tail of the name
+ * buffer, so each comparison is a plain strcmp(). While sorting, name points
+ * to the key and the real name pointer is stored just before it.
+ * The cache must be locked. Returns false, leaving the entries untouched,
+ * if the keys don't fit. */
+bool tree_sort_by_key(struct tree_context *t, struct entry *entries,
+                      int count, size_t name_buffer_used, tree_key_fn make_key)
+{
+    char *buf = core_get_data(t->cache.name_buffer_handle);
+    size_t pos = ALIGN_UP(name_buffer_used, sizeof(char *));
+    size_t size = t->cache.name_buffer_size;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (pos + sizeof(char *) >= size)
+            break;
+
+        char *key = buf + pos + sizeof(char *);
+        size_t len = make_key(&entries[i], key, size - pos - sizeof(char *));
+        if (len >= size - pos - sizeof(char *))
+            break;
+
+        memcpy(key - sizeof(char *), &entries[i].name, sizeof(char *));
+        entries[i].name = key;
+        pos = ALIGN_UP(pos + sizeof(char *) + len + 1, sizeof(char *));
+    }
+
+    bool sorted = (i == count);
+    if (sorted)
+        qsort(entries, count, sizeof(struct entry), compare_keys);
+
+    while (i--)
+        memcpy(&entries[i].name, entries[i].name - sizeof(char *), sizeof(char *));
+
+    return sorted;
+}
+
 /*
  * Returns the position of a given file in the current directory
  * returns -1 if not found
@@ -117,6 +117,11 @@ void resume_directory(const char *dir);
 void tree_lock_cache(struct tree_context *t);
 void tree_unlock_cache(struct tree_context *t);
 
+/* make_key writes the collation key of an entry, returns its length */
+typedef size_t (*tree_key_fn)(const struct entry *e, char *key, size_t size);
+bool tree_sort_by_key(struct tree_context *t, struct entry *entries,
+                      int count, size_t name_buffer_used, tree_key_fn make_key);
+
 #ifdef WIN32
 /* it takes an int on windows */
 #define getcwd_size_t int
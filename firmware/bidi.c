@@ -135,7 +135,63 @@ static void arabjoin(unsigned short * stringprt, int length)
 }
 #endif /* !BOOTLOADER */
 
+#ifndef BOOTLOADER
+/* Lists redraw and scroll the same few lines over and over, so the visual
+ * order of short strings is kept instead of being worked out each time */
+#define SHAPED_CACHE_STRLEN 64
+#if MEMORYSIZE > 2
+#define SHAPED_CACHE_ENTRIES 32
+#else
+#define SHAPED_CACHE_ENTRIES 12
+#endif
+
+static struct shaped_entry {
+    unsigned char len; /* of str, 0 if unused */
+    unsigned char orientation;
+    unsigned char str[SHAPED_CACHE_STRLEN];
+    unsigned short ucs[SHAPED_CACHE_STRLEN];
+} shaped_cache[SHAPED_CACHE_ENTRIES];
+static int shaped_next; /* entry to be replaced next */
+
+static unsigned short *l2v(const unsigned char *str, int orientation);
+
 unsigned short *bidi_l2v(const unsigned char *str, int orientation)
+{
+    size_t len = strlen((const char *)str);
+    unsigned short *ucs;
+    struct shaped_entry *e;
+
+    if (len == 0 || len >= SHAPED_CACHE_STRLEN)
+        return l2v(str, orientation);
+
+    for (e = shaped_cache; e < &shaped_cache[SHAPED_CACHE_ENTRIES]; e++)
+    {
+        if (e->len == len && e->orientation == orientation
+            && !memcmp(e->str, str, len))
+            return e->ucs;
+    }
+
+    ucs = l2v(str, orientation);
+
+    /* a string of len bytes never has more than len characters */
+    e = &shaped_cache[shaped_next];
+    shaped_next = (shaped_next + 1) % SHAPED_CACHE_ENTRIES;
+    e->len = len;
+    e->orientation = orientation;
+    memcpy(e->str, str, len);
+    for (size_t i = 0; i <= len; i++)
+    {
+        e->ucs[i] = ucs[i];
+        if (!ucs[i])
+            break;
+    }
+    return e->ucs;
+}
+
+static unsigned short *l2v(const unsigned char *str, int orientation)
+#else /* BOOTLOADER */
+unsigned short *bidi_l2v(const unsigned char *str, int orientation)
+#endif
 {
     static unsigned short  utf16_buf[SCROLL_LINE_SIZE];
     unsigned short *target, *tmp;
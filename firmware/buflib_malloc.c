@@ -147,6 +147,14 @@ bool buflib_shrink(struct buflib_context *ctx, int handle,
     return true;
 }
 
+void buflib_get_stats(struct buflib_context *ctx, struct buflib_stats *stats)
+{
+    /* nothing is ever moved and malloc() keeps its own books */
+    memset(stats, 0, sizeof(*stats));
+    stats->free_bytes = ctx->bufsize;
+    stats->largest_free = ctx->bufsize;
+}
+
 void buflib_pin(struct buflib_context *ctx, int handle)
 {
     struct buflib_malloc_handle *h = get_handle(ctx, handle);
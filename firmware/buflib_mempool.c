@@ -81,6 +81,17 @@
  * The allocator functions are passed a context struct so that two allocators
  * can be run, for example, one per core may be used, with convenience wrappers
  * for the single-allocator case that use a predefined context.
+ *
+ * Small free blocks (see BUFLIB_SC_MAX_LEN) are additionally linked into
+ * doubly-linked lists by size class, the links being stored in the free
+ * block itself:
+ *
+ * |-L|next|prev|YYYY|
+ *
+ * Every small free block below alloc_end is on its list while sc_valid is
+ * set. Operations that rewrite the pool wholesale (compaction, shrinking,
+ * shifting) clear sc_valid and the lists are rebuilt on demand with a single
+ * walk of the pool.
  */
 
 #define B_ALIGN_DOWN(x) \
@@ -117,6 +128,7 @@ struct buflib_callbacks buflib_ops_locked = {
     (!a[BUFLIB_IDX_OPS].ops || a[BUFLIB_IDX_OPS].ops->move_callback)
 
 static union buflib_data* find_first_free(struct buflib_context *ctx);
+static void sc_rebuild(struct buflib_context *ctx);
 static union buflib_data* find_block_before(struct buflib_context *ctx,
                                             union buflib_data* block,
                                             bool is_free);
@@ -160,6 +172,12 @@ buflib_init(struct buflib_context *ctx, void *buf, size_t size)
      */
     ctx->alloc_end = bd_buf;
     ctx->compact = true;
+    ctx->sc_valid = true;
+    memset(ctx->sc_lists, 0, sizeof(ctx->sc_lists));
+    ctx->compactions = 0;
+    ctx->compactions_skipped = 0;
+    ctx->bytes_moved = 0;
+    ctx->sc_hits = 0;
 
     if (size == 0)
     {
@@ -190,6 +208,7 @@ bool buflib_context_relocate(struct buflib_context *ctx, void *buf)
     ctx->first_free_handle  += diff;
     ctx->buf_start          += diff;
     ctx->alloc_end          += diff;
+    ctx->sc_valid            = false;
 
     return true;
 }
@@ -207,6 +226,93 @@ static void buflib_panic(struct buflib_context *ctx, const char *message, ...)
         (ctx->handle_table - ctx->buf_start) * sizeof(union buflib_data), buf);
 }
 
+/* Upper length limit of each size class, excluding the block header */
+static const unsigned char sc_limits[BUFLIB_NUM_SIZE_CLASSES] =
+    { 2, 4, 8, 12, 16, 24, 32, 64 };
+
+/* Return the size class for a block length in units, -1 if not small */
+static int size_class(intptr_t len)
+{
+    if (len < BUFLIB_SC_MIN_LEN || len > BUFLIB_SC_MAX_LEN)
+        return -1;
+
+    len -= BUFLIB_NUM_FIELDS;
+
+    int c = 0;
+    while (len > sc_limits[c])
+        c++;
+
+    return c;
+}
+
+#define SC_NEXT(block) ((block)[1].handle)
+#define SC_PREV(block) ((block)[2].handle)
+
+/* Put a free block on its size class list */
+static void sc_insert(struct buflib_context *ctx, union buflib_data *block)
+{
+    int c = size_class(-block->val);
+    if (c < 0 || !ctx->sc_valid)
+        return;
+
+    union buflib_data *head = ctx->sc_lists[c];
+    SC_NEXT(block) = head;
+    SC_PREV(block) = NULL;
+    if (head)
+        SC_PREV(head) = block;
+    ctx->sc_lists[c] = block;
+}
+
+/* Take a free block off its size class list; must be done before the
+ * block's length is changed */
+static void sc_remove(struct buflib_context *ctx, union buflib_data *block)
+{
+    int c = size_class(-block->val);
+    if (c < 0 || !ctx->sc_valid)
+        return;
+
+    union buflib_data *next = SC_NEXT(block), *prev = SC_PREV(block);
+    if (next)
+        SC_PREV(next) = prev;
+    if (prev)
+        SC_NEXT(prev) = next;
+    else
+        ctx->sc_lists[c] = next;
+}
+
+/* Find a free block of at least size units from the size class lists,
+ * preferring the smallest class that can hold it */
+static union buflib_data* sc_find(struct buflib_context *ctx, size_t size)
+{
+    for (int c = size_class(size); c < BUFLIB_NUM_SIZE_CLASSES; c++)
+    {
+        for (union buflib_data *block = ctx->sc_lists[c]; block;
+             block = SC_NEXT(block))
+        {
+            if ((size_t)-block->val >= size)
+                return block;
+        }
+    }
+
+    return NULL;
+}
+
+/* Rebuild the size class lists by walking the pool */
+static void sc_rebuild(struct buflib_context *ctx)
+{
+    memset(ctx->sc_lists, 0, sizeof(ctx->sc_lists));
+    ctx->sc_valid = true;
+
+    for (union buflib_data *block = find_first_free(ctx);
+         block < ctx->alloc_end;
+         block += abs(block->val))
+    {
+        check_block_length(ctx, block);
+        if (block->val < 0)
+            sc_insert(ctx, block);
+    }
+}
+
 /* Allocate a new handle, returning 0 on failure */
 static inline
 union buflib_data* handle_alloc(struct buflib_context *ctx)
@@ -333,6 +439,7 @@ move_block(struct buflib_context* ctx, union buflib_data* block, int shift)
     {
         h_entry->alloc = new_start; /* update handle table */
         memmove(new_block, block, block->val * sizeof(union buflib_data));
+        ctx->bytes_moved += new_block->val * sizeof(union buflib_data);
         retval = true;
     }
 
@@ -354,6 +461,9 @@ buflib_compact(struct buflib_context *ctx)
     int shift = 0, len;
     /* Store the results of attempting to shrink the handle table */
     bool ret = handle_table_shrink(ctx);
+    /* free blocks are about to be overwritten, so are their list links */
+    ctx->sc_valid = false;
+    ctx->compactions++;
     /* compaction has basically two modes of operation:
      *  1) the buffer is nicely movable: In this mode, blocks can be simply
      * moved towards the beginning. Free blocks add to a shift value,
@@ -424,21 +534,86 @@ buflib_compact(struct buflib_context *ctx)
      */
     ctx->alloc_end += shift;
     ctx->compact = true;
+    sc_rebuild(ctx);
     return ret || shift;
 }
 
+/* Return true if compaction cannot possibly create a contiguous free area of
+ * 'wanted' units. Blocks that are unmovable or pinned split the pool into
+ * regions; a region can at most gain the free space of the other regions,
+ * so if no region could reach the wanted size, moving blocks around is
+ * wasted effort and only shrinking can help.
+ */
+static bool
+compaction_futile(struct buflib_context *ctx, size_t wanted)
+{
+    size_t total_free = ctx->last_handle - ctx->alloc_end;
+    union buflib_data *block;
+
+    for (block = find_first_free(ctx); block < ctx->alloc_end;
+         block += abs(block->val))
+    {
+        check_block_length(ctx, block);
+        if (block->val < 0)
+            total_free += -block->val;
+    }
+
+    if (total_free < wanted)
+        return true;
+
+    size_t rgn_free = 0, rgn_movable = 0;
+    for (block = ctx->buf_start;; block += abs(block->val))
+    {
+        bool end = block >= ctx->alloc_end;
+
+        if (end || (block->val > 0 && (!IS_MOVABLE(block) ||
+                                       block[BUFLIB_IDX_PIN].pincount > 0)))
+        {
+            if (end)
+                rgn_free += ctx->last_handle - ctx->alloc_end;
+
+            size_t reach = rgn_free +
+                           MIN(rgn_movable, total_free - rgn_free);
+            if (reach >= wanted)
+                return false;
+
+            if (end)
+                break;
+
+            rgn_free = rgn_movable = 0;
+        }
+        else if (block->val < 0)
+            rgn_free += -block->val;
+        else
+            rgn_movable += block->val;
+    }
+
+    return true;
+}
+
 /* Compact the buffer by trying both shrinking and moving.
  *
  * Try to move first. If unsuccesfull, try to shrink. If that was successful
  * try to move once more as there might be more room now.
+ *
+ * 'wanted' is the size in units of a buffer allocation that needs a
+ * contiguous free area; moving is skipped if it cannot produce one. Pass 0
+ * when compaction may help in other ways, as for room for the handle table.
  */
 static bool
-buflib_compact_and_shrink(struct buflib_context *ctx, unsigned shrink_hints)
+buflib_compact_and_shrink(struct buflib_context *ctx, unsigned shrink_hints,
+                          size_t wanted)
 {
     bool result = false;
     /* if something compacted before already there will be no further gain */
     if (!ctx->compact)
-        result = buflib_compact(ctx);
+    {
+        /* don't shuffle memory for an allocation that cannot fit anyway */
+        if (wanted && compaction_futile(ctx, wanted))
+            ctx->compactions_skipped++;
+        else
+            result = buflib_compact(ctx);
+    }
     if (!result)
     {
         union buflib_data *this, *before;
@@ -511,6 +686,7 @@ buflib_buffer_shift(struct buflib_context *ctx, int shift)
         (ctx->alloc_end - ctx->buf_start) * sizeof(union buflib_data));
     ctx->buf_start += shift;
     ctx->alloc_end += shift;
+    ctx->sc_valid = false;
     shift *= sizeof(union buflib_data);
     union buflib_data *handle;
     for (handle = ctx->last_handle; handle < ctx->handle_table; handle++)
@@ -602,7 +778,7 @@ handle_alloc:
         }
         /* buflib_compact_and_shrink() will compact and move last_block()
          * if possible */
-        if (buflib_compact_and_shrink(ctx, hints))
+        if (buflib_compact_and_shrink(ctx, hints, 0))
             goto handle_alloc;
         return -1;
     }
@@ -611,6 +787,24 @@ buffer_alloc:
     /* need to re-evaluate last before the loop because the last allocation
      * possibly made room in its front to fit this, so last would be wrong */
     last = false;
+
+    /* small movable allocations take the best fitting small hole if there
+     * is one; unmovable ones stay first-fit so they collect at the start of
+     * the pool rather than pinning down holes all over it */
+    if (size <= BUFLIB_SC_MAX_LEN && (!ops || ops->move_callback))
+    {
+        if (!ctx->sc_valid)
+            sc_rebuild(ctx);
+
+        block = sc_find(ctx, size);
+        if (block)
+        {
+            block_len = -block->val;
+            ctx->sc_hits++;
+            goto found_block;
+        }
+    }
+
     for (block = find_first_free(ctx);; block += block_len)
     {
         /* If the last used block extends all the way to the handle table, the
@@ -645,7 +839,7 @@ buffer_alloc:
         /* Try compacting if allocation failed */
         unsigned hint = BUFLIB_SHRINK_POS_FRONT |
                     ((size*sizeof(union buflib_data))&BUFLIB_SHRINK_SIZE_MASK);
-        if (buflib_compact_and_shrink(ctx, hint))
+        if (buflib_compact_and_shrink(ctx, hint, size))
         {
             goto buffer_alloc;
         } else {
@@ -654,6 +848,10 @@ buffer_alloc:
         }
     }
 
+found_block:
+    if (!last)
+        sc_remove(ctx, block);
+
     /* Set up the allocated block, by marking the size allocated, and storing
      * a pointer to the handle.
      */
@@ -673,7 +871,10 @@ buffer_alloc:
         ctx->alloc_end = block;
     /* Only free blocks *before* alloc_end have tagged length. */
     else if ((size_t)block_len > size)
+    {
         block->val = size - block_len;
+        sc_insert(ctx, block);
+    }
     /* Return the handle index as a positive integer. */
     return ctx->handle_table - handle;
 }
@@ -735,6 +936,7 @@ buflib_free(struct buflib_context *ctx, int handle_num)
     block = find_block_before(ctx, freed_block, true);
     if (block)
     {
+        sc_remove(ctx, block);
         block->val -= freed_block->val;
     }
     else
@@ -756,7 +958,11 @@ buflib_free(struct buflib_context *ctx, int handle_num)
     else {
         ctx->compact = false;
         if (next_block->val < 0)
+        {
+            sc_remove(ctx, next_block);
             block->val += next_block->val;
+        }
+        sc_insert(ctx, block);
     }
     handle_free(ctx, handle);
     handle->alloc = NULL;
@@ -868,7 +1074,7 @@ buflib_alloc_maximum(struct buflib_context* ctx, size_t *size, struct buflib_cal
      * welcome to give up some or all of their memory */
     hints = BUFLIB_SHRINK_POS_BACK | BUFLIB_SHRINK_POS_FRONT | bufsize;
     /* compact until no space can be gained anymore */
-    while (buflib_compact_and_shrink(ctx, hints));
+    while (buflib_compact_and_shrink(ctx, hints, 0));
 
     *size = buflib_allocatable(ctx);
     if (*size <= 0) /* OOM */
@@ -904,6 +1110,9 @@ buflib_shrink(struct buflib_context* ctx, int handle, void* new_start, size_t ne
     if (new_next_block > old_next_block)
         return false;
 
+    /* free blocks around this one may be merged or created */
+    ctx->sc_valid = false;
+
     metadata_size.val = aligned_oldstart - block;
     /* update val and the handle table entry */
     new_block = aligned_newstart - metadata_size.val;
@@ -949,6 +1158,35 @@ buflib_shrink(struct buflib_context* ctx, int handle, void* new_start, size_t ne
     return true;
 }
 
+void buflib_get_stats(struct buflib_context *ctx, struct buflib_stats *stats)
+{
+    size_t free_space = 0, largest = 0;
+    unsigned int free_blocks = 0;
+
+    for(union buflib_data *block = find_first_free(ctx);
+        block < ctx->alloc_end;
+        block += abs(block->val))
+    {
+        check_block_length(ctx, block);
+        if (block->val < 0)
+        {
+            free_space += -block->val;
+            largest = MAX(largest, (size_t)-block->val);
+            free_blocks++;
+        }
+    }
+
+    stats->free_bytes = free_space * sizeof(union buflib_data) +
+                        free_space_at_end(ctx);
+    stats->largest_free = MAX(largest * sizeof(union buflib_data),
+                              free_space_at_end(ctx));
+    stats->free_blocks = free_blocks;
+    stats->compactions = ctx->compactions;
+    stats->compactions_skipped = ctx->compactions_skipped;
+    stats->bytes_moved = ctx->bytes_moved;
+    stats->size_class_hits = ctx->sc_hits;
+}
+
 void buflib_pin(struct buflib_context *ctx, int handle)
 {
     if ((BUFLIB_PARANOIA & PARANOIA_CHECK_PINNING) && handle <= 0)
@@ -19,6 +19,7 @@
  *
  ****************************************************************************/
 #include "config.h"
+#include <string.h>
 #include "debug.h"
 #include "system.h"
 #include "linked_list.h"
@@ -55,6 +56,12 @@
  *             001001 <- collision
  *             000000
  * volume map  111101 <- entry usage by the volume (OR of all map entries)
+ *
+ * With DC_CLUSTERED_IO, the client may read a run of sectors following a
+ * miss into the run buffer and hand them back with dc_cache_fill(). Those
+ * entries are flagged until first probed so the usefulness of readahead can
+ * be measured. Commits sort the dirty entries by sector and write adjacent
+ * ones through the run buffer in one request.
  */
 
 enum dce_flags /* flags for each cache entry */
@@ -62,6 +69,7 @@ enum dce_flags /* flags for each cache entry */
     DCE_INUSE = 0x01, /* entry in use and valid */
     DCE_DIRTY = 0x02, /* entry is dirty in need of writeback */
     DCE_BUF   = 0x04, /* entry is being used as a general buffer */
+    DCE_RA    = 0x08, /* entry was read ahead and not yet probed */
 };
 
 struct disk_cache_entry
@@ -87,6 +95,11 @@ static struct disk_cache_entry cache_entry[DC_NUM_ENTRIES];
 static cache_map_entry_t cache_map_entry[NUM_VOLUMES][DC_MAP_NUM_ENTRIES];
 static cache_map_entry_t cache_vol_map[NUM_VOLUMES] IBSS_ATTR;
 static uint8_t cache_buffer[DC_NUM_ENTRIES][DC_CACHE_BUFSIZE] CACHEALIGN_ATTR;
+#ifdef DC_CLUSTERED_IO
+static uint8_t run_buffer[DC_MAX_RUN][DC_CACHE_BUFSIZE] CACHEALIGN_ATTR;
+static unsigned int cache_lru_count; /* number of entries on the LRU list */
+#endif
+static struct dc_stats cache_stats;
 struct mutex disk_cache_mutex SHAREDBSS_ATTR;
 
 #define CACHE_MAP_ENTRY(volume, mapnum) \
@@ -151,6 +164,9 @@ static struct disk_cache_entry * cache_remove_lru_entry(void)
 
     /* remove it; next-LRU becomes the LRU */
     lldc_remove(&cache_lru, lru);
+#ifdef DC_CLUSTERED_IO
+    cache_lru_count--;
+#endif
     return NODE_DCE(lru);
 }
 
@@ -158,6 +174,9 @@ static struct disk_cache_entry * cache_remove_lru_entry(void)
 static void cache_return_lru_entry(struct disk_cache_entry *fce)
 {
     lldc_insert_first(&cache_lru, &fce->node);
+#ifdef DC_CLUSTERED_IO
+    cache_lru_count++;
+#endif
 }
 
 /* discard the entry's data and mark it unused */
@@ -169,32 +188,33 @@ static inline void cache_discard_entry(struct disk_cache_entry *dce,
     dce->flags = 0;
 }
 
-/* search the cache for the specified sector, returning a buffer, either
-   to the specified sector, if it exists, or a new/evicted entry that must
-   be filled */
-void * dc_cache_probe(IF_MV(int volume,) unsigned long sector,
-                      unsigned int *flagsp)
+/* find the entry caching the specified sector, if any */
+static struct disk_cache_entry * cache_find_entry(IF_MV(int volume,)
+                                                  unsigned long sector)
 {
-    unsigned int mapnum = map_sector(sector);
-
-    FOR_EACH_BITARRAY_SET_BIT(&CACHE_MAP_ENTRY(volume, mapnum), index)
+    FOR_EACH_BITARRAY_SET_BIT(&CACHE_MAP_ENTRY(volume, map_sector(sector)),
+                              index)
     {
         struct disk_cache_entry *dce = &cache_entry[index];
 
         if (dce->sector == sector)
-        {
-            *flagsp = DCE_INUSE;
-            touch_cache_entry(dce);
-            return cache_buffer[index];
-        }
+            return dce;
     }
 
-    /* sector not found so the LRU is the victim */
+    return NULL;
+}
+
+/* evict the LRU entry, making it the MRU and assigning it the specified
+   sector */
+static struct disk_cache_entry * cache_claim_lru_entry(IF_MV(int volume,)
+                                                       unsigned long sector)
+{
+    unsigned int mapnum = map_sector(sector);
+
     struct disk_cache_entry *dce = DCE_LRU();
     cache_lru.head = dce->node.next;
 
     unsigned int index = DCIDX_FROM_DCE(dce);
-    void *buf = cache_buffer[index];
     unsigned int old_flags = dce->flags;
 
     if (old_flags)
@@ -204,7 +224,15 @@ void * dc_cache_probe(IF_MV(int volume,) unsigned long sector,
         unsigned int old_mapnum = map_sector(sector);
 
         if (old_flags & DCE_DIRTY)
-            dc_writeback_callback(IF_MV(old_volume,) sector, buf);
+        {
+            dc_writeback_callback(IF_MV(old_volume,) sector, 1,
+                                  cache_buffer[index]);
+            cache_stats.wb_sectors++;
+            cache_stats.wb_requests++;
+        }
+
+        if (old_flags & DCE_RA)
+            cache_stats.ra_wasted++;
 
         if (mapnum == old_mapnum IF_MV( && volume == old_volume ))
             goto finish_setup;
@@ -221,10 +249,101 @@ finish_setup:
 #endif
     dce->sector = sector;
 
-    *flagsp = 0;
-    return buf;
+    return dce;
+}
+
+/* search the cache for the specified sector, returning a buffer, either
+   to the specified sector, if it exists, or a new/evicted entry that must
+   be filled */
+void * dc_cache_probe(IF_MV(int volume,) unsigned long sector,
+                      unsigned int *flagsp)
+{
+    struct disk_cache_entry *dce = cache_find_entry(IF_MV(volume,) sector);
+
+    if (dce)
+    {
+        if (dce->flags & DCE_RA)
+        {
+            dce->flags &= ~DCE_RA;
+            cache_stats.ra_used++;
+        }
+
+        cache_stats.hits++;
+        *flagsp = DCE_INUSE;
+        touch_cache_entry(dce);
+    }
+    else
+    {
+        /* sector not found so the LRU is the victim */
+        cache_stats.misses++;
+        *flagsp = 0;
+        dce = cache_claim_lru_entry(IF_MV(volume,) sector);
+    }
+
+    return cache_buffer[DCIDX_FROM_DCE(dce)];
 }
 
+#ifdef DC_CLUSTERED_IO
+/* return how many sectors the client may read on a miss; readahead evicts
+   one entry per sector so it is only allowed if enough remain that buffers
+   returned by recent probes survive it */
+unsigned int dc_readahead_limit(void)
+{
+    return cache_lru_count >= 2*DC_MAX_RUN ? DC_MAX_RUN : 1;
+}
+
+/* return the buffer used for multi-sector transfers; the cache lock must be
+   held for as long as it is in use */
+void * dc_get_run_buffer(void)
+{
+    return run_buffer;
+}
+
+/* insert sectors read ahead by the client; any already cached might be newer
+   than what is on storage and are left alone */
+void dc_cache_fill(IF_MV(int volume,) unsigned long sector,
+                   unsigned int count, const void *buf)
+{
+    const uint8_t *src = buf;
+
+    for (; count; count--, sector++, src += DC_CACHE_BUFSIZE)
+    {
+        if (cache_find_entry(IF_MV(volume,) sector))
+            continue;
+
+        struct disk_cache_entry *dce =
+            cache_claim_lru_entry(IF_MV(volume,) sector);
+
+        memcpy(cache_buffer[DCIDX_FROM_DCE(dce)], src, DC_CACHE_BUFSIZE);
+        dce->flags |= DCE_RA;
+        cache_stats.ra_sectors++;
+    }
+}
+
+/* write back a run of dirty entries sorted by sector, using the run buffer
+   when more than one is adjacent */
+static void cache_writeback_run(IF_MV(int volume,) const uint8_t *indices,
+                                unsigned int count)
+{
+    unsigned long sector = cache_entry[indices[0]].sector;
+    void *buf = cache_buffer[indices[0]];
+
+    if (count > 1)
+    {
+        buf = run_buffer;
+        for (unsigned int i = 0; i < count; i++)
+            memcpy(run_buffer[i], cache_buffer[indices[i]], DC_CACHE_BUFSIZE);
+    }
+
+    dc_writeback_callback(IF_MV(volume,) sector, count, buf);
+    cache_stats.wb_sectors += count;
+    cache_stats.wb_requests++;
+
+    for (unsigned int i = 0; i < count; i++)
+        cache_entry[indices[i]].flags &= ~DCE_DIRTY;
+}
+#endif /* DC_CLUSTERED_IO */
+
 /* mark in-use cache entry as dirty by buffer */
 void dc_dirty_buf(void *buf)
 {
@@ -257,6 +376,37 @@ void dc_commit_all(IF_MV_NONVOID(int volume))
 {
     DEBUGF("dc_commit_all()\n");
 
+#ifdef DC_CLUSTERED_IO
+    /* gather the dirty entries in sector order (insertion sort; the list is
+       short and usually mostly in order already) */
+    uint8_t dirty[DC_NUM_ENTRIES];
+    unsigned int ndirty = 0;
+
+    FOR_EACH_BITARRAY_SET_BIT(&CACHE_VOL_MAP(volume), index)
+    {
+        if (!(cache_entry[index].flags & DCE_DIRTY))
+            continue;
+
+        unsigned long sector = cache_entry[index].sector;
+        unsigned int i = ndirty++;
+
+        for (; i > 0 && cache_entry[dirty[i-1]].sector > sector; i--)
+            dirty[i] = dirty[i-1];
+
+        dirty[i] = index;
+    }
+
+    /* write each run of adjacent sectors at once */
+    for (unsigned int start = 0, i = 1; start < ndirty; i++)
+    {
+        if (i < ndirty && i - start < DC_MAX_RUN &&
+            cache_entry[dirty[i]].sector == cache_entry[dirty[i-1]].sector + 1)
+            continue;
+
+        cache_writeback_run(IF_MV(volume,) &dirty[start], i - start);
+        start = i;
+    }
+#else /* !DC_CLUSTERED_IO */
     FOR_EACH_BITARRAY_SET_BIT(&CACHE_VOL_MAP(volume), index)
     {
         struct disk_cache_entry *dce = &cache_entry[index];
@@ -264,11 +414,14 @@ void dc_commit_all(IF_MV_NONVOID(int volume))
 
         if (flags & DCE_DIRTY)
         {
-            dc_writeback_callback(IF_MV(volume,) dce->sector,
+            dc_writeback_callback(IF_MV(volume,) dce->sector, 1,
                                   cache_buffer[index]);
             dce->flags = flags & ~DCE_DIRTY;
+            cache_stats.wb_sectors++;
+            cache_stats.wb_requests++;
         }
     }
+#endif /* DC_CLUSTERED_IO */
 }
 
 /* discard all cache entries from the specified volume */
@@ -299,7 +452,15 @@ void * dc_get_buffer(void)
         {
             /* must first commit this sector if dirty */
             if (flags & DCE_DIRTY)
-                dc_writeback_callback(IF_MV(dce->volume,) dce->sector, buf);
+            {
+                dc_writeback_callback(IF_MV(dce->volume,) dce->sector, 1,
+                                      buf);
+                cache_stats.wb_sectors++;
+                cache_stats.wb_requests++;
+            }
+
+            if (flags & DCE_RA)
+                cache_stats.ra_wasted++;
 
             cache_discard_entry(dce, index);
         }
@@ -333,6 +494,14 @@ void dc_release_buffer(void *buf)
     dc_unlock_cache();
 }
 
+/* copy out the cache statistics */
+void dc_get_stats(struct dc_stats *stats)
+{
+    dc_lock_cache();
+    *stats = cache_stats;
+    dc_unlock_cache();
+}
+
 /* one-time init at startup */
 void dc_init(void)
 {
@@ -340,4 +509,7 @@ void dc_init(void)
     lldc_init(&cache_lru);
     for (unsigned int i = 0; i < DC_NUM_ENTRIES; i++)
         lldc_insert_last(&cache_lru, &cache_entry[i].node);
+#ifdef DC_CLUSTERED_IO
+    cache_lru_count = DC_NUM_ENTRIES;
+#endif
 }
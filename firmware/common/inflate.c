@@ -54,17 +54,33 @@ enum {
     INFLATE_OFFSET_MAX = 32,
     INFLATE_CODELEN_MAX = 19,
     INFLATE_HUFF_BITS = 17,
-    INFLATE_FLAT_BITS = 7,
-    INFLATE_SYMBOL_BITS = 7,
-    INFLATE_OFFSET_BITS = 6,
-    INFLATE_CODELEN_BITS = 6,
+    INFLATE_FLAT_BITS = 10,
+    INFLATE_FIXED_BITS = 9,
+    INFLATE_SYMBOL_BITS = 10,
+    INFLATE_OFFSET_BITS = 9,
+    INFLATE_CODELEN_BITS = 7,
 };
 
+/* flat table entries are (symbol << 4 | code length), or (first code length
+ * to try << 4) for codes longer than the table, which then take the slow
+ * path. INFLATE_FLAT_UNUSED marks slots no code maps to. */
+#define INFLATE_FLAT_UNUSED 0xfff0
+
+/* bit buffer as wide as the registers, hosted 64-bit builds can decode a
+ * whole length/distance pair from a single refill */
+#if UINTPTR_MAX > 0xffffffff
+typedef uint64_t inflate_bitbuf;
+#else
+typedef uint32_t inflate_bitbuf;
+#endif
+
+#define INFLATE_BITBUF_BITS (sizeof(inflate_bitbuf) * 8)
+
 struct inflate_huff {
     uint32_t max_bits;
     uint32_t min_bits;
     uint32_t flat_mask;
-    uint32_t flat[1 << INFLATE_FLAT_BITS];
+    uint16_t flat[1 << INFLATE_FLAT_BITS];
     uint32_t max_code[INFLATE_HUFF_BITS];
     uint32_t last[INFLATE_HUFF_BITS];
     uint32_t decode[INFLATE_SYMBOL_MAX];
@@ -126,13 +142,46 @@ struct inflate {
     ++op;                          \
 } while (0)
 
-#define INFLATE_FILL_BITS(E,N) do { \
-    while ((N) > nbits) {           \
-        uint8_t _byte;              \
-        INFLATE_GET_BYTE(E, _byte); \
-        sreg |= (_byte << nbits);   \
-        nbits += 8;                 \
-    }                               \
+/* at the end of the input the bit buffer is topped up with zero bits, a
+ * code may be shorter than the lookahead it is decoded from. pad counts
+ * the zero bits, which sit above the real ones: once nbits drops below it,
+ * a code has used bits past the end of the stream. */
+#define INFLATE_FILL_BITS(E,N) do {                    \
+    while ((N) > nbits) {                              \
+        if (ip == ie && pad == 0) {                    \
+            const uint32_t _size = read(is, sizeof(it->in), rctx); \
+            ip = is;                                   \
+            ie = is + _size;                           \
+        }                                              \
+        if (ip == ie) {                                \
+            if (nbits < pad) {                         \
+                rv = (E);                              \
+                goto bail;                             \
+            }                                          \
+            pad += (N) - nbits;                        \
+            nbits = (N);                               \
+            break;                                     \
+        }                                              \
+        sreg |= ((inflate_bitbuf) ip[0] << nbits);     \
+        ++ip;                                          \
+        nbits += 8;                                    \
+    }                                                  \
+} while (0)
+
+/* top up the bit buffer without checking for the end of the input on every
+ * byte, falls back to INFLATE_FILL_BITS near the end of the input buffer */
+#define INFLATE_NEED_BITS(E,N) do {                            \
+    if ((N) > nbits) {                                         \
+        if ((size_t) (ie - ip) >= sizeof(inflate_bitbuf)) {    \
+            while (nbits <= INFLATE_BITBUF_BITS - 8) {         \
+                sreg |= ((inflate_bitbuf) ip[0] << nbits);     \
+                ++ip;                                          \
+                nbits += 8;                                    \
+            }                                                  \
+        } else {                                               \
+            INFLATE_FILL_BITS(E, N);                           \
+        }                                                      \
+    }                                                          \
 } while (0)
 
 #define INFLATE_CONSUME_BITS(N) do { \
@@ -161,10 +210,10 @@ struct inflate {
 #define INFLATE_DECODE(E,H) ({                            \
     __label__ _found;                                     \
     uint32_t _c = (H)->flat[sreg & (H)->flat_mask];       \
-    uint32_t _b = (_c & 0xff);                            \
+    uint32_t _b = (_c & 0x0f);                            \
     uint32_t _code;                                       \
-    if (_b == 0xff) {                                     \
-        for (_b = (_c >> 8); _b <= (H)->max_bits; _b++) { \
+    if (_b == 0) {                                        \
+        for (_b = (_c >> 4); _b <= (H)->max_bits; _b++) { \
             _c = (revtab[sreg & 0xff] << 8);              \
             _c |= (revtab[(sreg >> 8) & 0xff]);           \
             _c >>= (16 - _b);                             \
@@ -176,7 +225,7 @@ struct inflate {
         rv = (E);                                         \
         goto bail;                                        \
     }                                                     \
-    _code = (_c >> 8);                                    \
+    _code = (_c >> 4);                                    \
 _found:                                                   \
     INFLATE_CONSUME_BITS(_b);                             \
     _code;                                                \
@@ -193,7 +242,8 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
     bool flushed = false;
     uint32_t chksum;
     uint32_t nbits = 0;
-    uint32_t sreg = 0;
+    uint32_t pad = 0;
+    inflate_bitbuf sreg = 0;
     uint32_t i;
     uint32_t j;
     bool final;
@@ -348,6 +398,15 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                 goto bail;
             }
 
+            /* the bit buffer may already hold some of the stored bytes */
+            while (len != 0 && nbits != 0) {
+                uint8_t byte;
+
+                INFLATE_EXTRACT_BITS(8, byte);
+                INFLATE_PUT_BYTE(-21, byte);
+                len--;
+            }
+
             while (len != 0) {
                 if (ip == ie)
                     INFLATE_FILL(-20);
@@ -356,8 +415,7 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                     INFLATE_FLUSH(-21);
 
                 j = MIN(len, MIN((uint32_t) (ie - ip), (uint32_t) (oe - op)));
-                for (i = 0; i < j; i++)
-                    op[i] = ip[i];
+                memcpy(op, ip, j);
 
                 len -= j;
                 ip += j;
@@ -452,13 +510,13 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                 for (; i < INFLATE_SYMBOL_MAX; i++)
                     tab[0][i] = 8;
                 tab_lens[0] = INFLATE_SYMBOL_MAX;
-                tab_bits[0] = INFLATE_FLAT_BITS;
+                tab_bits[0] = INFLATE_FIXED_BITS;
 
                 tab[1] = it->off;
                 for (i = 0; i < INFLATE_OFFSET_MAX; i++)
                     tab[1][i] = 5;
                 tab_lens[1] = INFLATE_OFFSET_MAX;
-                tab_bits[1] = INFLATE_FLAT_BITS;
+                tab_bits[1] = INFLATE_FIXED_BITS;
             }
 
             for(; type != 0xff; --type) {
@@ -528,7 +586,7 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                 h->min_bits = min_bits;
 
                 for (i = 0, b = (1 << flat_bits); i < b; i++)
-                    h->flat[i] = 0xffffffff;
+                    h->flat[i] = INFLATE_FLAT_UNUSED;
 
                 for (b = max_bits; b > flat_bits; b--) {
                     code = h->max_code[b];
@@ -541,7 +599,7 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                     code >>= (b - flat_bits);
 
                     for (; min_code <= code; min_code++)
-                        h->flat[INFLATE_REVERSE(min_code, flat_bits)] = ((b << 8) | 0xff);
+                        h->flat[INFLATE_REVERSE(min_code, flat_bits)] = (b << 4);
                 }
 
                 for (i = 0; i < hb_len; i++) {
@@ -553,7 +611,7 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                     c = codes[b]++;
 
                     if (b <= flat_bits) {
-                        code = ((i << 8) | b);
+                        code = ((i << 4) | b);
                         ec = ((c + 1) << (flat_bits - b));
 
                         if (ec > (1U << flat_bits)) {
@@ -587,7 +645,7 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                         uint32_t len;
                         uint8_t byte;
 
-                        INFLATE_FILL_BITS(-28, h->max_bits);
+                        INFLATE_NEED_BITS(-28, h->max_bits);
 
                         c = INFLATE_DECODE(-29, h);
 
@@ -650,11 +708,21 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                 uint32_t off;
                 uint8_t* cp;
 
-                INFLATE_FILL_BITS(-33, tab_huffs[0]->max_bits);
+                INFLATE_NEED_BITS(-33, tab_huffs[0]->max_bits);
                 c = INFLATE_DECODE(-34, tab_huffs[0]);
 
                 if (c < 256) {
                     INFLATE_PUT_BYTE(-35, c);
+
+                    /* literal run: keep going while the next code is
+                     * already in the bit buffer and resolves in one lookup */
+                    while (nbits >= tab_huffs[0]->max_bits && op != oe) {
+                        c = tab_huffs[0]->flat[sreg & tab_huffs[0]->flat_mask];
+                        if ((c & 0x0f) == 0 || (c >> 4) >= 256)
+                            break;
+                        INFLATE_CONSUME_BITS(c & 0x0f);
+                        *op++ = (c >> 4);
+                    }
                     continue;
                 }
 
@@ -667,11 +735,11 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                 }
 
                 c -= 257;
-                INFLATE_FILL_BITS(-37, lenextra[c]);
+                INFLATE_NEED_BITS(-37, lenextra[c]);
                 INFLATE_EXTRACT_BITS(lenextra[c], len);
                 len += lenbase[c];
 
-                INFLATE_FILL_BITS(-38, tab_huffs[1]->max_bits);
+                INFLATE_NEED_BITS(-38, tab_huffs[1]->max_bits);
                 c = INFLATE_DECODE(-39, tab_huffs[1]);
 
                 if (c > 29) {
@@ -679,7 +747,7 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
                     goto bail;
                 }
 
-                INFLATE_FILL_BITS(-41, offextra[c]);
+                INFLATE_NEED_BITS(-41, offextra[c]);
                 INFLATE_EXTRACT_BITS(offextra[c], off);
                 off += offbase[c];
 
@@ -702,8 +770,17 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
 
                     j = MIN(len, MIN((uint32_t) (oe - op), (uint32_t) (oe - cp)));
 
-                    for (i = 0; i < j; i++)
-                        op[i] = cp[i];
+                    if (cp > op || (uint32_t) (op - cp) >= j) {
+                        /* no overlap, or the source runs ahead of the
+                         * destination after wrapping around the window */
+                        memmove(op, cp, j);
+                    } else if (op - cp == 1) {
+                        memset(op, cp[0], j);
+                    } else {
+                        /* repeating pattern shorter than the match */
+                        for (i = 0; i < j; i++)
+                            op[i] = cp[i];
+                    }
 
                     op += j;
                     cp += j;
@@ -713,6 +790,11 @@ static int inflate_blocks(struct inflate* it, int st, inflate_reader read, void*
         }
     } while (!final);
 
+    if (nbits < pad) {
+        rv = -49;
+        goto bail;
+    }
+
     INFLATE_FLUSH(-44);
 
     if (st != INFLATE_RAW) {
@@ -177,3 +177,74 @@ int strnatcmp(const char *a, const char *b) {
 int strnatcasecmp(const char *a, const char *b) {
      return strnatcmp0(a, b, &strcasecmp);
 }
+
+
+/* Appends a key byte. Bytes are kept within 1..254 so that reversing
+   them can't produce the terminator or collide with the end marker. */
+static inline void
+key_put(char *key, size_t *pos, size_t size, int c, unsigned flags)
+{
+     if (c > 0xfe)
+          c = 0xfe;
+     if (flags & STRNATKEY_REVERSE)
+          c = 0xff - c;
+     if (*pos + 1 < size)
+          key[*pos] = c;
+     (*pos)++;
+}
+
+/* Builds a collation key for str, so sorting can compare keys with
+   strcmp() instead of running the comparison above on every pair.
+   Returns the key length like strlcpy(), the key is truncated (but still
+   terminated) when it is >= size. */
+size_t strnatkey(char *key, const char *str, size_t size, unsigned flags)
+{
+     size_t pos = 0;
+     int c;
+
+     while ((c = to_int(*str)) != 0) {
+          if ((flags & STRNATKEY_NUMBERS) && nat_isdigit(c)) {
+               const char *end = str;
+               size_t len;
+
+               while (nat_isdigit(to_int(*end)))
+                    end++;
+               len = end - str;
+
+               if (c == '0') {
+                    /* Compared left-aligned like compare_left(), and before
+                       any run without a leading zero. The end marker sorts
+                       before a further digit. */
+                    while (str < end)
+                         key_put(key, &pos, size, *str++, flags);
+                    key_put(key, &pos, size, 1, flags);
+               } else {
+                    /* The longest run wins, then the greatest value, like
+                       compare_right() */
+                    key_put(key, &pos, size, '1', flags);
+                    key_put(key, &pos, size, len, flags);
+                    while (str < end)
+                         key_put(key, &pos, size, *str++, flags);
+               }
+               continue;
+          }
+
+          if (flags & STRNATKEY_CASEFOLD)
+               c = nat_unify_case(c);
+          key_put(key, &pos, size, c, flags);
+          str++;
+     }
+
+     /* A key that is a prefix of another sorts first, reversed it must
+        sort last */
+     if (flags & STRNATKEY_REVERSE) {
+          if (pos + 1 < size)
+               key[pos] = 0xff;
+          pos++;
+     }
+
+     if (size > 0)
+          key[pos < size ? pos : size - 1] = '\0';
+
+     return pos;
+}
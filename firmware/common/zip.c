@@ -30,6 +30,7 @@
 #include "pathfuncs.h"
 #include "crc32.h"
 #include "rbendian.h"
+#include "inflate.h"
 
 #define zip_core_alloc(N) core_alloc_ex((N),&buflib_ops_locked)
 
@@ -39,6 +40,7 @@ enum {
     ZIP_SIG_LF = 0x04034b50,
     ZIP_BIT_DD = 0x0008,
     ZIP_METHOD_STORE = 0x0000,
+    ZIP_METHOD_DEFLATE = 0x0008,
     ZIP_MAX_LENGTH = 0xffff,
     ZIP_BUFFER_SIZE = 4096,
 };
@@ -158,6 +160,13 @@ struct zip_mem {
     off_t mem_size;
 };
 
+struct zip_inflate {
+    struct zip* z;
+    uint32_t compressed_left;
+    uint32_t crc;
+    int rv;
+};
+
 struct zip_extract {
     zip_callback cb;
     void* ctx;
@@ -425,6 +434,73 @@ static int zip_read_store(struct zip* z, void* mem, uint32_t mem_size) {
     return 0;
 }
 
+static uint32_t zip_inflate_reader(void* block, uint32_t block_size, void* ctx) {
+    struct zip_inflate* zi = ctx;
+    uint32_t size = MIN(block_size, zi->compressed_left);
+
+    if (size == 0 || zi->z->read(zi->z, block, size) != (off_t) size)
+        return 0;
+
+    zi->compressed_left -= size;
+
+    return size;
+}
+
+static uint32_t zip_inflate_writer(const void* block, uint32_t block_size, void* ctx) {
+    struct zip_inflate* zi = ctx;
+    struct zip* z = zi->z;
+    struct zip_args* args = &z->args;
+
+    args->block = (void*) block;
+    args->block_size = block_size;
+    args->read_size += block_size;
+    zi->crc = crc_32r(block, block_size, zi->crc);
+
+    if ((zi->rv = z->cb(args, ZIP_PASS_DATA, z->ctx)) != 0)
+        return 0;
+
+    return block_size;
+}
+
+static int zip_read_deflate(struct zip* z) {
+    const struct zip_lf* lf = &z->lf;
+    struct zip_inflate zi;
+    size_t it_size = inflate_size + inflate_align - 1;
+    int it_handle;
+    void* it;
+    int rv;
+
+    if ((it_handle = zip_core_alloc(it_size)) < 0)
+        return -25;
+
+    it = core_get_data(it_handle);
+    ALIGN_BUFFER(it, it_size, inflate_align);
+
+    zi.z = z;
+    zi.compressed_left = lf->compressed_size;
+    zi.crc = 0xffffffff;
+    zi.rv = 0;
+    z->args.read_size = 0;
+
+    rv = inflate(it, INFLATE_RAW, zip_inflate_reader, &zi, zip_inflate_writer, &zi);
+
+    core_free(it_handle);
+
+    if (zi.rv != 0)
+        return (zi.rv < 0) ? 0 : zi.rv;
+
+    if (rv != 0)
+        return -26;
+
+    if (z->args.read_size != lf->uncompressed_size)
+        return -27;
+
+    if (~zi.crc != lf->crc)
+        return -24;
+
+    return 0;
+}
+
 static int zip_read_entry(struct zip* z, uint16_t i, void* mem, uint32_t mem_size) {
     const struct zip_lf* lf = &z->lf;
     struct zip_args* args = &z->args;
@@ -449,6 +525,9 @@ static int zip_read_entry(struct zip* z, uint16_t i, void* mem, uint32_t mem_siz
     if (lf->method == ZIP_METHOD_STORE) {
         if ((rv = zip_read_store(z, mem, mem_size)) != 0)
             return rv;
+    } else if (lf->method == ZIP_METHOD_DEFLATE) {
+        if ((rv = zip_read_deflate(z)) != 0)
+            return rv;
     } else {
         return -20;
     }
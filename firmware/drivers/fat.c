@@ -238,6 +238,9 @@ static struct bpb
     unsigned long fatrgnstart;
     unsigned long fatrgnend;
     struct fsinfo fsinfo;
+#ifdef DC_CLUSTERED_IO
+    unsigned long ra_next;         /* sector following the last readahead */
+#endif
 #ifdef HAVE_FAT16SUPPORT
     unsigned int bpb_rootentcnt;    /* Number of dir entries in the root */
     /* internals for FAT16 support */
@@ -328,6 +331,30 @@ static void cache_discard(IF_MV_NONVOID(struct bpb *fat_bpb))
     dc_unlock_cache();
 }
 
+#ifdef DC_CLUSTERED_IO
+/* returns the number of sectors to read when missing secnum; FAT walks are
+   sequential by nature while other areas only read ahead once a miss
+   follows the previous run */
+static unsigned int cache_readahead_count(struct bpb *fat_bpb,
+                                          unsigned long secnum)
+{
+    unsigned long end;
+
+    if (IS_FAT_SECTOR(fat_bpb, secnum))
+        end = fat_bpb->fatrgnend;
+    else if (secnum == fat_bpb->ra_next)
+        end = fat_bpb->totalsectors;
+    else
+        return 1;
+
+    unsigned int count = dc_readahead_limit();
+    if (count > end - secnum)
+        count = end - secnum;
+
+    return count;
+}
+#endif /* DC_CLUSTERED_IO */
+
 /* caches a FAT or data area sector */
 static void * cache_sector(struct bpb *fat_bpb, unsigned long secnum)
 {
@@ -336,8 +363,18 @@ static void * cache_sector(struct bpb *fat_bpb, unsigned long secnum)
 
     if (!flags)
     {
+        unsigned int count = 1;
+        void *rdbuf = buf;
+
+#ifdef DC_CLUSTERED_IO
+        count = cache_readahead_count(fat_bpb, secnum);
+        if (count > 1)
+            rdbuf = dc_get_run_buffer();
+#endif
+
         int rc = storage_read_sectors(IF_MD(fat_bpb->drive,)
-                                      secnum + fat_bpb->startsector, 1, buf);
+                                      secnum + fat_bpb->startsector, count,
+                                      rdbuf);
         if (UNLIKELY(rc < 0))
         {
             DEBUGF("%s() - Could not read sector %ld"
@@ -345,6 +382,17 @@ static void * cache_sector(struct bpb *fat_bpb, unsigned long secnum)
             dc_discard_buf(buf);
             return NULL;
         }
+
+#ifdef DC_CLUSTERED_IO
+        fat_bpb->ra_next = secnum + count;
+
+        if (count > 1)
+        {
+            memcpy(buf, rdbuf, DC_CACHE_BUFSIZE);
+            dc_cache_fill(IF_MV(fat_bpb->volume,) secnum + 1, count - 1,
+                          rdbuf + DC_CACHE_BUFSIZE);
+        }
+#endif
     }
 
     return buf;
@@ -360,29 +408,53 @@ static void * cache_sector_buffer(IF_MV(struct bpb *fat_bpb,)
     return dc_cache_probe(IF_MV(fat_bpb->volume,) secnum, &flags);
 }
 
-/* flush a cache buffer to storage */
-void dc_writeback_callback(IF_MV(int volume,) unsigned long sector, void *buf)
+/* flush cache buffers to storage */
+void dc_writeback_callback(IF_MV(int volume,) unsigned long sector,
+                           unsigned int count, void *buf)
 {
     struct bpb * const fat_bpb = &fat_bpbs[IF_MV_VOL(volume)];
-    unsigned int copies = !IS_FAT_SECTOR(fat_bpb, sector) ?
-                                1 : fat_bpb->bpb_numfats;
 
-    sector += fat_bpb->startsector;
-
-    while (1)
+    while (count)
     {
-        int rc = storage_write_sectors(IF_MD(fat_bpb->drive,) sector, 1, buf);
-        if (rc < 0)
+        /* the run may straddle the FAT region boundaries; split it so only
+           FAT sectors are mirrored */
+        unsigned long end = sector + count;
+        unsigned int copies = 1;
+
+        if (IS_FAT_SECTOR(fat_bpb, sector))
         {
-            panicf("%s() - Could not write sector %ld"
-                   " (error %d)\n", __func__, sector, rc);
+            copies = fat_bpb->bpb_numfats;
+            if (end > fat_bpb->fatrgnend)
+                end = fat_bpb->fatrgnend;
+        }
+        else if (sector < fat_bpb->fatrgnstart && end > fat_bpb->fatrgnstart)
+        {
+            end = fat_bpb->fatrgnstart;
         }
 
-        if (--copies == 0)
-            break;
+        unsigned int n = end - sector;
+        unsigned long secnum = sector + fat_bpb->startsector;
+
+        while (1)
+        {
+            int rc = storage_write_sectors(IF_MD(fat_bpb->drive,) secnum, n,
+                                           buf);
+            if (rc < 0)
+            {
+                panicf("%s() - Could not write sector %ld"
+                       " (error %d)\n", __func__, secnum, rc);
+            }
+
+            if (--copies == 0)
+                break;
+
+            /* Update next FAT */
+            secnum += fat_bpb->fatsize;
+        }
 
-        /* Update next FAT */
-        sector += fat_bpb->fatsize;
+        sector = end;
+        count -= n;
+        buf += n*DC_CACHE_BUFSIZE;
     }
 }
 
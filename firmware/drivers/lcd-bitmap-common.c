@@ -422,8 +422,10 @@ static void LCDFN(putsxyofs)(int x, int y, int ofs, const unsigned char *str)
 
     rtl_next_non_diac_width = 0;
     last_non_diacritic_width = 0;
+    ucs = bidi_l2v(str, 1);
+    font_prefetch_glyphs(pf, ucs);
     /* Mark diacritic and rtl flags for each character */
-    for (ucs = bidi_l2v(str, 1); *ucs; ucs++)
+    for (; *ucs; ucs++)
     {
         bool is_rtl, is_diac;
         const unsigned char *bits;
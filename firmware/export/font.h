@@ -136,5 +136,11 @@ int font_getstringnsize(const unsigned char *str, size_t maxbytes, int *w, int *
 int font_getstringsize(const unsigned char *str, int *w, int *h, int fontnumber);
 int font_get_width(struct font* ft, unsigned short ch);
 const unsigned char * font_get_bits(struct font* ft, unsigned short ch);
+/* Loads the glyphs of a 0 terminated UCS-2 string that aren't cached yet,
+ * reading neighbouring glyphs from the font file together */
+void font_prefetch_glyphs(struct font* pf, const unsigned short *ucs);
+/* Fills the unused glyph cache slots of a font with the glyphs of str, without
+ * evicting any. Returns false once there is no room left */
+bool font_prewarm(int font_id, const unsigned char *str);
 
 #endif
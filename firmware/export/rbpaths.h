@@ -117,6 +117,7 @@
 #define FIXEDSETTINGSFILE   ROCKBOX_DIR "/fixed.cfg"
 
 #define PLAYLIST_CONTROL_FILE   ROCKBOX_DIR "/.playlist_control"
+#define PLAYLIST_INDEX_FILE     ROCKBOX_DIR "/.playlist_index"
 #define NVRAM_FILE              ROCKBOX_DIR "/nvram.bin"
 #define GLYPH_CACHE_FILE        ROCKBOX_DIR "/.glyphcache"
 
@@ -104,6 +104,29 @@ struct buflib_alloc_data {
 };
 static int buflib_allocations[MAXFONTS];
 
+/* Lists measure the same few lines on every redraw and scroll step, so
+ * the widths of short strings are kept until a font changes */
+#define WIDTH_CACHE_STRLEN 64
+#if MEMORYSIZE > 2
+#define WIDTH_CACHE_ENTRIES 32
+#else
+#define WIDTH_CACHE_ENTRIES 12
+#endif
+
+static struct width_entry {
+    unsigned char len; /* of str, 0 if unused */
+    short font;
+    int width;
+    unsigned char str[WIDTH_CACHE_STRLEN];
+} width_cache[WIDTH_CACHE_ENTRIES];
+static int width_next; /* entry to be replaced next */
+
+static void width_cache_flush(void)
+{
+    for (int i = 0; i < WIDTH_CACHE_ENTRIES; i++)
+        width_cache[i].len = 0;
+}
+
 static int cache_fd;
 static struct font* cache_pf;
 
@@ -588,6 +611,7 @@ int font_load_ex( const char *path, size_t buf_size, int glyphs )
         }
     }
     buflib_allocations[font_id] = handle;
+    width_cache_flush();
     //printf("%s -> [%d] -> %d\n", path, font_id, *handle);
     core_put_data_pinned(pdata);
     logf("%s id: [%d], %s", __func__, font_id, path);
@@ -619,6 +643,7 @@ void font_unload(int font_id)
         }
         core_free(handle);
         buflib_allocations[font_id] = -1;
+        width_cache_flush();
 
     }
 }
@@ -678,6 +703,8 @@ static void font_enable(int font_id)
     {
         pf->fd = open(pdata->path, O_RDONLY);
         pf->disabled = false;
+        /* widths measured while disabled may have been guessed */
+        width_cache_flush();
     }
     core_put_data_pinned(pdata);
 }
@@ -775,6 +802,254 @@ load_cache_entry(struct font_cache_entry* p, void* callback_data)
     lock_font_handle(pf->handle, false);
 }
 
+/* Glyphs missing from the cache are looked up in batches of up to
+ * GLYPH_BATCH_SIZE codes. Sorted neighbours in the width, offset and bitmap
+ * sections of the file are read together as long as the span between them
+ * fits the scratch buffer, so a line of CJK text costs a handful of reads
+ * instead of three per glyph */
+#define GLYPH_BATCH_SIZE    32
+#define GLYPH_BATCH_BUFSIZE 512
+
+static unsigned char glyph_batch_buf[GLYPH_BATCH_BUFSIZE];
+
+struct glyph_batch_entry
+{
+    int width;
+    int bytes;
+    const unsigned char *bits;
+};
+
+static void
+load_batch_entry(struct font_cache_entry* p, void* callback_data)
+{
+    struct glyph_batch_entry *e = callback_data;
+
+    p->width = e->width;
+    memcpy(p->bitmap, e->bits, e->bytes);
+}
+
+/*
+ * Reads the records of the sorted codes from a table of rec_size byte
+ * little endian values, coalescing neighbours into one read
+ */
+static void glyph_batch_read_table(int fd, int32_t table_offset, int rec_size,
+                                   const unsigned short *codes, int count,
+                                   int32_t *values)
+{
+    unsigned char *buf = glyph_batch_buf;
+    int i = 0;
+
+    while (i < count)
+    {
+        int first = codes[i];
+        int j = i + 1;
+
+        while (j < count &&
+               (codes[j] - first + 1) * rec_size <= GLYPH_BATCH_BUFSIZE)
+            j++;
+
+        int len = (codes[j - 1] - first + 1) * rec_size;
+        lseek(fd, table_offset + first * rec_size, SEEK_SET);
+        if (read(fd, buf, len) != len)
+            memset(buf, 0, len);
+
+        for (; i < j; i++)
+        {
+            const unsigned char *rec = buf + (codes[i] - first) * rec_size;
+            int32_t value = rec[0];
+            if (rec_size > 1)
+                value |= rec[1] << 8;
+            if (rec_size > 2)
+                value |= (rec[2] << 16) | ((uint32_t)rec[3] << 24);
+            values[i] = value;
+        }
+    }
+}
+
+/*
+ * Loads the sorted, not yet cached (file relative) codes into the cache
+ */
+static void glyph_batch_load(struct font *pf, const unsigned short *codes,
+                             int count)
+{
+    int32_t widths[GLYPH_BATCH_SIZE];
+    int32_t offsets[GLYPH_BATCH_SIZE];
+    struct glyph_batch_entry e;
+    int i;
+
+    if (pf->file_width_offset)
+    {
+        int fd = pf->fd_width >= 0 ? pf->fd_width : pf->fd;
+        glyph_batch_read_table(fd, pf->file_width_offset, 1,
+                               codes, count, widths);
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+            widths[i] = pf->maxwidth;
+    }
+
+    if (pf->file_offset_offset)
+    {
+        int fd = pf->fd_offset >= 0 ? pf->fd_offset : pf->fd;
+        glyph_batch_read_table(fd, pf->file_offset_offset,
+                               pf->long_offset ? 4 : 2, codes, count, offsets);
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+            offsets[i] = codes[i] * glyph_bytes(pf, widths[i]);
+    }
+
+    i = 0;
+    while (i < count)
+    {
+        int32_t start = offsets[i];
+        int32_t end = start + glyph_bytes(pf, widths[i]);
+        int j = i + 1;
+
+        if (end - start > GLYPH_BATCH_BUFSIZE)
+        {
+            /* doesn't fit the scratch buffer, load it on its own */
+            font_cache_get(&pf->cache, codes[i], false, load_cache_entry, pf);
+            i++;
+            continue;
+        }
+
+        /* bitmaps are stored in code order, but don't rely on it */
+        while (j < count && offsets[j] >= offsets[j - 1])
+        {
+            int32_t next_end = offsets[j] + glyph_bytes(pf, widths[j]);
+            if (next_end - start > GLYPH_BATCH_BUFSIZE)
+                break;
+            if (next_end > end)
+                end = next_end;
+            j++;
+        }
+
+        lseek(pf->fd, FONT_HEADER_SIZE + start, SEEK_SET);
+        if (read(pf->fd, glyph_batch_buf, end - start) != end - start)
+            memset(glyph_batch_buf, 0, end - start);
+
+        for (; i < j; i++)
+        {
+            e.width = widths[i];
+            e.bits = glyph_batch_buf + (offsets[i] - start);
+            e.bytes = glyph_bytes(pf, widths[i]);
+            font_cache_get(&pf->cache, codes[i], false, load_batch_entry, &e);
+        }
+    }
+}
+
+/*
+ * Loads the glyphs of up to count (or until 0) characters that aren't cached
+ * yet, with sorted and coalesced reads. Stops after adding limit glyphs.
+ * Returns the number of glyphs added.
+ */
+static int glyph_batch_prefetch(struct font *pf, const unsigned short *ucs,
+                                int count, int limit)
+{
+    unsigned short codes[GLYPH_BATCH_SIZE];
+    int batch = 0, loaded = 0;
+
+    if (pf->fd < 0 || pf == &sysfont)
+        return 0;
+
+    if (limit > pf->cache._capacity)
+        limit = pf->cache._capacity;
+
+    lock_font_handle(pf->handle, true);
+
+    for (; count != 0 && *ucs && loaded + batch < limit; ucs++, count--)
+    {
+        unsigned short char_code = *ucs;
+        int i;
+
+        if (char_code < pf->firstchar || char_code >= pf->firstchar+pf->size)
+            char_code = pf->defaultchar;
+        char_code -= pf->firstchar;
+
+        if (font_cache_get(&pf->cache, char_code, true, NULL, NULL))
+            continue;
+
+        /* insert sorted, dropping duplicates */
+        for (i = batch; i > 0 && codes[i - 1] > char_code; i--)
+            ;
+        if (i > 0 && codes[i - 1] == char_code)
+            continue;
+        memmove(&codes[i + 1], &codes[i], (batch - i) * sizeof(*codes));
+        codes[i] = char_code;
+
+        if (++batch == GLYPH_BATCH_SIZE)
+        {
+            glyph_batch_load(pf, codes, batch);
+            loaded += batch;
+            batch = 0;
+        }
+    }
+
+    if (batch > 0)
+    {
+        glyph_batch_load(pf, codes, batch);
+        loaded += batch;
+    }
+
+    lock_font_handle(pf->handle, false);
+    return loaded;
+}
+
+/*
+ * Decodes up to maxchars characters of an UTF-8 string in pieces and
+ * prefetches their glyphs
+ */
+static int glyph_batch_prefetch_utf8(struct font *pf, const unsigned char *str,
+                                     size_t maxchars, int limit)
+{
+    unsigned short ucs[GLYPH_BATCH_SIZE];
+    int loaded = 0;
+
+    while (*str && maxchars > 0 && loaded < limit)
+    {
+        int n = 0;
+        while (n < GLYPH_BATCH_SIZE && *str && maxchars > 0)
+        {
+            str = utf8decode(str, &ucs[n++]);
+            maxchars--;
+        }
+        loaded += glyph_batch_prefetch(pf, ucs, n, limit - loaded);
+    }
+
+    return loaded;
+}
+
+void font_prefetch_glyphs(struct font *pf, const unsigned short *ucs)
+{
+    glyph_batch_prefetch(pf, ucs, -1, pf->cache._capacity);
+}
+
+/*
+ * Fills the unused cache slots of a font with the glyphs of str. Never
+ * evicts a glyph. Returns false once the cache is full.
+ */
+bool font_prewarm(int font_id, const unsigned char *str)
+{
+    struct font *pf = font_get(font_id);
+    bool room;
+
+    font_lock(font_id, true);
+    if (pf->fd < 0 || pf == &sysfont)
+        room = false;
+    else
+    {
+        glyph_batch_prefetch_utf8(pf, str, -1,
+                                  font_cache_free_slots(&pf->cache));
+        room = font_cache_free_slots(&pf->cache) > 0;
+    }
+    font_lock(font_id, false);
+
+    return room;
+}
+
 /*
  * Converts cbuf into a font cache
  */
@@ -993,8 +1268,7 @@ static void glyph_cache_load(const char *font_path, struct font *pf)
                       ushortcmp );
 
                 /* load font bitmaps */
-                for( i = 0; i < size ; i++ )
-                         font_get_bits(pf, glyphs[i]);
+                glyph_batch_prefetch(pf, glyphs, size, size);
                 
                 /* redo to fix lru order */
                 for ( i = 0; i < size ; i++)
@@ -1006,9 +1280,11 @@ static void glyph_cache_load(const char *font_path, struct font *pf)
 
             close(fd);
         } else {
-            /* load latin1 chars into cache */
-            for ( ch = 32 ; ch < 256  && ch < pf->cache._capacity + 32; ch++ )
-                font_get_bits(pf, ch);
+            /* load the printable ascii chars into cache, font_prewarm()
+             * adds the ones of the current language */
+            for ( size = 0, ch = 32 ; ch < 127 ; ch++ )
+                glyphs[size++] = ch;
+            glyph_batch_prefetch(pf, glyphs, size, size);
         }
     }
     return;
@@ -1047,6 +1323,17 @@ int font_get_width(struct font* pf, unsigned short char_code)
     return pf->width? pf->width[char_code]: pf->maxwidth;
 }
 
+static inline int glyph_batch_prefetch_utf8(struct font *pf,
+                                            const unsigned char *str,
+                                            size_t maxchars, int limit)
+{
+    (void)pf;
+    (void)str;
+    (void)maxchars;
+    (void)limit;
+    return 0;
+}
+
 const unsigned char* font_get_bits(struct font* pf, unsigned short char_code)
 {
     const unsigned char* bits;
@@ -1075,10 +1362,41 @@ const unsigned char* font_get_bits(struct font* pf, unsigned short char_code)
 int font_getstringnsize(const unsigned char *str, size_t maxbytes, int *w, int *h, int fontnum)
 {
     struct font* pf = font_get(fontnum);
-    font_lock( fontnum, true );
     unsigned short ch;
     int width = 0;
     size_t b = maxbytes - 1;
+#ifdef WIDTH_CACHE_ENTRIES
+    struct width_entry *e;
+    size_t len = 0;
+
+    /* only whole strings are cached */
+    if (maxbytes == (size_t)-1)
+        len = strlen((const char *)str);
+    if (len > 0 && len < WIDTH_CACHE_STRLEN)
+    {
+        for (e = width_cache; e < &width_cache[WIDTH_CACHE_ENTRIES]; e++)
+        {
+            if (e->len == len && e->font == fontnum
+                && !memcmp(e->str, str, len))
+            {
+                if ( w )
+                    *w = e->width;
+                if ( h )
+                    *h = pf->height;
+                return e->width;
+            }
+        }
+    }
+    else
+        len = 0;
+    const unsigned char *start = str;
+#endif
+
+    font_lock( fontnum, true );
+
+    /* load whatever isn't cached in one go rather than glyph by glyph */
+    if (pf->fd >= 0)
+        glyph_batch_prefetch_utf8(pf, str, maxbytes, pf->cache._capacity);
 
     for (str = utf8decode(str, &ch); ch != 0 && b < maxbytes; str = utf8decode(str, &ch), b--)
     {
@@ -1088,6 +1406,17 @@ int font_getstringnsize(const unsigned char *str, size_t maxbytes, int *w, int *
         /* get proportional width and glyph bits*/
         width += font_get_width(pf,ch);
     }
+#ifdef WIDTH_CACHE_ENTRIES
+    if (len)
+    {
+        e = &width_cache[width_next];
+        width_next = (width_next + 1) % WIDTH_CACHE_ENTRIES;
+        e->len = len;
+        e->font = fontnum;
+        e->width = width;
+        memcpy(e->str, start, len);
+    }
+#endif
     if ( w )
         *w = width;
     if ( h )
@@ -29,6 +29,7 @@ static void font_cache_lru_init(void* data)
 {
     struct font_cache_entry* p = data;
     p->_char_code = 0xffff;   /* assume invalid char */
+    p->_next = -1;
 }
 
 /*******************************************************************************
@@ -50,10 +51,15 @@ void font_cache_create(
     int cache_size = buf_size /
         (font_cache_entry_size + LRU_SLOT_OVERHEAD + sizeof(short));
 
-    fcache->_size = 1;
+    /* use the largest power of 2 that fits as the number of buckets, so
+     * chains are at most two entries long on average */
+    int buckets = 1;
+    while (buckets * 2 <= cache_size)
+        buckets *= 2;
+
+    fcache->_size = 0;
     fcache->_capacity = cache_size;
-    fcache->_prev_result = 0;
-    fcache->_prev_char_code = 0;
+    fcache->_mask = buckets - 1;
 
     /* set up index */
     fcache->_index = buf;
@@ -66,59 +72,37 @@ void font_cache_create(
     /* initialise cache */
     lru_traverse(&fcache->_lru, font_cache_lru_init);
     short i;
-    for (i = 0; i < cache_size; i++)
-        fcache->_index[i] = i; /* small cheat here */
+    for (i = 0; i < buckets; i++)
+        fcache->_index[i] = -1;
 }
 
 /*************************************************************************
- * Binary search that attempts a primary lucky guess that succeeds
- * when there are consecutive codes in the cache between previous 
- * search and new search. Returns a negative of insertion point if 
- * not found.
+ * Consecutive char codes land in consecutive buckets, which keeps the
+ * runs of a script's alphabet collision free
  ************************************************************************/
-static int search(struct font_cache* fcache,
-                  unsigned short char_code,
-                  int size,
-                  int *p_insertion_point )
+static inline short *bucket(struct font_cache* fcache,
+                            unsigned short char_code)
 {
-    struct font_cache_entry *p;
-    int left, right, mid=-1, c;
-    left = 0;
-    right = size;
-    
-    /* go for a lucky guess */
-    mid = char_code + 
-        fcache->_prev_result - fcache->_prev_char_code;
-            
-    /* check bounds */        
-    if ( mid < 0 || mid > right )
-            mid = ( left + right ) / 2;
-
-    do
-    {
-        p = lru_data(&fcache->_lru, fcache->_index[mid]);
-        c = p->_char_code - char_code;
+    return &fcache->_index[char_code & fcache->_mask];
+}
 
-        if (c == 0)
-        {
-            fcache->_prev_result = mid;
-            fcache->_prev_char_code = char_code;
-            *p_insertion_point = mid;
-            return 1;
-        }
-        if (c < 0)
-            left = mid + 1;
-        else
-            right = mid - 1;
+/*************************************************************************
+ * Removes an entry from its hash chain
+ ************************************************************************/
+static void unlink_entry(struct font_cache* fcache, short lru_handle,
+                         struct font_cache_entry *p)
+{
+    short *link = bucket(fcache, p->_char_code);
 
-        mid = (left + right) / 2;
+    while (*link != lru_handle)
+    {
+        struct font_cache_entry *q = lru_data(&fcache->_lru, *link);
+        link = &q->_next;
     }
-    while (left <= right);
-    
-    /* not found */
-    *p_insertion_point = mid;
-    return 0;
+
+    *link = p->_next;
 }
+
 /*******************************************************************************
  * font_cache_get
  ******************************************************************************/
@@ -130,78 +114,40 @@ struct font_cache_entry* font_cache_get(
     void *callback_data)
 {
     struct font_cache_entry* p;
-    int insertion_point;
-    int index_to_replace;
-    
-    /* check bounds */
-    p = lru_data(&fcache->_lru, fcache->_index[0]);
-    if( char_code < p->_char_code )
-        insertion_point = -1;
-    else
+    short *head = bucket(fcache, char_code);
+    short lru_handle = *head;
+
+    while (lru_handle >= 0)
     {
-        p = lru_data(&fcache->_lru, fcache->_index[fcache->_capacity - 1]);
-        if( char_code > p->_char_code )
+        p = lru_data(&fcache->_lru, lru_handle);
+        if (p->_char_code == char_code)
         {
-            insertion_point = fcache->_capacity - 1;
-        }
-        else
-        {
-            if( search(fcache, char_code, fcache->_size - 1, &insertion_point))
-            {
-                short lru_handle = fcache->_index[insertion_point];
-                p = lru_data(&fcache->_lru, lru_handle);
-                if (p->_char_code == char_code)
-                {
-                    lru_touch(&fcache->_lru, lru_handle);
-                    return lru_data(&fcache->_lru, lru_handle);
-                }
-            }
-            else
-            {
-                p = lru_data(&fcache->_lru, 
-                fcache->_index[insertion_point+1]);
-                if ( char_code > p->_char_code )
-                     insertion_point++;
-            }
+            lru_touch(&fcache->_lru, lru_handle);
+            return p;
         }
+        lru_handle = p->_next;
     }
-    
+
     /* not found */
     if (cache_only)
         return NULL;
 
-    /* find index to replace */
+    /* replace the least recently used entry */
     short lru_handle_to_replace = fcache->_lru._head;
     p = lru_data(&fcache->_lru, lru_handle_to_replace);
-    search(fcache, p->_char_code, fcache->_size - 1, &index_to_replace);
-    if (insertion_point < index_to_replace)
-    {
-        /* shift memory up */
-        memmove(fcache->_index + insertion_point + 2,
-                fcache->_index + insertion_point + 1,
-                (index_to_replace - insertion_point - 1) * sizeof(short));
-
-        /* add to index */
-        fcache->_index[insertion_point + 1] = lru_handle_to_replace;
-    }
-    else if (insertion_point > index_to_replace)
-    {
-        /* shift memory down */
-        memmove(fcache->_index + index_to_replace,
-                fcache->_index + index_to_replace + 1,
-                (insertion_point - index_to_replace) * sizeof(short));
 
-        /* add to index */
-        fcache->_index[insertion_point] = lru_handle_to_replace;
-    }
+    if (p->_char_code != 0xffff)
+        unlink_entry(fcache, lru_handle_to_replace, p);
+    else
+        fcache->_size++;
 
     /* load new entry into cache */
     lru_touch(&fcache->_lru, lru_handle_to_replace);
 
-    if (fcache->_size < fcache->_capacity)
-        fcache->_size++;
-
     p->_char_code = char_code;
+    p->_next = *head;
+    *head = lru_handle_to_replace;
+
     /* fill bitmap */
     callback(p, callback_data);
     return p;
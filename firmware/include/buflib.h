@@ -131,6 +131,20 @@ struct buflib_callbacks
  */
 extern struct buflib_callbacks buflib_ops_locked;
 
+/**
+ * Allocator statistics, see buflib_get_stats().
+ */
+struct buflib_stats
+{
+    size_t free_bytes;              /* total unallocated bytes */
+    size_t largest_free;            /* largest contiguous free area */
+    unsigned int free_blocks;       /* number of free areas */
+    unsigned long compactions;      /* compaction runs */
+    unsigned long compactions_skipped; /* runs avoided as futile */
+    unsigned long bytes_moved;      /* bytes moved by compaction */
+    unsigned long size_class_hits;  /* small allocs served by size classes */
+};
+
 /**
  * \brief Intialize a buflib context
  * \param ctx       Context to initialize
@@ -374,6 +388,16 @@ void* buflib_buffer_out(struct buflib_context *ctx, size_t *size);
  */
 void buflib_buffer_in(struct buflib_context *ctx, int size);
 
+/**
+ * \brief Get fragmentation and compaction statistics
+ * \param ctx       Context to query
+ * \param stats     Filled in with the current statistics
+ *
+ * The free space figures are for the pool as it is now, before any
+ * compaction; free_bytes - largest_free is the fragmented amount.
+ */
+void buflib_get_stats(struct buflib_context *ctx, struct buflib_stats *stats);
+
 #ifdef BUFLIB_DEBUG_PRINT
 /**
  * Return the number of blocks in the buffer, allocated or unallocated.
@@ -53,6 +53,13 @@ union buflib_data
                                      Used during compaction for fast lookup */
 };
 
+/* Free blocks up to BUFLIB_SC_MAX_LEN units long (including the header
+ * overhead of an allocation) are kept on segregated lists by size class so
+ * small allocations can be placed without walking the whole pool */
+#define BUFLIB_NUM_SIZE_CLASSES 8
+#define BUFLIB_SC_MIN_LEN       BUFLIB_NUM_FIELDS
+#define BUFLIB_SC_MAX_LEN       (BUFLIB_NUM_FIELDS + 64)
+
 struct buflib_context
 {
     union buflib_data *handle_table;
@@ -61,6 +68,13 @@ struct buflib_context
     union buflib_data *buf_start;
     union buflib_data *alloc_end;
     bool compact;
+    bool sc_valid; /* size class lists are in sync with the pool */
+    union buflib_data *sc_lists[BUFLIB_NUM_SIZE_CLASSES];
+    /* statistics */
+    unsigned long compactions;
+    unsigned long compactions_skipped;
+    unsigned long bytes_moved;
+    unsigned long sc_hits;
 };
 
 #define BUFLIB_ALLOC_OVERHEAD (BUFLIB_NUM_FIELDS * sizeof(union buflib_data))
@@ -21,6 +21,7 @@ unsigned core_pin_count(int handle);
 int core_free(int handle);
 size_t core_available(void);
 size_t core_allocatable(void);
+void core_get_stats(struct buflib_stats *stats);
 
 #ifdef BUFLIB_DEBUG_CHECK_VALID
 void core_check_valid(void);
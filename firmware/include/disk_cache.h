@@ -23,6 +23,18 @@
 
 #include "mutex.h"
 #include "mv.h"
+#include "fs_defines.h"
+
+struct dc_stats
+{
+    unsigned long hits;         /* probes satisfied from the cache */
+    unsigned long misses;       /* probes that required a fill */
+    unsigned long ra_sectors;   /* sectors filled by readahead */
+    unsigned long ra_used;      /* readahead sectors later probed */
+    unsigned long ra_wasted;    /* readahead sectors evicted unused */
+    unsigned long wb_sectors;   /* dirty sectors written back */
+    unsigned long wb_requests;  /* storage writes issued for them */
+};
 
 static inline void dc_lock_cache(void)
 {
@@ -43,11 +55,24 @@ void dc_discard_buf(void *buf);
 void dc_commit_all(IF_MV_NONVOID(int volume));
 void dc_discard_all(IF_MV_NONVOID(int volume));
 
+#ifdef DC_CLUSTERED_IO
+/* number of sectors the client may read ahead on a miss (1 = none) */
+unsigned int dc_readahead_limit(void);
+/* buffer of DC_MAX_RUN sectors for multi-sector reads */
+void * dc_get_run_buffer(void);
+/* insert sectors that were read ahead; ones already cached are skipped */
+void dc_cache_fill(IF_MV(int volume,) unsigned long sector,
+                   unsigned int count, const void *buf);
+#endif /* DC_CLUSTERED_IO */
+
+void dc_get_stats(struct dc_stats *stats);
+
 void dc_init(void) INIT_ATTR;
 
-/* in addition to filling, writeback is implemented by the client */
+/* in addition to filling, writeback is implemented by the client; 'count'
+   sectors are contiguous in 'buf' */
 extern void dc_writeback_callback(IF_MV(int volume, ) unsigned long sector,
-                                  void *buf);
+                                  unsigned int count, void *buf);
 
 
 /** These synchronize and can be called by anyone **/
@@ -29,16 +29,16 @@
 struct font_cache
 {
     struct lru _lru;
-    int _size;
+    int _size;     /* number of slots holding a glyph */
     int _capacity;
-    int _prev_char_code;
-    int _prev_result;
-    short *_index; /* index of lru handles in char_code order */
+    int _mask;     /* number of hash buckets - 1 */
+    short *_index; /* hash buckets, each the lru handle of a chain or -1 */
 };
 
 struct font_cache_entry
 {
     unsigned short _char_code;
+    short _next;   /* next lru handle in the same hash bucket or -1 */
     unsigned char width;
     unsigned char bitmap[1]; /* place holder */
 };
@@ -60,4 +60,10 @@ struct font_cache_entry* font_cache_get(
     void (*callback) (struct font_cache_entry* p, void *callback_data),
     void *callback_data);
 
+/* Number of slots that can take a glyph without evicting another one */
+static inline int font_cache_free_slots(const struct font_cache *fcache)
+{
+    return fcache->_capacity - fcache->_size;
+}
+
 #endif
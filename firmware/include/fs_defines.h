@@ -103,12 +103,28 @@
 #if MEMORYSIZE < 8
 #define DC_NUM_ENTRIES      32
 #define DC_MAP_NUM_ENTRIES  128
-#else
+#elif MEMORYSIZE < 32
 #define DC_NUM_ENTRIES      64
 #define DC_MAP_NUM_ENTRIES  256
+#else
+#define DC_NUM_ENTRIES      128
+#define DC_MAP_NUM_ENTRIES  512
 #endif /* MEMORYSIZE */
 
 /* this _could_ be larger than a sector if that would ever be useful */
 #define DC_CACHE_BUFSIZE    SECTOR_SIZE
 
+/* Clustered cache I/O: a miss reads ahead a run of up to DC_MAX_RUN adjacent
+ * sectors in one storage request and commits write adjacent dirty sectors
+ * together. The run buffer is allocated in addition to the cache entries.
+ */
+#if MEMORYSIZE >= 8 && !defined(BOOTLOADER)
+#define DC_CLUSTERED_IO
+#if MEMORYSIZE < 32
+#define DC_MAX_RUN          8
+#else
+#define DC_MAX_RUN          16
+#endif
+#endif /* MEMORYSIZE */
+
 #endif /* FS_DEFINES_H */
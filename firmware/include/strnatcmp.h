@@ -28,3 +28,13 @@
 
 int strnatcmp(const char *a, const char *b);
 int strnatcasecmp(const char *a, const char *b);
+
+#include <stddef.h>
+
+/* Collation keys: strcmp() on two keys orders them like the matching
+ * comparison above (or strcmp()/strcasecmp() without STRNATKEY_NUMBERS) */
+#define STRNATKEY_NUMBERS  0x1 /* digit runs compare as numbers */
+#define STRNATKEY_CASEFOLD 0x2 /* ignore case */
+#define STRNATKEY_REVERSE  0x4 /* descending order */
+
+size_t strnatkey(char *key, const char *str, size_t size, unsigned flags);
@@ -73,6 +73,10 @@
 /* We don't use sizeof() here, because we *need* a multiple of 32 */
 #define MAX_CBW_SIZE 512
 
+/* Command results and the CSW have their own room, so they can't overwrite
+ * sectors that were read ahead. A multiple of 32 too */
+#define MAX_RESULT_SIZE 512
+
 #ifdef USB_WRITE_BUFFER_SIZE
 #define WRITE_BUFFER_SIZE USB_WRITE_BUFFER_SIZE
 #else
@@ -90,6 +94,12 @@
 
 #define ALLOCATE_BUFFER_SIZE (2*MAX(READ_BUFFER_SIZE,WRITE_BUFFER_SIZE))
 
+/* The storage drivers block, so the sectors for the next chunk are read
+ * while the USB controller sends the current one. A read that fits in one
+ * buffer is sent in two halves to get that overlap at all, unless it is
+ * smaller than this */
+#define READ_SPLIT_SIZE (1024*16)
+
 /* bulk-only class specific requests */
 #define USB_BULK_RESET_REQUEST   0xff
 #define USB_BULK_GET_MAX_LUN     0xfe
@@ -271,6 +281,7 @@ static union {
 } tb;
 
 static char *cbw_buffer;
+static unsigned char *block_buffer;
 
 static struct {
     unsigned int sector;
@@ -279,11 +290,24 @@ static struct {
     unsigned int cur_cmd;
     unsigned int tag;
     unsigned int lun;
+    unsigned int chunk;
+    unsigned int num_sectors;
+    bool sequential;
     unsigned char *data[2];
     unsigned char data_select;
     unsigned int last_result;
 } cur_cmd;
 
+/* Where the last READ(10) ended. If it continued the one before, the
+ * sectors after it are read into the spare buffer while its last chunk is
+ * sent, hosts mostly read on from there */
+static struct {
+    unsigned int lun;
+    unsigned int sector;
+    unsigned int count;         /* sectors read ahead, 0 if none */
+    unsigned char data_select;
+} read_ahead;
+
 static struct {
     unsigned char sense_key;
     unsigned char information;
@@ -368,6 +392,7 @@ void usb_storage_notify_hotswap(int volume,bool inserted)
            At least try to keep our state consistent */
         locked[volume]=false;
     }
+    read_ahead.count = 0;
 }
 #endif
 
@@ -443,9 +468,13 @@ void usb_storage_init_connection(void)
         USB_DEVBSS_ATTR __attribute__((aligned(32)));
     cbw_buffer = (void *)_cbw_buffer;
 
-    static unsigned char _transfer_buffer[ALLOCATE_BUFFER_SIZE]
+    static unsigned char _transfer_buffer[MAX_RESULT_SIZE]
         USB_DEVBSS_ATTR __attribute__((aligned(32)));
     tb.transfer_buffer = (void *)_transfer_buffer;
+
+    static unsigned char _block_buffer[ALLOCATE_BUFFER_SIZE]
+        USB_DEVBSS_ATTR __attribute__((aligned(32)));
+    block_buffer = (void *)_block_buffer;
 #ifdef USB_USE_RAMDISK
     static unsigned char _ramdisk_buffer[RAMDISK_SIZE*SECTOR_SIZE];
     ramdisk_buffer = _ramdisk_buffer;
@@ -454,7 +483,8 @@ void usb_storage_init_connection(void)
     unsigned char * buffer;
 
     // Add 31 to handle worst-case misalignment
-    usb_handle = core_alloc_ex(ALLOCATE_BUFFER_SIZE + MAX_CBW_SIZE + 31,
+    usb_handle = core_alloc_ex(ALLOCATE_BUFFER_SIZE + MAX_CBW_SIZE +
+                               MAX_RESULT_SIZE + 31,
                                &buflib_ops_locked);
     if (usb_handle < 0)
         panicf("%s(): OOM", __func__);
@@ -466,11 +496,13 @@ void usb_storage_init_connection(void)
     cbw_buffer = (void *)((unsigned int)(buffer+31) & 0xffffffe0);
 #endif
     tb.transfer_buffer = cbw_buffer + MAX_CBW_SIZE;
+    block_buffer = tb.transfer_buffer + MAX_RESULT_SIZE;
     commit_discard_dcache();
 #ifdef USB_USE_RAMDISK
-    ramdisk_buffer = tb.transfer_buffer + ALLOCATE_BUFFER_SIZE;
+    ramdisk_buffer = block_buffer + ALLOCATE_BUFFER_SIZE;
 #endif
 #endif
+    read_ahead.count = 0;
     usb_drv_recv_nonblocking(ep_out, cbw_buffer, MAX_CBW_SIZE);
 
     int i;
@@ -686,6 +718,7 @@ bool usb_storage_control_request(struct usb_ctrlrequest* req, void* reqdata, uns
         case USB_BULK_RESET_REQUEST:
             logf("ums: bulk reset");
             state = WAITING_FOR_COMMAND;
+            read_ahead.count = 0;
             /* UMS BOT 3.1 says The device shall preserve the value of its bulk
                data toggle bits and endpoint STALL conditions despite
                the Bulk-Only Mass Storage Reset. */
@@ -701,38 +734,64 @@ bool usb_storage_control_request(struct usb_ctrlrequest* req, void* reqdata, uns
     return handled;
 }
 
+static int read_block_data(unsigned int sector, unsigned int count,
+                           unsigned char *data)
+{
+#ifdef USB_USE_RAMDISK
+    memcpy(data, ramdisk_buffer + sector*SECTOR_SIZE, count*SECTOR_SIZE);
+    return 0;
+#else
+    return storage_read_sectors(IF_MD(cur_cmd.lun,) sector, count, data);
+#endif
+}
+
+/* sectors per chunk for a READ(10) of count sectors */
+static unsigned int read_chunk_size(unsigned int count)
+{
+    if(count > READ_BUFFER_SIZE/SECTOR_SIZE)
+        return READ_BUFFER_SIZE/SECTOR_SIZE;
+    if(count*SECTOR_SIZE < READ_SPLIT_SIZE)
+        return count;
+    return (count+1)/2;
+}
+
 static void send_and_read_next(void)
 {
     int result = USBSTOR_READ_SECTORS_FILTER();
+    unsigned int count = MIN(cur_cmd.chunk, cur_cmd.count);
 
     if(result != 0 && cur_cmd.last_result == 0)
         cur_cmd.last_result = result;
 
-    send_block_data(cur_cmd.data[cur_cmd.data_select],
-                    MIN(READ_BUFFER_SIZE,cur_cmd.count*SECTOR_SIZE));
+    send_block_data(cur_cmd.data[cur_cmd.data_select], count*SECTOR_SIZE);
 
     /* Switch buffers for the next one */
     cur_cmd.data_select=!cur_cmd.data_select;
 
-    cur_cmd.sector+=(READ_BUFFER_SIZE/SECTOR_SIZE);
-    cur_cmd.count-=MIN(cur_cmd.count,READ_BUFFER_SIZE/SECTOR_SIZE);
+    cur_cmd.sector+=count;
+    cur_cmd.count-=count;
 
     if(cur_cmd.count!=0) {
         /* already read the next bit, so we can send it out immediately when the
          * current transfer completes.  */
-#ifdef USB_USE_RAMDISK
-        memcpy(cur_cmd.data[cur_cmd.data_select],
-                ramdisk_buffer + cur_cmd.sector*SECTOR_SIZE,
-                MIN(READ_BUFFER_SIZE/SECTOR_SIZE, cur_cmd.count)*SECTOR_SIZE);
-#else
-        result = storage_read_sectors(IF_MD(cur_cmd.lun,)
-                cur_cmd.sector,
-                MIN(READ_BUFFER_SIZE/SECTOR_SIZE, cur_cmd.count),
+        result = read_block_data(cur_cmd.sector,
+                MIN(cur_cmd.chunk, cur_cmd.count),
                 cur_cmd.data[cur_cmd.data_select]);
         if(cur_cmd.last_result == 0)
             cur_cmd.last_result = result;
+        return;
+    }
 
-#endif
+    read_ahead.lun = cur_cmd.lun;
+    read_ahead.sector = cur_cmd.sector;
+
+    if(cur_cmd.sequential && cur_cmd.last_result == 0) {
+        count = MIN(cur_cmd.chunk, cur_cmd.num_sectors - cur_cmd.sector);
+        if(count != 0 && read_block_data(cur_cmd.sector, count,
+                                cur_cmd.data[cur_cmd.data_select]) == 0) {
+            read_ahead.count = count;
+            read_ahead.data_select = cur_cmd.data_select;
+        }
     }
 }
 /****************************************************************************/
@@ -748,6 +807,7 @@ static void handle_scsi(struct command_block_wrapper* cbw)
     bool lun_present=true;
     unsigned char lun = cbw->lun;
     unsigned int block_size_mult = 1;
+    unsigned int read_ahead_count;
 
     if(letoh32(cbw->signature) != CBW_SIGNATURE) {
         logf("ums: bad cbw signature (%x)", cbw->signature);
@@ -760,6 +820,10 @@ static void handle_scsi(struct command_block_wrapper* cbw)
      * bogus data */
     cbw->signature=0;
 
+    /* Sectors read ahead only serve a READ(10) that comes right after */
+    read_ahead_count = read_ahead.count;
+    read_ahead.count = 0;
+
 #if defined(HAVE_MULTIDRIVE)
     if(skip_first) lun++;
 #endif
@@ -1057,8 +1121,8 @@ static void handle_scsi(struct command_block_wrapper* cbw)
                 cur_sense_data.ascq=0;
                 break;
             }
-            cur_cmd.data[0] = tb.transfer_buffer;
-            cur_cmd.data[1] = &tb.transfer_buffer[READ_BUFFER_SIZE];
+            cur_cmd.data[0] = block_buffer;
+            cur_cmd.data[1] = &block_buffer[READ_BUFFER_SIZE];
             cur_cmd.data_select=0;
             cur_cmd.sector = block_size_mult *
                 (cbw->command_block[2] << 24 |
@@ -1069,6 +1133,10 @@ static void handle_scsi(struct command_block_wrapper* cbw)
                 (cbw->command_block[7] << 8 |
                  cbw->command_block[8]);
             cur_cmd.orig_count = cur_cmd.count;
+            cur_cmd.chunk = read_chunk_size(cur_cmd.count);
+            cur_cmd.num_sectors = block_count;
+            cur_cmd.sequential = (read_ahead.lun == lun &&
+                                  read_ahead.sector == cur_cmd.sector);
 
             //logf("scsi read %d %d", cur_cmd.sector, cur_cmd.count);
 
@@ -1078,17 +1146,17 @@ static void handle_scsi(struct command_block_wrapper* cbw)
                 cur_sense_data.asc=ASC_LBA_OUT_OF_RANGE;
                 cur_sense_data.ascq=0;
             }
+            else if(cur_cmd.sequential && read_ahead_count != 0 &&
+                    read_ahead_count >= MIN(cur_cmd.chunk, cur_cmd.count)) {
+                /* The first chunk is already there */
+                cur_cmd.data_select = read_ahead.data_select;
+                cur_cmd.last_result = 0;
+                send_and_read_next();
+            }
             else {
-#ifdef USB_USE_RAMDISK
-                memcpy(cur_cmd.data[cur_cmd.data_select],
-                        ramdisk_buffer + cur_cmd.sector*SECTOR_SIZE,
-                        MIN(READ_BUFFER_SIZE/SECTOR_SIZE,cur_cmd.count)*SECTOR_SIZE);
-#else
-                cur_cmd.last_result = storage_read_sectors(IF_MD(cur_cmd.lun,)
-                        cur_cmd.sector,
-                        MIN(READ_BUFFER_SIZE/SECTOR_SIZE, cur_cmd.count),
+                cur_cmd.last_result = read_block_data(cur_cmd.sector,
+                        MIN(cur_cmd.chunk, cur_cmd.count),
                         cur_cmd.data[cur_cmd.data_select]);
-#endif
                 send_and_read_next();
             }
             break;
@@ -1102,8 +1170,8 @@ static void handle_scsi(struct command_block_wrapper* cbw)
                 cur_sense_data.ascq=0;
                 break;
             }
-            cur_cmd.data[0] = tb.transfer_buffer;
-            cur_cmd.data[1] = &tb.transfer_buffer[WRITE_BUFFER_SIZE];
+            cur_cmd.data[0] = block_buffer;
+            cur_cmd.data[1] = &block_buffer[WRITE_BUFFER_SIZE];
             cur_cmd.data_select=0;
             cur_cmd.sector = block_size_mult *
                 (cbw->command_block[2] << 24 |
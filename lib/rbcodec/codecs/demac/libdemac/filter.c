@@ -48,8 +48,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA
 #elif defined(CPU_ARM) && (ARM_ARCH >= 5)
 /* Assume all our ARMv5 targets are ARMv5te(j) */
 #include "vector_math16_armv5te.h"
-#elif (defined(__i386__) || defined(__i486__))  && defined(__MMX__) \
-    || defined(__x86_64__)
+#elif defined(__SSE2__)
+/* x86-64, or i386 built for SSE2 */
+#include "vector_math16_x86.h"
+#elif (defined(__i386__) || defined(__i486__))  && defined(__MMX__)
 #include "vector_math16_mmx.h"
 #else
 #include "vector_math_generic.h"
@@ -282,6 +284,10 @@ static void do_init_filter(struct filter_t* f, filter_int* buf)
 
 void INIT_FILTER(filter_int* buf)
 {
+#ifdef INIT_VECTOR_MATH
+    INIT_VECTOR_MATH
+#endif
+
     do_init_filter(&filter[0], buf);
     do_init_filter(&filter[1], buf + ORDER*3 + FILTER_HISTORY_SIZE);
 }
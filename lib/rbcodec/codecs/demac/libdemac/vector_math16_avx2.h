@@ -0,0 +1,118 @@
+/*
+
+libdemac - A Monkey's Audio decoder
+
+$Id$
+
+Copyright (C) Dave Chapman 2007
+
+AVX2 vector math
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA
+
+*/
+
+#include <immintrin.h>
+
+/* Same layout as the SSE2 version with 16 x 16 bit registers, so the order
+ * must be a multiple of 32. When the compiler isn't already targeting AVX2
+ * the functions are built for it individually and selected at runtime. */
+
+#if ORDER % 32
+#error AVX2 vector math needs an order that is a multiple of 32
+#endif
+
+#ifdef __AVX2__
+#define AVX2_ATTR
+#else
+#define AVX2_ATTR __attribute__((target("avx2")))
+#endif
+
+static inline AVX2_ATTR int32_t hsum_epi32_avx2(__m256i x)
+{
+    __m128i y = _mm_add_epi32(_mm256_castsi256_si128(x),
+                              _mm256_extracti128_si256(x, 1));
+    y = _mm_add_epi32(y, _mm_shuffle_epi32(y, _MM_SHUFFLE(1, 0, 3, 2)));
+    y = _mm_add_epi32(y, _mm_shuffle_epi32(y, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(y);
+}
+
+/* Scalar product of v1 and f2, then v1 += s2 (sub == 0) or v1 -= s2 */
+static inline AVX2_ATTR int32_t vector_sp_avx2(int16_t* v1, int16_t* f2,
+                                               int16_t* s2, const int sub)
+{
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i < ORDER; i += 32)
+    {
+        __m256i c0 = _mm256_loadu_si256((__m256i *)(v1 + i));
+        __m256i c1 = _mm256_loadu_si256((__m256i *)(v1 + i + 16));
+        __m256i a0 = _mm256_loadu_si256((__m256i *)(s2 + i));
+        __m256i a1 = _mm256_loadu_si256((__m256i *)(s2 + i + 16));
+
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(c0,
+                   _mm256_loadu_si256((__m256i *)(f2 + i))));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(c1,
+                   _mm256_loadu_si256((__m256i *)(f2 + i + 16))));
+
+        if (sub)
+        {
+            c0 = _mm256_sub_epi16(c0, a0);
+            c1 = _mm256_sub_epi16(c1, a1);
+        }
+        else
+        {
+            c0 = _mm256_add_epi16(c0, a0);
+            c1 = _mm256_add_epi16(c1, a1);
+        }
+        _mm256_storeu_si256((__m256i *)(v1 + i), c0);
+        _mm256_storeu_si256((__m256i *)(v1 + i + 16), c1);
+    }
+
+    return hsum_epi32_avx2(_mm256_add_epi32(acc0, acc1));
+}
+
+static AVX2_ATTR int32_t vector_sp_add_avx2(int16_t* v1, int16_t* f2,
+                                            int16_t* s2)
+{
+    return vector_sp_avx2(v1, f2, s2, 0);
+}
+
+static AVX2_ATTR int32_t vector_sp_sub_avx2(int16_t* v1, int16_t* f2,
+                                            int16_t* s2)
+{
+    return vector_sp_avx2(v1, f2, s2, 1);
+}
+
+static AVX2_ATTR int32_t scalarproduct_avx2(int16_t* v1, int16_t* v2)
+{
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i < ORDER; i += 32)
+    {
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(
+                   _mm256_loadu_si256((__m256i *)(v1 + i)),
+                   _mm256_loadu_si256((__m256i *)(v2 + i))));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(
+                   _mm256_loadu_si256((__m256i *)(v1 + i + 16)),
+                   _mm256_loadu_si256((__m256i *)(v2 + i + 16))));
+    }
+
+    return hsum_epi32_avx2(_mm256_add_epi32(acc0, acc1));
+}
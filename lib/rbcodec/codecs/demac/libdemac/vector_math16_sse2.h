@@ -0,0 +1,107 @@
+/*
+
+libdemac - A Monkey's Audio decoder
+
+$Id$
+
+Copyright (C) Dave Chapman 2007
+
+SSE2 vector math
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA
+
+*/
+
+#include <emmintrin.h>
+
+/* All filter orders are multiples of 16, so every loop below handles two
+ * 8 x 16 bit registers per round. Only the coefficients are aligned; the
+ * history pointers advance one sample at a time, hence unaligned loads
+ * throughout. */
+
+static inline int32_t hsum_epi32_sse2(__m128i x)
+{
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(x);
+}
+
+/* Scalar product of v1 and f2, then v1 += s2 (sub == 0) or v1 -= s2 */
+static inline int32_t vector_sp_sse2(int16_t* v1, int16_t* f2, int16_t* s2,
+                                     const int sub)
+{
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < ORDER; i += 16)
+    {
+        __m128i c0 = _mm_loadu_si128((__m128i *)(v1 + i));
+        __m128i c1 = _mm_loadu_si128((__m128i *)(v1 + i + 8));
+        __m128i a0 = _mm_loadu_si128((__m128i *)(s2 + i));
+        __m128i a1 = _mm_loadu_si128((__m128i *)(s2 + i + 8));
+
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(c0,
+                   _mm_loadu_si128((__m128i *)(f2 + i))));
+        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(c1,
+                   _mm_loadu_si128((__m128i *)(f2 + i + 8))));
+
+        if (sub)
+        {
+            c0 = _mm_sub_epi16(c0, a0);
+            c1 = _mm_sub_epi16(c1, a1);
+        }
+        else
+        {
+            c0 = _mm_add_epi16(c0, a0);
+            c1 = _mm_add_epi16(c1, a1);
+        }
+        _mm_storeu_si128((__m128i *)(v1 + i), c0);
+        _mm_storeu_si128((__m128i *)(v1 + i + 8), c1);
+    }
+
+    return hsum_epi32_sse2(_mm_add_epi32(acc0, acc1));
+}
+
+static inline int32_t vector_sp_add_sse2(int16_t* v1, int16_t* f2,
+                                         int16_t* s2)
+{
+    return vector_sp_sse2(v1, f2, s2, 0);
+}
+
+static inline int32_t vector_sp_sub_sse2(int16_t* v1, int16_t* f2,
+                                         int16_t* s2)
+{
+    return vector_sp_sse2(v1, f2, s2, 1);
+}
+
+static inline int32_t scalarproduct_sse2(int16_t* v1, int16_t* v2)
+{
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < ORDER; i += 16)
+    {
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(
+                   _mm_loadu_si128((__m128i *)(v1 + i)),
+                   _mm_loadu_si128((__m128i *)(v2 + i))));
+        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(
+                   _mm_loadu_si128((__m128i *)(v1 + i + 8)),
+                   _mm_loadu_si128((__m128i *)(v2 + i + 8))));
+    }
+
+    return hsum_epi32_sse2(_mm_add_epi32(acc0, acc1));
+}
@@ -0,0 +1,123 @@
+/*
+
+libdemac - A Monkey's Audio decoder
+
+$Id$
+
+Copyright (C) Dave Chapman 2007
+
+x86 vector math selection
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110, USA
+
+*/
+
+#define FUSED_VECTOR_MATH
+
+#include "vector_math16_sse2.h"
+
+/* AVX2 only pays off from order 64 up; below that the out-of-line call
+ * costs more than the wider registers save. */
+#if ORDER >= 64 && defined(__GNUC__)
+#include "vector_math16_avx2.h"
+
+#ifdef __AVX2__
+
+static inline int32_t vector_sp_add(int16_t* v1, int16_t* f2, int16_t* s2)
+{
+    return vector_sp_add_avx2(v1, f2, s2);
+}
+
+static inline int32_t vector_sp_sub(int16_t* v1, int16_t* f2, int16_t* s2)
+{
+    return vector_sp_sub_avx2(v1, f2, s2);
+}
+
+static inline int32_t scalarproduct(int16_t* v1, int16_t* v2)
+{
+    return scalarproduct_avx2(v1, v2);
+}
+
+#else /* !__AVX2__ */
+
+#include <stdbool.h>
+#include <cpuid.h>
+
+static bool use_avx2;
+
+/* AVX2 needs support from both the CPU and the OS (saving the YMM state) */
+static bool cpu_has_avx2(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+        !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+        return false;
+
+    asm ("xgetbv" : "=a"(xcr0) : "c"(0) : "edx");
+    if ((xcr0 & 6) != 6)
+        return false;
+
+    if (__get_cpuid_max(0, NULL) < 7)
+        return false;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & bit_AVX2;
+}
+
+#define INIT_VECTOR_MATH use_avx2 = cpu_has_avx2();
+
+static inline int32_t vector_sp_add(int16_t* v1, int16_t* f2, int16_t* s2)
+{
+    if (use_avx2)
+        return vector_sp_add_avx2(v1, f2, s2);
+    return vector_sp_add_sse2(v1, f2, s2);
+}
+
+static inline int32_t vector_sp_sub(int16_t* v1, int16_t* f2, int16_t* s2)
+{
+    if (use_avx2)
+        return vector_sp_sub_avx2(v1, f2, s2);
+    return vector_sp_sub_sse2(v1, f2, s2);
+}
+
+static inline int32_t scalarproduct(int16_t* v1, int16_t* v2)
+{
+    if (use_avx2)
+        return scalarproduct_avx2(v1, v2);
+    return scalarproduct_sse2(v1, v2);
+}
+
+#endif /* __AVX2__ */
+
+#else /* ORDER < 64 */
+
+static inline int32_t vector_sp_add(int16_t* v1, int16_t* f2, int16_t* s2)
+{
+    return vector_sp_add_sse2(v1, f2, s2);
+}
+
+static inline int32_t vector_sp_sub(int16_t* v1, int16_t* f2, int16_t* s2)
+{
+    return vector_sp_sub_sse2(v1, f2, s2);
+}
+
+static inline int32_t scalarproduct(int16_t* v1, int16_t* v2)
+{
+    return scalarproduct_sse2(v1, v2);
+}
+
+#endif /* ORDER */
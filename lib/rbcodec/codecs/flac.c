@@ -34,61 +34,145 @@ static int32_t decoded3[MAX_BLOCKSIZE] IBSS_ATTR_FLAC_LARGE_IRAM;
 static int32_t decoded4[MAX_BLOCKSIZE] IBSS_ATTR_FLAC_XLARGE_IRAM;
 static int32_t decoded5[MAX_BLOCKSIZE] IBSS_ATTR_FLAC_XLARGE_IRAM;
 
-#define MAX_SUPPORTED_SEEKTABLE_SIZE 5000
-
 /* Notes about seeking:
 
-   The full seek table consists of:
+   A seek point in the SEEKTABLE consists of:
       uint64_t sample (only 36 bits are used)
-      uint64_t offset
-      uint32_t blocksize
-
-   We also limit the sample and offset values to 32-bits - Rockbox doesn't
-   support files bigger than 2GB on FAT32 filesystems.
+      uint64_t offset (relative to the first frame header)
+      uint16_t blocksize
 
    The reference FLAC encoder produces a seek table with points every
    10 seconds, but this can be overridden by the user when encoding a file.
-
    With the default settings, a typical 4 minute track will contain
-   24 seek points.
+   24 seek points, a 13 hour recording close to 5000.
 
-   Taking the extreme case of a Rockbox supported file to be a 2GB (compressed)
-   16-bit/44.1KHz mono stream with a likely uncompressed size of 4GB:
-      Total duration is: 48694 seconds (about 810 minutes - 13.5 hours)
-      Total number of seek points: 4869
+   The points are kept in the codec buffer, without the blocksize which the
+   seek doesn't need. If the table doesn't fit, every other point is
+   dropped until it does. Placeholder points are skipped.
 
-   Therefore we limit the number of seek points to 5000.  This is a
-   very extreme case, and requires 5000*8=40000 bytes of storage.
-
-   If we come across a FLAC file with more than this number of seekpoints, we
-   just use the first 5000.
+   Files without a SEEKTABLE get an index of frame positions built while
+   they are decoded, so a seek into the part that has already been played
+   lands on or next to the right frame instead of searching the whole file.
+   The index has a fixed number of slots: when they are used up, every
+   other point is dropped and the spacing doubled.
 
 */
 
-struct FLACseekpoints {
-    uint32_t sample;
-    uint32_t offset;
-    uint16_t blocksize;
+struct FLACseekpoint {
+    uint64_t sample;
+    uint64_t offset;
 };
 
-static struct FLACseekpoints seekpoints[MAX_SUPPORTED_SEEKTABLE_SIZE];
+/* Spacing of generated index points in seconds, and the number of slots */
+#define FLAC_INDEX_INTERVAL 2
+#define FLAC_INDEX_SIZE     1024
+
+static struct FLACseekpoint *seekpoints;
 static int nseekpoints;
+static int maxseekpoints;
+static uint64_t index_interval; /* in samples, 0 when not indexing */
 
 static int8_t *bit_buffer;
 static size_t buff_size;
 
+static inline uint32_t be32(const unsigned char *buf)
+{
+    return ((uint32_t)buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
+}
+
+/* Allocate room for count points from the codec buffer, halving count
+   until it fits. Returns the stride between stored points or 0 if not even
+   one point fits. */
+static int alloc_seekpoints(int count)
+{
+    int stride = 1;
+
+    while (count > 0) {
+        int n = (count + stride - 1) / stride;
+        seekpoints = codec_malloc(n * sizeof(struct FLACseekpoint));
+        if (seekpoints) {
+            maxseekpoints = n;
+            return stride;
+        }
+        if (n == 1)
+            break;
+        stride *= 2;
+    }
+
+    maxseekpoints = 0;
+    return 0;
+}
+
+static void read_seektable(uint32_t blocklength)
+{
+    unsigned char buf[18];
+    int count = blocklength / 18;
+    int stride = alloc_seekpoints(count);
+    int i;
+
+    for (i = 0; i < count; i++) {
+        uint64_t sample, offset;
+
+        if (ci->read_filebuf(buf, 18) < 18)
+            return;
+        blocklength -= 18;
+
+        if (!stride || i % stride)
+            continue;
+
+        sample = ((uint64_t)be32(&buf[0]) << 32) | be32(&buf[4]);
+        offset = ((uint64_t)be32(&buf[8]) << 32) | be32(&buf[12]);
+
+        /* Placeholder points have all bits set */
+        if (sample == ~(uint64_t)0 ||
+            nseekpoints >= maxseekpoints)
+            continue;
+
+        seekpoints[nseekpoints].sample = sample;
+        seekpoints[nseekpoints].offset = offset;
+        nseekpoints++;
+    }
+
+    /* Skip any padding at the end of the block */
+    if (blocklength > 0)
+        ci->advance_buffer(blocklength);
+}
+
+/* Add the frame at file position pos to the generated index, if it is far
+   enough past the last point */
+static void index_frame(FLACContext* fc, off_t pos)
+{
+    uint64_t sample = fc->samplenumber;
+
+    if (nseekpoints > 0 &&
+        sample < seekpoints[nseekpoints-1].sample + index_interval)
+        return;
+
+    if (nseekpoints >= maxseekpoints) {
+        int i;
+        for (i = 0; i < nseekpoints / 2; i++)
+            seekpoints[i] = seekpoints[2*i];
+        nseekpoints /= 2;
+        index_interval *= 2;
+    }
+
+    seekpoints[nseekpoints].sample = sample;
+    seekpoints[nseekpoints].offset = pos - fc->metadatalength;
+    nseekpoints++;
+}
+
 static bool flac_init(FLACContext* fc, int first_frame_offset)
 {
     unsigned char buf[255];
     bool found_streaminfo=false;
-    uint32_t seekpoint_hi,seekpoint_lo;
-    uint32_t offset_hi,offset_lo;
-    uint16_t blocksize;
     int endofmetadata=0;
     uint32_t blocklength;
 
     ci->memset(fc,0,sizeof(FLACContext));
+    seekpoints=NULL;
     nseekpoints=0;
+    maxseekpoints=0;
+    index_interval=0;
 
     fc->sample_skip = 0;
 
@@ -156,45 +240,18 @@ static bool flac_init(FLACContext* fc, int first_frame_offset)
             fc->channels = ((buf[12]&0x0e)>>1) + 1;
             fc->bps = (((buf[12]&0x01) << 4) | ((buf[13]&0xf0)>>4) ) + 1;
 
-            /* totalsamples is a 36-bit field, but we assume <= 32 bits are 
-               used */
-            fc->totalsamples = (buf[14] << 24) | (buf[15] << 16) 
-                               | (buf[16] << 8) | buf[17];
+            /* totalsamples is a 36-bit field */
+            fc->totalsamples = ((uint64_t)(buf[13] & 0x0f) << 32)
+                               | be32(&buf[14]);
 
             /* Calculate track length (in ms) and estimate the bitrate 
                (in kbit/s) */
             fc->length = ((int64_t) fc->totalsamples * 1000) / fc->samplerate;
 
             found_streaminfo=true;
-        } else if ((buf[0] & 0x7f) == 3) { /* 3 is the SEEKTABLE block */
-            while ((nseekpoints < MAX_SUPPORTED_SEEKTABLE_SIZE) && 
-                   (blocklength >= 18)) {
-                if (ci->read_filebuf(buf,18) < 18) return false;
-                blocklength-=18;
-
-                seekpoint_hi=(buf[0] << 24) | (buf[1] << 16) | 
-                             (buf[2] << 8) | buf[3];
-                seekpoint_lo=(buf[4] << 24) | (buf[5] << 16) | 
-                             (buf[6] << 8) | buf[7];
-                offset_hi=(buf[8] << 24) | (buf[9] << 16) | 
-                             (buf[10] << 8) | buf[11];
-                offset_lo=(buf[12] << 24) | (buf[13] << 16) | 
-                             (buf[14] << 8) | buf[15];
-
-                blocksize=(buf[16] << 8) | buf[17];
-
-                /* Only store seekpoints where the high 32 bits are zero */
-                if ((seekpoint_hi == 0) && (seekpoint_lo != 0xffffffff) &&
-                    (offset_hi == 0)) {
-                        seekpoints[nseekpoints].sample=seekpoint_lo;
-                        seekpoints[nseekpoints].offset=offset_lo;
-                        seekpoints[nseekpoints].blocksize=blocksize;
-                        nseekpoints++;
-                }
-            }
-            /* Skip any unread seekpoints */
-            if (blocklength > 0)
-                ci->advance_buffer(blocklength);
+        } else if ((buf[0] & 0x7f) == 3 && !seekpoints) {
+            /* 3 is the SEEKTABLE block */
+            read_seektable(blocklength);
         } else {
           /* Skip to next metadata block */
           ci->advance_buffer(blocklength);
@@ -202,6 +259,16 @@ static bool flac_init(FLACContext* fc, int first_frame_offset)
     }
 
    if (found_streaminfo) {
+       /* No usable seek table, index the frames as they are decoded */
+       if (nseekpoints == 0) {
+           seekpoints = codec_malloc(FLAC_INDEX_SIZE *
+                                     sizeof(struct FLACseekpoint));
+           if (seekpoints) {
+               maxseekpoints = FLAC_INDEX_SIZE;
+               index_interval = (uint64_t)fc->samplerate * FLAC_INDEX_INTERVAL;
+           }
+       }
+
        fc->bitrate = ((int64_t) (fc->filesize-fc->metadatalength) * 8) 
                      / fc->length;
        return true;
@@ -263,14 +330,14 @@ static bool frame_sync(FLACContext* fc) {
 }
 
 /* Seek to sample - adapted from libFLAC 1.1.3b2+ */
-static bool flac_seek(FLACContext* fc, uint32_t target_sample) {
+static bool flac_seek(FLACContext* fc, uint64_t target_sample) {
     off_t orig_pos = ci->curpos;
     off_t pos = -1;
     unsigned long lower_bound, upper_bound;
-    unsigned long lower_bound_sample, upper_bound_sample;
+    uint64_t lower_bound_sample, upper_bound_sample;
     int i;
     unsigned approx_bytes_per_frame;
-    uint32_t this_frame_sample = fc->samplenumber;
+    uint64_t this_frame_sample = fc->samplenumber;
     unsigned this_block_size = fc->blocksize;
     bool needs_seek = true, first_seek = true;
 
@@ -291,24 +358,22 @@ static bool flac_seek(FLACContext* fc, uint32_t target_sample) {
 
     /* Refine the bounds if we have a seektable with suitable points. */
     if(nseekpoints > 0) {
-        /* Find the closest seek point <= target_sample, if it exists. */
-        for(i = nseekpoints-1; i >= 0; i--) {
+        /* Find the first seek point > target_sample */
+        int lo = 0, hi = nseekpoints;
+        while(lo < hi) {
+            i = (lo + hi) / 2;
             if(seekpoints[i].sample <= target_sample)
-                break;
-        }
-        if(i >= 0) { /* i.e. we found a suitable seek point... */
-            lower_bound = fc->metadatalength + seekpoints[i].offset;
-            lower_bound_sample = seekpoints[i].sample;
+                lo = i + 1;
+            else
+                hi = i;
         }
-
-        /* Find the closest seek point > target_sample, if it exists. */
-        for(i = 0; i < nseekpoints; i++) {
-            if(seekpoints[i].sample > target_sample)
-                break;
+        if(lo > 0) { /* the closest seek point <= target_sample */
+            lower_bound = fc->metadatalength + seekpoints[lo-1].offset;
+            lower_bound_sample = seekpoints[lo-1].sample;
         }
-        if(i < nseekpoints) { /* i.e. we found a suitable seek point... */
-            upper_bound = fc->metadatalength + seekpoints[i].offset;
-            upper_bound_sample = seekpoints[i].sample;
+        if(lo < nseekpoints) {
+            upper_bound = fc->metadatalength + seekpoints[lo].offset;
+            upper_bound_sample = seekpoints[lo].sample;
         }
     }
 
@@ -321,10 +386,17 @@ static bool flac_seek(FLACContext* fc, uint32_t target_sample) {
 
         /* Calculate new seek position */
         if(needs_seek) {
-            pos = (off_t)(lower_bound +
-              (((target_sample - lower_bound_sample) *
-              (int64_t)(upper_bound - lower_bound)) /
-              (upper_bound_sample - lower_bound_sample)) -
+            uint64_t span = upper_bound_sample - lower_bound_sample;
+            uint64_t dist = target_sample - lower_bound_sample;
+
+            /* Keep the product within 64 bits */
+            while(span > UINT32_MAX) {
+                span >>= 1;
+                dist >>= 1;
+            }
+
+            pos = (off_t)((int64_t)lower_bound +
+              (int64_t)((dist * (upper_bound - lower_bound)) / span) -
               approx_bytes_per_frame);
             
             if(pos >= (off_t)upper_bound)
@@ -455,7 +527,7 @@ enum codec_status codec_main(enum codec_entry_call_reason reason)
 enum codec_status codec_run(void)
 {
     int8_t *buf;
-    uint32_t samplesdone;
+    uint64_t samplesdone;
     uint32_t elapsedtime;
     size_t bytesleft;
     int consumed;
@@ -485,9 +557,9 @@ enum codec_status codec_run(void)
     if (samplesdone || !elapsedtime) {
         flac_seek_offset(&fc, samplesdone);
         samplesdone=fc.samplenumber+fc.blocksize;
-        elapsedtime=((uint64_t)samplesdone*1000)/(ci->id3->frequency);
+        elapsedtime=(samplesdone*1000)/(ci->id3->frequency);
     }
-    else if (!flac_seek(&fc,(uint32_t)((uint64_t)elapsedtime
+    else if (!flac_seek(&fc,((uint64_t)elapsedtime
                             *ci->id3->frequency/1000))) {
         elapsedtime = 0;
     }
@@ -505,7 +577,7 @@ enum codec_status codec_run(void)
 
         /* Deal with any pending seek requests */
         if (action == CODEC_ACTION_SEEK_TIME) {
-            if (flac_seek(&fc,(uint32_t)(((uint64_t)param
+            if (flac_seek(&fc,(((uint64_t)param
                 *ci->id3->frequency)/1000))) {
                 /* Refill the input buffer */
                 buf = ci->request_buffer(&bytesleft, MAX_FRAMESIZE);
@@ -520,6 +592,8 @@ enum codec_status codec_run(void)
              LOGF("FLAC: Frame %d, error %d\n",frame,res);
              return CODEC_ERROR;
         }
+        if (index_interval)
+            index_frame(&fc, ci->curpos);
         consumed=fc.gb.index/8;
         frame++;
 
@@ -531,7 +605,7 @@ enum codec_status codec_run(void)
 
         /* Update the elapsed-time indicator */
         samplesdone=fc.samplenumber+fc.blocksize;
-        elapsedtime=((uint64_t)samplesdone*1000)/(ci->id3->frequency);
+        elapsedtime=(samplesdone*1000)/(ci->id3->frequency);
         ci->set_elapsed(elapsedtime);
 
         ci->advance_buffer(consumed);
@@ -46,6 +46,8 @@
 #include "coldfire.h"
 #elif defined(CPU_ARM)
 #include "arm.h"
+#elif defined(__x86_64__)
+#include "x86.h"
 #endif
 
 static const int sample_rate_table[] ICONST_ATTR =
@@ -134,6 +136,59 @@ static int get_crc8(const uint8_t *buf, int count)
     return crc;
 }
 
+#if UINTPTR_MAX > 0xffffffff
+/* On 64-bit hosts Rice codes are read from a 64-bit window: a single load
+ * gives at least 57 bits, enough for several short codes. Decodes up to
+ * count samples and returns how many were done; it stops at a code that
+ * doesn't fit the window or that needs the escape/limit handling of
+ * get_sr_golomb_flac(), and near the end of the buffer. */
+#define FLAC_RICE_64BIT
+
+static inline int decode_rice_64(GetBitContext *gb, int32_t *decoded,
+                                 int count, int k, int limit)
+{
+    const uint8_t *last = gb->buffer_end - 8;
+    unsigned int index = gb->index;
+    int done = 0;
+
+    while (done < count && gb->buffer + (index >> 3) <= last)
+    {
+        uint64_t cache = AV_RB64(gb->buffer + (index >> 3)) << (index & 7);
+        int avail = 64 - (index & 7);
+        int start = done;
+
+        while (done < count)
+        {
+            int q, len;
+            uint32_t v;
+
+            if (!cache)
+                break;
+            q   = __builtin_clzll(cache);
+            len = q + 1 + k;
+            if (len > avail || q >= limit - 1)
+                break;
+
+            /* q < limit - 1 keeps (q << k) | bits within INT_MAX */
+            v = ((uint32_t)q << k) |
+                (k ? (uint32_t)((cache << (q + 1)) >> (64 - k)) : 0);
+            *decoded++ = (v >> 1) ^ -(v & 1);
+            done++;
+
+            index += len;
+            avail -= len;
+            cache  = (len < 64) ? cache << len : 0;
+        }
+
+        if (done == start)
+            break; /* the next code is too long for any window */
+    }
+
+    gb->index = index;
+    return done;
+}
+#endif
+
 static int decode_residuals(FLACContext *s, int32_t* decoded, int pred_order) ICODE_ATTR_FLAC;
 static int decode_residuals(FLACContext *s, int32_t *decoded, int pred_order)
 {
@@ -166,6 +221,14 @@ static int decode_residuals(FLACContext *s, int32_t *decoded, int pred_order)
         } else {
             int real_limit = tmp ? (INT_MAX >> tmp) + 2 : INT_MAX;
             for (; i < samples; i++) {
+#ifdef FLAC_RICE_64BIT
+                int n = decode_rice_64(&gb, decoded, samples - i, tmp,
+                                       real_limit);
+                decoded += n;
+                i += n;
+                if (i >= samples)
+                    break;
+#endif
                 int v = get_sr_golomb_flac(&gb, tmp, real_limit, 0);
                 if ((unsigned) v == 0x80000000){
                     return -3;
@@ -325,6 +388,12 @@ static int decode_subframe_lpc(FLACContext *s, int32_t* decoded, int pred_order,
         lpc_decode_arm(s->blocksize - pred_order, qlevel, pred_order,
                        decoded + pred_order, coeffs);
         #else
+        #ifdef LPC_SSE41_MIN_ORDER
+        if (pred_order >= LPC_SSE41_MIN_ORDER && x86_has_sse41())
+            lpc_decode_sse41(decoded, coeffs, pred_order, qlevel,
+                             s->blocksize);
+        else
+        #endif
         for (i = pred_order; i < s->blocksize; i++)
         {
             sum = 0;
@@ -338,6 +407,12 @@ static int decode_subframe_lpc(FLACContext *s, int32_t* decoded, int pred_order,
         lpc_decode_emac_wide(s->blocksize - pred_order, qlevel, pred_order,
                              decoded + pred_order, coeffs);
         #else
+        #ifdef LPC_SSE41_MIN_ORDER
+        if (pred_order >= LPC_SSE41_MIN_ORDER && x86_has_sse41())
+            lpc_decode_wide_sse41(decoded, coeffs, pred_order, qlevel,
+                                  s->blocksize);
+        else
+        #endif
         flac_lpc_32_c(decoded, coeffs, pred_order, qlevel, s->blocksize);
 
         if (bps <= 16)
@@ -25,8 +25,8 @@ typedef struct FLACContext {
     int samplerate, channels;
     int blocksize/*, last_blocksize*/;
     int bps;
-    unsigned long samplenumber;
-    unsigned long totalsamples;
+    uint64_t samplenumber;
+    uint64_t totalsamples;
     enum decorrelation_type ch_mode;
 
     int filesize;
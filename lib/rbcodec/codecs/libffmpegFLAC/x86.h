@@ -0,0 +1,127 @@
+#ifndef _FLAC_X86_H
+#define _FLAC_X86_H
+
+/* SSE4.1 LPC synthesis for x86-64 hosted builds.
+ *
+ * Each output depends on the previous one, so a straight dot product per
+ * sample doesn't vectorise well. Instead the samples are produced four at a
+ * time: the taps 4..order-1 of all four outputs only read samples from
+ * before the block and are summed with SIMD, the first four taps are then
+ * added serially. Unless the compiler already targets SSE4.1 the functions
+ * are built for it individually and chosen at runtime from CPUID. */
+
+#include <stdbool.h>
+#include <cpuid.h>
+#include <immintrin.h>
+#include <inttypes.h>
+
+#ifdef __SSE4_1__
+#define SSE41_ATTR
+#else
+#define SSE41_ATTR __attribute__((target("sse4.1")))
+#endif
+
+/* Below this order the plain C loops are as fast */
+#define LPC_SSE41_MIN_ORDER 8
+
+static bool x86_has_sse41(void)
+{
+#ifdef __SSE4_1__
+    return true;
+#else
+    static int has = -1;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (has < 0)
+        has = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_1);
+    return has;
+#endif
+}
+
+/* 32-bit accumulation, as long as it can't overflow */
+static SSE41_ATTR void lpc_decode_sse41(int32_t *decoded, const int *coeffs,
+                                        int pred_order, int qlevel, int len)
+{
+    const int32_t c0 = coeffs[0], c1 = coeffs[1],
+                  c2 = coeffs[2], c3 = coeffs[3];
+    int i, j;
+
+    for (i = pred_order; i + 4 <= len; i += 4)
+    {
+        int32_t *d = decoded + i;
+        int32_t acc[4] __attribute__((aligned(16)));
+        int32_t x1 = d[-1], x2 = d[-2], x3 = d[-3], x4 = d[-4];
+        __m128i sum = _mm_setzero_si128();
+
+        for (j = 4; j < pred_order; j++)
+            sum = _mm_add_epi32(sum,
+                      _mm_mullo_epi32(_mm_set1_epi32(coeffs[j]),
+                          _mm_loadu_si128((const __m128i *)(d - j - 1))));
+        _mm_store_si128((__m128i *)acc, sum);
+
+        for (j = 0; j < 4; j++)
+        {
+            int32_t y = d[j] +
+                ((acc[j] + c0*x1 + c1*x2 + c2*x3 + c3*x4) >> qlevel);
+            d[j] = y;
+            x4 = x3; x3 = x2; x2 = x1; x1 = y;
+        }
+    }
+
+    for (; i < len; i++)
+    {
+        int32_t sum = 0;
+        for (j = 0; j < pred_order; j++)
+            sum += coeffs[j] * decoded[i-j-1];
+        decoded[i] += sum >> qlevel;
+    }
+}
+
+/* 64-bit accumulation. _mm_mul_epi32 only multiplies the even lanes, so the
+ * odd outputs are done from a copy shifted down by one lane. */
+static SSE41_ATTR void lpc_decode_wide_sse41(int32_t *decoded,
+                                             const int *coeffs,
+                                             int pred_order, int qlevel,
+                                             int len)
+{
+    const int64_t c0 = coeffs[0], c1 = coeffs[1],
+                  c2 = coeffs[2], c3 = coeffs[3];
+    int i, j;
+
+    for (i = pred_order; i + 4 <= len; i += 4)
+    {
+        int32_t *d = decoded + i;
+        int64_t acc[4] __attribute__((aligned(16)));
+        int64_t x1 = d[-1], x2 = d[-2], x3 = d[-3], x4 = d[-4];
+        __m128i even = _mm_setzero_si128(), odd = _mm_setzero_si128();
+
+        for (j = 4; j < pred_order; j++)
+        {
+            __m128i c = _mm_set1_epi32(coeffs[j]);
+            __m128i x = _mm_loadu_si128((const __m128i *)(d - j - 1));
+            even = _mm_add_epi64(even, _mm_mul_epi32(c, x));
+            odd  = _mm_add_epi64(odd,
+                                 _mm_mul_epi32(c, _mm_srli_epi64(x, 32)));
+        }
+        _mm_store_si128((__m128i *)acc,     _mm_unpacklo_epi64(even, odd));
+        _mm_store_si128((__m128i *)acc + 1, _mm_unpackhi_epi64(even, odd));
+
+        for (j = 0; j < 4; j++)
+        {
+            int32_t y = d[j] +
+                ((acc[j] + c0*x1 + c1*x2 + c2*x3 + c3*x4) >> qlevel);
+            d[j] = y;
+            x4 = x3; x3 = x2; x2 = x1; x1 = y;
+        }
+    }
+
+    for (; i < len; i++)
+    {
+        int64_t sum = 0;
+        for (j = 0; j < pred_order; j++)
+            sum += (int64_t)coeffs[j] * decoded[i-j-1];
+        decoded[i] += sum >> qlevel;
+    }
+}
+
+#endif
@@ -1922,6 +1922,157 @@ static void ICODE_ATTR window_subband1_m(const short *wk, int a0[32])
     }
 }
 
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+/* The 15 rows of the window are computed 8 at a time with pmaddwd, using a
+ * transposed copy of the taps. Each row reads its x1 taps one sample further
+ * back than the row before, so those are loaded from a time-reversed copy
+ * of the granule's input instead. Results are identical to the generic C. */
+
+/* Mono samples from 286 before the granule's first subband sample to
+ * 224 after its last, padded to a whole vector */
+#define WSB_SPAN 1056
+
+static short wsb_fwd[2][WSB_SPAN] MEM_ALIGN_ATTR;
+static short wsb_rev[WSB_SPAN] MEM_ALIGN_ATTR;
+/* enwindow taps 0-15 as (2n, 2n+1) pairs for rows 0-15; row 15 is zero */
+static short wsb_coef[8][16][2] MEM_ALIGN_ATTR;
+static bool  wsb_coef_ready = false;
+
+static void window_subband1_init(void)
+{
+    for (int n = 0; n < 8; n++)
+    {
+        for (int r = 0; r < 15; r++)
+        {
+            wsb_coef[n][r][0] = enwindow[r*20 + 2*n];
+            wsb_coef[n][r][1] = enwindow[r*20 + 2*n + 1];
+        }
+    }
+
+    wsb_coef_ready = true;
+}
+
+/* Accumulate taps 2n and 2n+1 of rows h..h+7 */
+#define WSB_MAC(lo, hi, x, o0, o1, n)                                      \
+    ({ __m128i _a = _mm_loadu_si128((const __m128i *)((x) + (o0)));        \
+       __m128i _b = _mm_loadu_si128((const __m128i *)((x) + (o1)));        \
+       const __m128i *_w = (const __m128i *)wsb_coef[n][h];                \
+       lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(_a, _b),   \
+                                             _w[0]));                      \
+       hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(_a, _b),   \
+                                             _w[1])); })
+
+/* wf: mono input at the start of the span, wr: the span reversed */
+static void ICODE_ATTR window_subband1_sse2(const short *wf, const short *wr,
+                                            int a[32])
+{
+    if (UNLIKELY(!wsb_coef_ready))
+        window_subband1_init();
+
+    for (int k = 0; k < 18; k++, a += 32)
+    {
+        const int p = 286 + 32*k;
+        int s[16] __attribute__((aligned(16)));
+        int t[16] __attribute__((aligned(16)));
+
+        for (int h = 0; h < 16; h += 8)
+        {
+            /* x2[o] and x1[-o] as seen from row h */
+            const short *x2 = wf + p - 62 + h;
+            const short *x1 = wr + WSB_SPAN - 1 - p + h;
+            __m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+            __m128i t0 = _mm_setzero_si128(), t1 = _mm_setzero_si128();
+            __m128i u0 = _mm_setzero_si128(), u1 = _mm_setzero_si128();
+
+            WSB_MAC(s0, s1, x2, -224, -160, 0);
+            WSB_MAC(s0, s1, x2, - 96, - 32, 1);
+            WSB_MAC(s0, s1, x2,   32,   96, 2);
+            WSB_MAC(s0, s1, x2,  160,  224, 3);
+            WSB_MAC(s0, s1, x1,  256,  192, 4);
+            WSB_MAC(s0, s1, x1,  128,   64, 5);
+            WSB_MAC(s0, s1, x1,    0, - 64, 6);
+            WSB_MAC(s0, s1, x1, -128, -192, 7);
+
+            WSB_MAC(t0, t1, x1, -224, -160, 0);
+            WSB_MAC(t0, t1, x1, - 96, - 32, 1);
+            WSB_MAC(t0, t1, x1,   32,   96, 2);
+            WSB_MAC(t0, t1, x1,  160,  224, 3);
+            WSB_MAC(u0, u1, x2,  256,  192, 4);
+            WSB_MAC(u0, u1, x2,  128,   64, 5);
+            WSB_MAC(u0, u1, x2,    0, - 64, 6);
+            WSB_MAC(u0, u1, x2, -128, -192, 7);
+
+            _mm_store_si128((__m128i *)&s[h    ], s0);
+            _mm_store_si128((__m128i *)&s[h + 4], s1);
+            _mm_store_si128((__m128i *)&t[h    ], _mm_sub_epi32(t0, u0));
+            _mm_store_si128((__m128i *)&t[h + 4], _mm_sub_epi32(t1, u1));
+        }
+
+        const short *wp = enwindow;
+
+        for (int r = 0; r < 15; r++, wp += 20)
+        {
+            a[2*r    ] =  shft4(t[r])          + shft13(s[r]) * wp[16];
+            a[2*r + 1] = shft13(t[r]) * wp[17] - shft13(s[r]) * wp[18];
+        }
+
+        const short *x1 = wf + p - 15;
+        int ts, ss;
+
+        ts  =  (int)x1[- 16]            * wp[ 8];  ss  = (int)x1[ -32] * wp[0];
+        ts += ((int)x1[- 48] - x1[ 16]) * wp[ 9];  ss += (int)x1[ -96] * wp[1];
+        ts += ((int)x1[- 80] + x1[ 48]) * wp[10];  ss += (int)x1[-160] * wp[2];
+        ts += ((int)x1[-112] - x1[ 80]) * wp[11];  ss += (int)x1[-224] * wp[3];
+        ts += ((int)x1[-144] + x1[112]) * wp[12];  ss += (int)x1[  32] * wp[4];
+        ts += ((int)x1[-176] - x1[144]) * wp[13];  ss += (int)x1[  96] * wp[5];
+        ts += ((int)x1[-208] + x1[176]) * wp[14];  ss += (int)x1[ 160] * wp[6];
+        ts += ((int)x1[-240] - x1[208]) * wp[15];  ss += (int)x1[ 224] * wp[7];
+
+        int u = shft4(ss - ts);
+        int v = shft4(ss + ts);
+        ts = a[14];
+        ss = a[15] - ts;
+
+        a[31] = v + ts;  /* A0 */
+        a[30] = u + ss;  /* A1 */
+        a[15] = u - ss;  /* A2 */
+        a[14] = v - ts;  /* A3 */
+    }
+}
+
+static void window_subband1_s(const short *wk, int a0[32], int a1[32])
+{
+    const short *x = wk - 2*286;
+
+    for (int i = 0; i < WSB_SPAN; i++, x += 2)
+    {
+        wsb_fwd[0][i] = x[0];
+        wsb_fwd[1][i] = x[1];
+    }
+
+    for (int i = 0; i < WSB_SPAN; i++)
+        wsb_rev[i] = wsb_fwd[0][WSB_SPAN - 1 - i];
+
+    window_subband1_sse2(wsb_fwd[0], wsb_rev, a0);
+
+    for (int i = 0; i < WSB_SPAN; i++)
+        wsb_rev[i] = wsb_fwd[1][WSB_SPAN - 1 - i];
+
+    window_subband1_sse2(wsb_fwd[1], wsb_rev, a1);
+}
+
+static void window_subband1_m(const short *wk, int a[32])
+{
+    const short *x = wk - 286;
+
+    for (int i = 0; i < WSB_SPAN; i++)
+        wsb_rev[i] = x[WSB_SPAN - 1 - i];
+
+    window_subband1_sse2(x, wsb_rev, a);
+}
+
 #else /* Generic CPU */
 
 static void ICODE_ATTR window_subband1_s_(const short *wk, int a[32])
@@ -2398,6 +2549,72 @@ static inline void get_sb_data(int gr)
 #endif /* MP3_ENC_COP */
 }
 
+/* Split the MDCT output into sign and rounded magnitude, returning the
+ * largest magnitude */
+#ifdef __SSE2__
+static uint32_t mdct_sign_magnitude(int *freq, char *sign)
+{
+    const __m128i bias = _mm_set1_epi32(0x80000000);
+    const __m128i rnd  = _mm_set1_epi32(4096);
+    __m128i max = bias; /* 0 in the biased domain */
+
+    for (int k = 0; k < 576; k += 16)
+    {
+        __m128i m[4];
+
+        for (int j = 0; j < 4; j++)
+        {
+            __m128i *p = (__m128i *)&freq[k + 4*j];
+            __m128i x = _mm_loadu_si128(p);
+            m[j] = _mm_srai_epi32(x, 31);
+            x = _mm_sub_epi32(_mm_xor_si128(x, m[j]), m[j]);
+            x = _mm_srai_epi32(_mm_add_epi32(x, rnd), 13);
+            _mm_storeu_si128(p, x);
+
+            /* Unsigned max by way of a signed compare on biased values */
+            x = _mm_xor_si128(x, bias);
+            __m128i gt = _mm_cmpgt_epi32(x, max);
+            max = _mm_or_si128(_mm_and_si128(gt, x),
+                               _mm_andnot_si128(gt, max));
+        }
+
+        __m128i s = _mm_packs_epi16(_mm_packs_epi32(m[0], m[1]),
+                                    _mm_packs_epi32(m[2], m[3]));
+        _mm_storeu_si128((__m128i *)&sign[k],
+                         _mm_and_si128(s, _mm_set1_epi8(1)));
+    }
+
+    uint32_t lanes[4] __attribute__((aligned(16)));
+    _mm_store_si128((__m128i *)lanes, _mm_xor_si128(max, bias));
+
+    return MAX(MAX(lanes[0], lanes[1]), MAX(lanes[2], lanes[3]));
+}
+#else /* !__SSE2__ */
+static uint32_t mdct_sign_magnitude(int *freq, char *sign)
+{
+    uint32_t max = 0;
+
+    for (int k = 0; k < 576; k++)
+    {
+        if (freq[k] < 0)
+        {
+            sign[k] = 1; /* negative */
+            freq[k] = shft13(-freq[k]);
+        }
+        else
+        {
+            sign[k] = 0; /* positive */
+            freq[k] = shft13(freq[k]);
+        }
+
+        if (max < (uint32_t)freq[k])
+            max = (uint32_t)freq[k];
+    }
+
+    return max;
+}
+#endif /* __SSE2__ */
+
 /* Encode one mp3 frame */
 static void ICODE_ATTR compress_frame(void)
 {
@@ -2481,24 +2698,7 @@ static void ICODE_ATTR compress_frame(void)
                     }
                 }
 
-                uint32_t max = 0;
-
-                for (int k = 0; k < 576; k++)
-                {
-                    if (mdct_freq[k] < 0)
-                    {
-                        mdct_sign[k] = 1; /* negative */
-                        mdct_freq[k] = shft13(-mdct_freq[k]);
-                    }
-                    else
-                    {
-                        mdct_sign[k] = 0; /* positive */
-                        mdct_freq[k] = shft13(mdct_freq[k]);
-                    }
-
-                    if (max < (uint32_t)mdct_freq[k])
-                        max = (uint32_t)mdct_freq[k];
-                }
+                uint32_t max = mdct_sign_magnitude(mdct_freq, mdct_sign);
 
                 cfg.cod_info[gr][ch].max_val = max;
 
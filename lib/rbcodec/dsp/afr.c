@@ -30,6 +30,10 @@
 
 static int afr_strength = 0;
 static struct dsp_filter afr_filters[4];
+static struct dsp_filter * const afr_chain[4] =
+{
+    &afr_filters[0], &afr_filters[1], &afr_filters[2], &afr_filters[3],
+};
 
 static void dsp_afr_flush(void)
 {
@@ -97,9 +101,8 @@ static void afr_reduce_process(struct dsp_proc_entry *this,
 {
     struct dsp_buffer *buf = *buf_p;
 
-    for (int i = 0; i < 4; i++)
-        filter_process(&afr_filters[i], buf->p32, buf->remcount,
-                       buf->format.num_channels);
+    filter_cascade_process(afr_chain, 4, buf->p32, buf->remcount,
+                           buf->format.num_channels);
 
     (void)this;
 }
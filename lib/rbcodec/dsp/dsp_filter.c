@@ -304,6 +304,190 @@ void filter_process(struct dsp_filter *f, int32_t * const buf[], int count,
 }
 #endif /* CPU */
 
+/**
+ * Run a chain of filters over the buffer. Where the per-filter loop lives in
+ * assembly it already keeps a whole filter in registers, so just call it for
+ * each one; elsewhere each sample is carried through every filter before the
+ * next is loaded, so the buffer is read and written only once however many
+ * filters there are. Results are identical to filter_process() on each in
+ * turn.
+ */
+#if defined(CPU_COLDFIRE) || defined(CPU_ARM)
+void filter_cascade_process(struct dsp_filter * const f[], int nfilters,
+                            int32_t * const buf[], int count,
+                            unsigned int channels)
+{
+    for (int k = 0; k < nfilters; k++)
+        filter_process(f[k], buf, count, channels);
+}
+#else /* !CPU_COLDFIRE && !CPU_ARM */
+/* Filters run per pass, bounding the stack used for the local state */
+#define FILTER_CASCADE_GROUP 8
+
+static inline __attribute__((always_inline))
+void filter_cascade_body(struct dsp_filter * const f[], int nfilters,
+                         int32_t *buf, int count, unsigned int ch)
+{
+    int32_t coefs[FILTER_CASCADE_GROUP][5];
+    int32_t hist[FILTER_CASCADE_GROUP][4];
+    unsigned int shift[FILTER_CASCADE_GROUP];
+
+    for (int k = 0; k < nfilters; k++)
+    {
+        memcpy(coefs[k], f[k]->coefs, sizeof (coefs[k]));
+        memcpy(hist[k], f[k]->history[ch], sizeof (hist[k]));
+        shift[k] = f[k]->shift;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        int32_t x = buf[i];
+
+        for (int k = 0; k < nfilters; k++)
+        {
+            const int32_t *c = coefs[k];
+            int32_t *h = hist[k];
+            long long acc = (long long) x * c[0];
+            acc += (long long) h[0] * c[1];
+            acc += (long long) h[1] * c[2];
+            acc += (long long) h[3] * c[4];
+            acc += (long long) h[2] * c[3];
+            h[1] = h[0];
+            h[0] = x;
+            h[3] = h[2];
+            x = (acc << shift[k]) >> 32;
+            h[2] = x;
+        }
+
+        buf[i] = x;
+    }
+
+    for (int k = 0; k < nfilters; k++)
+        memcpy(f[k]->history[ch], hist[k], sizeof (hist[k]));
+}
+
+/* A lone filter gets its own copy so its state stays in registers */
+static void filter_cascade_c(struct dsp_filter * const f[], int nfilters,
+                             int32_t *buf, int count, unsigned int ch)
+{
+    if (nfilters == 1)
+        filter_cascade_body(f, 1, buf, count, ch);
+    else
+        filter_cascade_body(f, nfilters, buf, count, ch);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* Both channels of a stereo pair at once: left in the low dword of the low
+   quadword, right in the low dword of the high quadword, so one signed
+   32x32->64 multiply covers a coefficient for both. Taking the low dword of
+   acc >> (32 - shift) gives the same bits as (acc << shift) >> 32. The
+   y[i - 1] term is added last as it is the only one waiting on the previous
+   output of the same filter. */
+static inline __attribute__((always_inline, target("sse4.1")))
+void filter_cascade_stereo_body(struct dsp_filter * const f[], int nfilters,
+                                int32_t *l, int32_t *r, int count)
+{
+    __m128i coefs[FILTER_CASCADE_GROUP][5];
+    __m128i hist[FILTER_CASCADE_GROUP][4];
+    __m128i shift[FILTER_CASCADE_GROUP];
+
+    for (int k = 0; k < nfilters; k++)
+    {
+        for (int j = 0; j < 5; j++)
+            coefs[k][j] = _mm_set1_epi32(f[k]->coefs[j]);
+
+        for (int j = 0; j < 4; j++)
+            hist[k][j] = _mm_set_epi32(0, f[k]->history[1][j],
+                                       0, f[k]->history[0][j]);
+
+        shift[k] = _mm_cvtsi32_si128(32 - f[k]->shift);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        __m128i x = _mm_insert_epi32(_mm_cvtsi32_si128(l[i]), r[i], 2);
+
+        for (int k = 0; k < nfilters; k++)
+        {
+            const __m128i *c = coefs[k];
+            __m128i *h = hist[k];
+            __m128i acc = _mm_add_epi64(_mm_mul_epi32(x, c[0]),
+                                        _mm_mul_epi32(h[0], c[1]));
+            acc = _mm_add_epi64(acc,
+                    _mm_add_epi64(_mm_mul_epi32(h[1], c[2]),
+                                  _mm_mul_epi32(h[3], c[4])));
+            acc = _mm_add_epi64(acc, _mm_mul_epi32(h[2], c[3]));
+            h[1] = h[0];
+            h[0] = x;
+            h[3] = h[2];
+            x = _mm_srl_epi64(acc, shift[k]);
+            h[2] = x;
+        }
+
+        l[i] = _mm_cvtsi128_si32(x);
+        r[i] = _mm_extract_epi32(x, 2);
+    }
+
+    for (int k = 0; k < nfilters; k++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            f[k]->history[0][j] = _mm_cvtsi128_si32(hist[k][j]);
+            f[k]->history[1][j] = _mm_extract_epi32(hist[k][j], 2);
+        }
+    }
+}
+
+/* A lone filter gets its own copy so its state stays in registers */
+__attribute__((target("sse4.1")))
+static void filter_cascade_stereo_sse41(struct dsp_filter * const f[],
+                                        int nfilters, int32_t *l,
+                                        int32_t *r, int count)
+{
+    if (nfilters == 1)
+        filter_cascade_stereo_body(f, 1, l, r, count);
+    else
+        filter_cascade_stereo_body(f, nfilters, l, r, count);
+}
+
+static bool filter_have_sse41(void)
+{
+    static int have = -1;
+
+    if (have < 0)
+    {
+        __builtin_cpu_init();
+        have = __builtin_cpu_supports("sse4.1") ? 1 : 0;
+    }
+
+    return have;
+}
+#endif /* x86 */
+
+void filter_cascade_process(struct dsp_filter * const f[], int nfilters,
+                            int32_t * const buf[], int count,
+                            unsigned int channels)
+{
+    for (; nfilters > 0; f += FILTER_CASCADE_GROUP,
+                         nfilters -= FILTER_CASCADE_GROUP)
+    {
+        int n = MIN(nfilters, FILTER_CASCADE_GROUP);
+
+#if defined(__x86_64__) || defined(__i386__)
+        if (channels == 2 && filter_have_sse41())
+        {
+            filter_cascade_stereo_sse41(f, n, buf[0], buf[1], count);
+            continue;
+        }
+#endif
+        for (unsigned int c = 0; c < channels; c++)
+            filter_cascade_c(f, n, buf[c], count, c);
+    }
+}
+#endif /* CPU */
+
 /* ring buffer */
 int32_t dequeue(int32_t* buffer, int *head, int boundary)
 {
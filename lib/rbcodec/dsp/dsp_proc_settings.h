@@ -28,6 +28,7 @@
 #include "dsp_misc.h"
 #include "eq.h"
 #include "pga.h"
+#include "resample.h"
 #include "surround.h"
 #include "afr.h"
 #include "pbe.h"
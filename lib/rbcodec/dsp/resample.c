@@ -32,6 +32,10 @@
 /**
  * Linear interpolation resampling that introduces a one sample delay because
  * of our inability to look into the future at the end of a frame.
+ *
+ * Optionally, the audio DSP uses a polyphase windowed-sinc FIR instead. That
+ * delays by half the tap count and costs one multiply-accumulate per tap per
+ * output sample.
  */
 
 #if 1 /* Set to '0' to enable debug messages */
@@ -41,6 +45,17 @@
 
 #define RESAMPLE_BUF_COUNT 192 /* Per channel, per DSP */
 
+/* Polyphase FIR limits. A rate pair whose reduced ratio fits the bank gets
+ * one row per exact output phase (44.1k->48k: 160 rows); others round the
+ * phase to the nearest of a power-of-two number of rows. */
+#define RESAMPLE_FIR_MAX_TAPS 64
+#define RESAMPLE_FIR_MAX_ROWS 512
+#if !defined(MEMORYSIZE) || MEMORYSIZE > 8
+#define RESAMPLE_FIR_BANK_SIZE 10240 /* Coefficients */
+#else
+#define RESAMPLE_FIR_BANK_SIZE 4096
+#endif
+
 /* CODEC_IDX_AUDIO = left and right, CODEC_IDX_VOICE = mono */
 static int32_t resample_out_bufs[3][RESAMPLE_BUF_COUNT] IBSS_ATTR;
 
@@ -56,16 +71,43 @@ static struct resample_data
     unsigned int frequency_out;     /* Resampler output samplerate */
     struct dsp_buffer resample_buf; /* Buffer descriptor for resampled data */
     int32_t *resample_out_p[2];     /* Actual output buffer pointers */
+    int quality;                    /* RESAMPLE_QUALITY_* */
+    struct resample_fir *fir;       /* Polyphase filter in use or NULL */
 } resample_data[DSP_COUNT] IBSS_ATTR;
 
+/* Polyphase filter state; only the audio DSP uses one */
+static struct resample_fir
+{
+    int taps;               /* Taps per phase (0 = no bank designed) */
+    unsigned int fin;       /* Rates the bank was designed for */
+    unsigned int fout;
+    uint32_t den;           /* Phase accumulator modulus */
+    uint32_t step_int;      /* Input step per output (step_int+step_frac/den) */
+    uint32_t step_frac;
+    unsigned int row_shift; /* Phase accumulator to bank row */
+    uint32_t phase;         /* Current phase, 0..den-1 */
+    uint32_t pos;           /* Input position carried into the next buffer */
+    int32_t history[2][RESAMPLE_FIR_MAX_TAPS-1]; /* Last samples, oldest 1st */
+    int16_t bank[RESAMPLE_FIR_BANK_SIZE] __attribute__((aligned(32)));
+} resample_fir;
+
 /* Actual worker function. Implemented here or in target assembly code. */
 int resample_hermite(struct resample_data *data, struct dsp_buffer *src,
                      struct dsp_buffer *dst);
 
+static void resample_fir_setup(struct resample_data *data);
+
 static void resample_flush_data(struct resample_data *data)
 {
     data->phase = 0;
     memset(&data->history, 0, sizeof (data->history));
+
+    if (data->fir)
+    {
+        data->fir->phase = 0;
+        data->fir->pos = 0;
+        memset(data->fir->history, 0, sizeof (data->fir->history));
+    }
 }
 
 static void resample_flush(struct dsp_proc_entry *this)
@@ -91,9 +133,11 @@ static bool resample_new_delta(struct resample_data *data,
            resampling are desired, history should be maintained even when
            not resampling. */
         resample_flush_data(data);
+        data->fir = NULL;
         return false;
     }
 
+    resample_fir_setup(data);
     return true;
 }
 
@@ -189,6 +233,346 @@ int resample_hermite(struct resample_data *data, struct dsp_buffer *src,
 }
 #endif /* CPU */
 
+/** Polyphase windowed-sinc FIR **/
+
+/* Dot product of one bank row with the newest 'taps' samples, Q15 coefs */
+#if defined(CPU_ARM) && ARM_ARCH >= 6
+static int32_t fir_dot(const int32_t *x, const int16_t *c, int taps)
+{
+    /* 32x16 multiplies keep the top 32 bits of each product; the dropped
+       low bits are far below the DSP's fractional resolution */
+    int32_t acc = 0;
+
+    asm volatile (
+        "1:                                     \n"
+        "ldmia  %[x]!, { r0-r3 }                \n"
+        "ldmia  %[c]!, { r4-r5 }                \n"
+        "smlawb %[acc], r0, r4, %[acc]          \n"
+        "smlawt %[acc], r1, r4, %[acc]          \n"
+        "smlawb %[acc], r2, r5, %[acc]          \n"
+        "smlawt %[acc], r3, r5, %[acc]          \n"
+        "subs   %[n], %[n], #4                  \n"
+        "bgt    1b                              \n"
+        : [acc]"+r"(acc), [x]"+r"(x), [c]"+r"(c), [n]"+r"(taps)
+        :
+        : "r0", "r1", "r2", "r3", "r4", "r5", "cc", "memory");
+
+    return acc << 1;
+}
+
+#define fir_dot_select() do {} while (0)
+#else /* !ARMv6 */
+static int32_t fir_dot_c(const int32_t *x, const int16_t *c, int taps)
+{
+    int64_t acc = 1 << 14;
+
+    for (int i = 0; i < taps; i++)
+        acc += (int64_t)x[i] * c[i];
+
+    return acc >> 15;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* Low quadword of a sum, rounded as fir_dot_c; also works on 32-bit x86 */
+static inline int32_t fir_dot_round(__m128i acc)
+{
+    int64_t sum;
+    _mm_storel_epi64((__m128i *)&sum, acc);
+    return (sum + (1 << 14)) >> 15;
+}
+
+/* Full 64-bit products and sums, identical to fir_dot_c */
+__attribute__((target("sse4.1")))
+static int32_t fir_dot_sse41(const int32_t *x, const int16_t *c, int taps)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    for (int i = 0; i < taps; i += 4)
+    {
+        __m128i xv = _mm_loadu_si128((const __m128i *)&x[i]);
+        __m128i cv = _mm_cvtepi16_epi32(
+                        _mm_loadl_epi64((const __m128i *)&c[i]));
+        acc = _mm_add_epi64(acc, _mm_mul_epi32(xv, cv));
+        acc = _mm_add_epi64(acc, _mm_mul_epi32(_mm_srli_epi64(xv, 32),
+                                               _mm_srli_epi64(cv, 32)));
+    }
+
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi64(acc, acc));
+    return fir_dot_round(acc);
+}
+
+__attribute__((target("avx2")))
+static int32_t fir_dot_avx2(const int32_t *x, const int16_t *c, int taps)
+{
+    __m256i acc = _mm256_setzero_si256();
+
+    for (int i = 0; i < taps; i += 8)
+    {
+        __m256i xv = _mm256_loadu_si256((const __m256i *)&x[i]);
+        __m256i cv = _mm256_cvtepi16_epi32(
+                        _mm_load_si128((const __m128i *)&c[i]));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(xv, cv));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(_mm256_srli_epi64(xv, 32),
+                                                     _mm256_srli_epi64(cv, 32)));
+    }
+
+    __m128i a = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                              _mm256_extracti128_si256(acc, 1));
+    a = _mm_add_epi64(a, _mm_unpackhi_epi64(a, a));
+    return fir_dot_round(a);
+}
+
+static int32_t (*fir_dot)(const int32_t *, const int16_t *, int) = fir_dot_c;
+
+static void fir_dot_select(void)
+{
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        fir_dot = fir_dot_avx2;
+    else if (__builtin_cpu_supports("sse4.1"))
+        fir_dot = fir_dot_sse41;
+}
+#else
+#define fir_dot fir_dot_c
+#define fir_dot_select() do {} while (0)
+#endif /* x86 */
+#endif /* CPU */
+
+/* Blackman-Harris window terms and pi, s1.30 and s2.29 */
+#define BH_A0   385204879
+#define BH_A1   524297395
+#define BH_A2   151698245
+#define BH_A3    12541305
+#define PI_Q29 1686629713
+
+/* Windowed-sinc coefficient at time A/D from the output point, Q31 before
+   normalization. fcq is the cutoff as a fraction of the input rate, Q32. */
+static int32_t fir_design_tap(int32_t a, uint32_t d, uint32_t fcq, int taps)
+{
+    int64_t h;
+
+    if (a == 0)
+    {
+        h = fcq; /* 2*fc */
+    }
+    else
+    {
+        long sine = fp_sincos((uint32_t)((int64_t)fcq * a / (int64_t)d),
+                              NULL);
+        h = ((int64_t)sine << 29) / PI_Q29 * d / a;
+    }
+
+    /* Window spans the taps, centered on the output point */
+    uint32_t ph = ((uint64_t)(a + taps/2*(int32_t)d) << 32) / (taps*d);
+    long c1, c2, c3;
+    fp_sincos(ph, &c1);
+    fp_sincos(2*ph, &c2);
+    fp_sincos(3*ph, &c3);
+
+    int64_t w = BH_A0 - (((int64_t)BH_A1 * c1) >> 31)
+                      + (((int64_t)BH_A2 * c2) >> 31)
+                      - (((int64_t)BH_A3 * c3) >> 31);
+
+    return (h * w) >> 30;
+}
+
+/* Set up stepping for the rate pair and redesign the bank if needed */
+static void resample_fir_design(struct resample_fir *f, unsigned int fin,
+                                unsigned int fout, uint32_t delta, int taps)
+{
+    static unsigned int rows, d, fcq; /* Bank currently designed */
+
+    unsigned int a = fin, b = fout;
+    while (b)
+    {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+
+    unsigned int l = fout / a, m = fin / a;
+    unsigned int nrows, nd;
+
+    if (l <= RESAMPLE_FIR_MAX_ROWS && l*taps <= RESAMPLE_FIR_BANK_SIZE)
+    {
+        /* Exact: row r is phase r/l */
+        nrows = l;
+        nd = l;
+        f->den = l;
+        f->step_int = m / l;
+        f->step_frac = m % l;
+        f->row_shift = 0;
+    }
+    else
+    {
+        /* Nearest: row r is phase (2r+1)/2nrows, from the 16.16 delta */
+        nrows = RESAMPLE_FIR_MAX_ROWS;
+        while (nrows*taps > RESAMPLE_FIR_BANK_SIZE)
+            nrows /= 2;
+
+        nd = 2*nrows;
+        f->den = 0x10000;
+        f->step_int = delta >> 16;
+        f->step_frac = delta & 0xffff;
+        f->row_shift = 16;
+        for (unsigned int r = nrows; r > 1; r >>= 1)
+            f->row_shift--;
+    }
+
+    f->fin = fin;
+    f->fout = fout;
+
+    /* Cut off below the lower Nyquist by about half the window's transition
+       band. The band is 8/taps of the input rate wide, so 16 taps roll off
+       early: -3 dB at about 14.9 kHz for 44.1 kHz music, 18.5 kHz with 32
+       taps and 20.3 kHz with 64 */
+    unsigned int nfcq = (fout < fin ? ((uint64_t)fout << 31) / fin : 1u << 31)
+                            - (1ull << 33) / taps;
+
+    if (taps == f->taps && nrows == rows && nd == d && nfcq == fcq)
+        return; /* Same bank */
+
+    DEBUGF("  DSP_PROC_RESAMPLE- designing %d taps x %u rows\n", taps, nrows);
+
+    int16_t *c = f->bank;
+
+    for (unsigned int r = 0; r < nrows; r++, c += taps)
+    {
+        int32_t coef[RESAMPLE_FIR_MAX_TAPS];
+        int32_t num = nd == nrows ? (int32_t)r : (int32_t)(2*r + 1);
+        int64_t sum = 0;
+
+        for (int j = 0; j < taps; j++)
+        {
+            coef[j] = fir_design_tap((taps/2 - 1 - j)*(int32_t)nd + num, nd,
+                                     nfcq, taps);
+            sum += coef[j];
+        }
+
+        /* Normalize each phase to unity gain at DC. Taps are truncated from
+           Q31 and the ones with the largest remainders get rounded up until
+           the row sums to exactly 1.0, so no tap is off by more than 1 LSB */
+        int32_t sum15 = 0;
+
+        for (int j = 0; j < taps; j++)
+        {
+            int64_t v = ((int64_t)coef[j] << 31) / sum;
+            int32_t q = v >> 16;
+            c[j] = MIN(MAX(q, INT16_MIN), INT16_MAX);
+            coef[j] = c[j] == q ? (int32_t)(v & 0xffff) : -1; /* Remainder */
+            sum15 += c[j];
+        }
+
+        for (; sum15 < 32768; sum15++)
+        {
+            int k = 0;
+
+            for (int j = 1; j < taps; j++)
+            {
+                if (coef[j] > coef[k])
+                    k = j;
+            }
+
+            if (coef[k] < 0)
+                break; /* Everything left is clipped */
+
+            c[k]++;
+            coef[k] = -1;
+        }
+    }
+
+    f->taps = taps;
+    rows = nrows;
+    d = nd;
+    fcq = nfcq;
+}
+
+/* Choose the interpolator for the current rates and quality */
+static void resample_fir_setup(struct resample_data *data)
+{
+    struct resample_fir *fir = NULL;
+
+    if (data->quality > RESAMPLE_QUALITY_CUBIC &&
+        data == &resample_data[CODEC_IDX_AUDIO])
+    {
+        int taps = 8 << data->quality;
+        fir = &resample_fir;
+
+        if (data->fir != fir || fir->taps != taps)
+            memset(fir->history, 0, sizeof (fir->history));
+
+        resample_fir_design(fir, data->frequency, data->frequency_out,
+                            data->delta, taps);
+        fir->phase = 0;
+        fir->pos = 0;
+    }
+
+    data->fir = fir;
+}
+
+static int resample_fir_process(struct resample_fir *f,
+                                struct dsp_buffer *src,
+                                struct dsp_buffer *dst)
+{
+    int ch = src->format.num_channels - 1;
+    uint32_t count = MIN(src->remcount, 0x8000);
+    const int taps = f->taps;
+    const uint32_t hist = taps - 1;
+    uint32_t phase, pos;
+    int32_t *d;
+
+    do
+    {
+        const int32_t *s = src->p32[ch];
+        int32_t *h = f->history[ch];
+
+        /* Windows reaching back before s[0] read from history + head */
+        int32_t stage[2*RESAMPLE_FIR_MAX_TAPS-2];
+        uint32_t head = MIN(count, hist);
+        memcpy(stage, h, hist*sizeof (int32_t));
+        memcpy(stage + hist, s, head*sizeof (int32_t));
+
+        d = dst->p32[ch];
+        int32_t *dmax = d + dst->bufcount;
+
+        /* Restore state */
+        phase = f->phase;
+        pos = f->pos;
+
+        while (pos < count && d < dmax)
+        {
+            const int32_t *x = pos < hist ? stage + pos : s + pos - hist;
+
+            *d++ = fir_dot(x, f->bank + (phase >> f->row_shift)*taps, taps);
+
+            pos += f->step_int;
+            phase += f->step_frac;
+
+            if (phase >= f->den)
+            {
+                phase -= f->den;
+                pos++;
+            }
+        }
+
+        /* Keep the samples preceding the next start */
+        uint32_t n = MIN(pos, count);
+
+        for (uint32_t i = 0; i < hist; i++)
+            h[i] = n + i < hist ? stage[n + i] : s[n + i - hist];
+    }
+    while (--ch >= 0);
+
+    f->phase = phase;
+    f->pos = pos - MIN(pos, count);
+
+    dst->remcount = d - dst->p32[0];
+    return MIN(pos, count);
+}
+
 /* Resample count stereo samples or stop when the destination is full.
  * Updates the src buffer and changes to its own output buffer to refer to
  * the resampled data. */
@@ -212,7 +596,9 @@ static void resample_process(struct dsp_proc_entry *this,
     {
         dst->bufcount = RESAMPLE_BUF_COUNT;
 
-        int consumed = resample_hermite(data, src, dst);
+        int consumed = data->fir ?
+            resample_fir_process(data->fir, src, dst) :
+            resample_hermite(data, src, dst);
 
         /* Advance src by consumed amount */
         if (consumed > 0)
@@ -289,6 +675,19 @@ void dsp_resample_init(struct dsp_config *dsp, unsigned int dsp_id)
     dsp_proc_enable(dsp, DSP_PROC_RESAMPLE, true);
     resample_data[dsp_id].resample_out_p[0] = lbuf;
     resample_data[dsp_id].resample_out_p[1] = rbuf;
+
+    if (dsp_id == CODEC_IDX_AUDIO)
+        fir_dot_select();
+}
+
+/* Set the interpolator used by the audio DSP */
+void dsp_set_resample_quality(int quality)
+{
+    if (quality < RESAMPLE_QUALITY_CUBIC || quality >= RESAMPLE_QUALITY_NUM)
+        quality = RESAMPLE_QUALITY_CUBIC;
+
+    struct dsp_config *dsp = dsp_get_config(CODEC_IDX_AUDIO);
+    dsp_configure(dsp, RESAMPLE_SET_QUALITY, quality);
 }
 
 static void resample_proc_init(struct dsp_proc_entry *this,
@@ -331,6 +730,18 @@ static intptr_t resample_configure(struct dsp_proc_entry *this,
     case DSP_SET_OUT_FREQUENCY:
         dsp_proc_want_format_update(dsp, DSP_PROC_RESAMPLE);
         break;
+
+    case RESAMPLE_SET_QUALITY:
+        {
+        struct resample_data *data = (void *)this->data;
+        if (data->quality == (int)value)
+            break;
+
+        data->quality = value;
+        data->frequency = 0; /* Force a new setup */
+        dsp_proc_want_format_update(dsp, DSP_PROC_RESAMPLE);
+        break;
+        }
     }
 
     return retval;
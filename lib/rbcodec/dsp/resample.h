@@ -21,6 +21,20 @@
 #ifndef _DSP_RESAMPLE_H
 #define _DSP_RESAMPLE_H
 
+/* Interpolator used when the input and output rates differ; value for
+ * RESAMPLE_SET_QUALITY */
+enum resample_quality
+{
+    RESAMPLE_QUALITY_CUBIC = 0, /* 4-point Hermite spline (default) */
+    RESAMPLE_QUALITY_SINC_16,   /* Polyphase windowed sinc, 16 taps */
+    RESAMPLE_QUALITY_SINC_32,   /* ..., 32 taps */
+    RESAMPLE_QUALITY_SINC_64,   /* ..., 64 taps */
+    RESAMPLE_QUALITY_NUM
+};
+
+#define RESAMPLE_SET_QUALITY (DSP_PROC_SETTING+DSP_PROC_RESAMPLE)
+
+void dsp_set_resample_quality(int quality);
 void dsp_resample_init(struct dsp_config *dsp, unsigned int dsp_id) INIT_ATTR;
 
 #endif /* _DSP_RESAMPLE_H */
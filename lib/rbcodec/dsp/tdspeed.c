@@ -42,6 +42,17 @@
 #define FIXED_BUFCOUNT      3072 /* 48KHz factor 3.0 */
 #define FIXED_OUTBUFCOUNT   4096
 
+/* Overlap search works on a 16-bit mono mix scaled to this peak, and
+   clamped to twice that, so that a 64 point dot product fits in 32 bits */
+#define CORR_PEAK_BITS        11
+#define CORR_COARSE_HZ      2756 /* Approximate rate of the coarse pass */
+#define CORR_COARSE_MAX      128 /* Largest decimated frame + search region */
+#define CORR_FINE_POINTS       8 /* Fine pass window, a multiple of 8 */
+#define CORR_SHIFT_MAX  (MAX_RATE / MINFREQ) /* Largest search region */
+#define CORR_PEAKS             2 /* Coarse matches that get refined */
+#define CORR_FINE_PEAKS        2 /* Fine matches added to them */
+#define CORR_FRAME_STEP        8 /* Final pass spacing, frame <= 64 points */
+
 enum tdspeed_ops
 {
     TDSOP_PROCESS,
@@ -58,12 +69,22 @@ static struct tdspeed_state_s
     int32_t shift_max;      /* maximum displacement on a frame */
     int32_t src_step;       /* source window pace */
     int32_t dst_step;       /* destination window pace */
-    int32_t dst_order;      /* power of two for dst_step */
+    int32_t dst_weight;     /* blend weight step, 1.0 / dst_step in s1.30 */
     int32_t ovl_shift;      /* overlap buffer frame shift */
     int32_t ovl_size;       /* overlap buffer used size */
     int32_t *ovl_buff[2];   /* overlap buffer (L+R) */
+    int32_t corr_order;     /* power of two for coarse search decimation */
 } tdspeed_state;
 
+/* Overlap search scratch: decimated frame and region for the coarse pass,
+   then for the final scores, and a few points of the frame and the whole
+   region at full rate for the fine one */
+static int16_t corr_coarse_ref[CORR_COARSE_MAX] MEM_ALIGN_ATTR;
+static int16_t corr_coarse[CORR_COARSE_MAX + 8];
+static int16_t corr_fine_ref[CORR_FINE_POINTS] MEM_ALIGN_ATTR;
+static int16_t corr_fine[CORR_FINE_POINTS + CORR_SHIFT_MAX];
+static int32_t corr_c[CORR_SHIFT_MAX], corr_e[CORR_SHIFT_MAX];
+
 static int32_t *buffers[TDSPEED_NBUFFERS] = { NULL, NULL, NULL, NULL };
 
 static const int buffer_sizes[TDSPEED_NBUFFERS] =
@@ -81,15 +102,17 @@ static const int buffer_sizes[TDSPEED_NBUFFERS] =
 /* Processed buffer passed out to later stages */
 static struct dsp_buffer dsp_outbuf;
 
-/* Blend overlapping frame samples according to position */
+/* Blend overlapping frame samples according to position; i + j is the
+   frame length and w its reciprocal in s1.30 */
 #if defined(CPU_COLDFIRE)
 static inline int32_t blend_frame_samples(int32_t curr, int32_t prev,
-                                          int i, int j, int order)
+                                          int i, int j, int32_t w)
 {
+    int32_t wi = i * w, wj = j * w;
     int32_t a0, a1;
     asm (
-        "mac.l     %2, %3, %%acc0 \n" /* acc = curr*(i<<(30-order)) >> 23 */
-        "mac.l     %4, %5, %%acc0 \n" /* acc += prev*(j<<(30-order)) >> 23 */
+        "mac.l     %2, %3, %%acc0 \n" /* acc = curr*wi >> 23 */
+        "mac.l     %4, %5, %%acc0 \n" /* acc += prev*wj >> 23 */
         "moveq.l   #1, %0         \n" /* Prepare mask */
         "move.l    %%accext01, %1 \n" /* Get extension bits */
         "lsr.l     #7, %1         \n" /* Get bit 7 of LSb extension ... */
@@ -98,20 +121,316 @@ static inline int32_t blend_frame_samples(int32_t curr, int32_t prev,
         "asl.l     #1, %0         \n" /* Everything x2 */
         "or.l      %1, %0         \n" /* Insert proper LSb from extension */
         : "=d"(a0), "=d"(a1)
-        : "r"(curr), "r"(i << order),
-          "r"(prev), "r"(j << order));
+        : "r"(curr), "r"(wi),
+          "r"(prev), "r"(wj));
 
     return a0;
 }
 #else
 /* Generic */
 static inline int32_t blend_frame_samples(int32_t curr, int32_t prev,
-                                          int i, int j, int order)
+                                          int i, int j, int32_t w)
 {
-    return (curr * (int64_t)i + prev * (int64_t)j) >> order;
+    /* |curr*i + prev*j| < 2^31 * frame length, so scaling the sum once
+       by w ~ 2^30 / frame length stays within 64 bits */
+    return ((curr * (int64_t)i + prev * (int64_t)j) * w) >> 30;
 }
 #endif /* CPU_* */
 
+/* Dot product of two 16-bit vectors; n is a positive multiple of 8 */
+#if defined(CPU_ARM) && ARM_ARCH >= 5
+static inline int32_t corr_dot(const int16_t *a, const int16_t *b, int n)
+{
+    int32_t acc = 0, a01, a23, b0, b1;
+
+    /* a is always word aligned, b may not be */
+    asm volatile (
+        "1:                                     \n"
+        "ldr    %[a01], [%[a]], #4              \n"
+        "ldr    %[a23], [%[a]], #4              \n"
+        "ldrsh  %[b0], [%[b]], #2               \n"
+        "ldrsh  %[b1], [%[b]], #2               \n"
+        "smlabb %[acc], %[a01], %[b0], %[acc]   \n"
+        "smlatb %[acc], %[a01], %[b1], %[acc]   \n"
+        "ldrsh  %[b0], [%[b]], #2               \n"
+        "ldrsh  %[b1], [%[b]], #2               \n"
+        "smlabb %[acc], %[a23], %[b0], %[acc]   \n"
+        "smlatb %[acc], %[a23], %[b1], %[acc]   \n"
+        "subs   %[n], %[n], #4                  \n"
+        "bgt    1b                              \n"
+        : [acc]"+r"(acc), [a]"+r"(a), [b]"+r"(b), [n]"+r"(n),
+          [a01]"=&r"(a01), [a23]"=&r"(a23), [b0]"=&r"(b0), [b1]"=&r"(b1)
+        :
+        : "cc", "memory");
+
+    return acc;
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+static inline int32_t corr_dot(const int16_t *a, const int16_t *b, int n)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    for (int i = 0; i < n; i += 8)
+    {
+        __m128i av = _mm_loadu_si128((const __m128i *)&a[i]);
+        __m128i bv = _mm_loadu_si128((const __m128i *)&b[i]);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(av, bv));
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+#else
+/* Generic */
+static inline int32_t corr_dot(const int16_t *a, const int16_t *b, int n)
+{
+    int32_t acc = 0;
+
+    for (int i = 0; i < n; i++)
+        acc += a[i] * b[i];
+
+    return acc;
+}
+#endif /* CPU_* */
+
+/* Whether correlation c1 against a window of energy e1 beats c2 against e2,
+   comparing c/sqrt(e) as c*|c|*e' without roots or division. Anticorrelated
+   windows never win. Terms are cut down so the products fit in 64 bits. */
+static inline bool corr_better(int32_t c1, int32_t e1, int32_t c2, int32_t e2)
+{
+    if (c1 <= 0)
+        return false;
+
+    if (c2 <= 0)
+        return true;
+
+    uint32_t a = c1 >> 8, b = c2 >> 8;
+    return (uint64_t)a * a * ((uint32_t)(e2 >> 8) + 1) >
+           (uint64_t)b * b * ((uint32_t)(e1 >> 8) + 1);
+}
+
+/* Correlation of the frame at x with count windows of n samples in y, with
+   the energy of each window; x is padded with zeroes to a multiple of 8 */
+static void corr_scan(const int16_t *x, const int16_t *y, int n, int count,
+                      int32_t *c, int32_t *e)
+{
+    int const n8 = (n + 7) & ~7;
+    int32_t energy = 0;
+
+    for (int j = 0; j < n; j++)
+        energy += y[j] * y[j];
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0)
+            energy += y[i + n - 1] * y[i + n - 1] - y[i - 1] * y[i - 1];
+
+        c[i] = corr_dot(x, y + i, n8);
+        e[i] = energy;
+    }
+}
+
+/* Convert count samples of the mono mix at src, taken every step samples,
+   to 16 bits */
+static void corr_mix(int16_t *dst, int32_t * const src[2], int pos,
+                     int count, int step, int scale)
+{
+    const int32_t *l = src[0] + pos, *r = src[1] + pos;
+    int32_t const lim = (1 << (CORR_PEAK_BITS + 1)) - 1;
+
+    for (int i = 0; i < count; i++, l += step, r += step)
+    {
+        int32_t m = (*l >> scale) + (*r >> scale);
+
+        if (m > lim)
+            m = lim;
+        else if (m < -lim)
+            m = -lim;
+
+        *dst++ = m;
+    }
+}
+
+/* Peak of count samples of the mono mix at src, taken every step samples */
+static uint32_t corr_peak(int32_t * const src[2], int pos, int count,
+                          int step)
+{
+    const int32_t *l = src[0] + pos, *r = src[1] + pos;
+    uint32_t peak = 0;
+
+    for (int i = 0; i < count; i++, l += step, r += step)
+    {
+        int32_t m = (*l >> 1) + (*r >> 1);
+        peak |= m ^ (m >> 31);
+    }
+
+    return peak;
+}
+
+/* Indexes of up to max local maxima of the count correlations c with
+   energies e, best first; returns how many. Anticorrelated ones are left
+   out. */
+static int corr_peaks(const int32_t *c, const int32_t *e, int count,
+                      int *pos, int max)
+{
+    int npeaks = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        /* once full, most fall to the weakest before the neighbours */
+        if (c[i] <= 0 ||
+            (npeaks == max &&
+             !corr_better(c[i], e[i], c[pos[max - 1]], e[pos[max - 1]])) ||
+            (i > 0 && !corr_better(c[i], e[i], c[i - 1], e[i - 1])) ||
+            (i < count - 1 && corr_better(c[i + 1], e[i + 1], c[i], e[i])))
+            continue;
+
+        int k = npeaks;
+
+        if (k < max)
+            npeaks++;
+        else
+            k--; /* drop the weakest */
+
+        for (; k > 0 && corr_better(c[i], e[i], c[pos[k - 1]],
+                                    e[pos[k - 1]]); k--)
+            pos[k] = pos[k - 1];
+
+        pos[k] = i;
+    }
+
+    return npeaks;
+}
+
+/* Find the displacement, 0 to shift_max - 1, of the frame at next_frame that
+   best continues the one ending the output at prev_frame. A normalised
+   cross-correlation is maximised first on a decimated mono mix across the
+   whole range, which finds the low frequencies. A fine pass at full rate
+   on a few points at the middle of the frame refines those matches to one
+   sample and adds its own, which the decimation would alias away. The
+   candidates are scored again across the whole frame to pick one. */
+static int tdspeed_find_overlap(int32_t * const buf_in[2], int next_frame,
+                                int prev_frame)
+{
+    struct tdspeed_state_s *const st = &tdspeed_state;
+    int32_t * const src[2] = { buf_in[0], buf_in[st->channels - 1] };
+    int const order = st->corr_order;
+    int const n = st->dst_step;
+    int const last = st->shift_max - 1;
+
+    /* coarse pass: every 1 << order samples and window positions */
+    int const cn = n >> order;
+    int const count = (last >> order) + 1;
+
+    assert(cn + count - 1 <= CORR_COARSE_MAX && cn <= 64);
+    assert(last < CORR_SHIFT_MAX);
+
+    /* Scale the mix so its peak fits CORR_PEAK_BITS; the decimated points
+       stand in for the whole and the rare sample above them is clamped */
+    uint32_t peak = corr_peak(src, prev_frame, cn, 1 << order) |
+                    corr_peak(src, next_frame, cn + count - 1, 1 << order);
+
+    if (peak == 0)
+        return 0; /* silence */
+
+    int scale = 1;
+
+    while (peak >> (scale - 1) >= 1u << CORR_PEAK_BITS)
+        scale++;
+
+    corr_mix(corr_coarse_ref, src, prev_frame, cn, 1 << order, scale);
+    corr_mix(corr_coarse, src, next_frame, cn + count - 1, 1 << order,
+             scale);
+
+    for (int i = cn; i & 7; i++)
+        corr_coarse_ref[i] = 0;
+
+    corr_scan(corr_coarse_ref, corr_coarse, cn, count, corr_c, corr_e);
+
+    /* keep the best few local maxima: periodic material has several of
+       nearly equal height that only the finer passes can tell apart */
+    int pos[CORR_PEAKS + CORR_FINE_PEAKS];
+    int npeaks = corr_peaks(corr_c, corr_e, count, pos, CORR_PEAKS);
+
+    /* fine pass: full rate across the whole range, on the
+       CORR_FINE_POINTS samples at the middle of the frame */
+    int const offset = (n - CORR_FINE_POINTS) / 2;
+
+    corr_mix(corr_fine_ref, src, prev_frame + offset, CORR_FINE_POINTS, 1,
+             scale);
+    corr_mix(corr_fine, src, next_frame + offset,
+             CORR_FINE_POINTS + last, 1, scale);
+    corr_scan(corr_fine_ref, corr_fine, CORR_FINE_POINTS, last + 1,
+              corr_c, corr_e);
+
+    /* each coarse match moves to the best within half a coarse step */
+    int const half = (1 << order) >> 1;
+
+    for (int p = 0; p < npeaks; p++)
+    {
+        int const lo = (pos[p] << order) >= half ?
+                            (pos[p] << order) - half : 0;
+        int const hi = (pos[p] << order) + half <= last ?
+                            (pos[p] << order) + half : last;
+        int best = lo;
+
+        for (int i = lo + 1; i <= hi; i++)
+        {
+            if (corr_better(corr_c[i], corr_e[i],
+                            corr_c[best], corr_e[best]))
+                best = i;
+        }
+
+        pos[p] = best;
+    }
+
+    npeaks += corr_peaks(corr_c, corr_e, last + 1, pos + npeaks,
+                         CORR_FINE_PEAKS);
+
+    if (npeaks == 0)
+        return 0;
+
+    if (npeaks == 1)
+        return pos[0];
+
+    /* final pass: every CORR_FRAME_STEP samples across the whole frame,
+       longer than a period of anything but the lowest notes. Matches a
+       period apart differ only by the fraction of a sample they are off,
+       which the few points of the fine pass can't weigh against the rest
+       of the frame but high frequencies can hear. */
+    int const fn = n / CORR_FRAME_STEP;
+    int32_t best_c = 0, best_e = 0;
+    int best = 0;
+
+    assert(fn <= 64);
+
+    corr_mix(corr_coarse_ref, src, prev_frame, fn, CORR_FRAME_STEP, scale);
+
+    for (int i = fn; i & 7; i++)
+        corr_coarse_ref[i] = 0;
+
+    for (int p = 0; p < npeaks; p++)
+    {
+        int32_t c, e;
+
+        corr_mix(corr_coarse, src, next_frame + pos[p], fn, CORR_FRAME_STEP,
+                 scale);
+        corr_scan(corr_coarse_ref, corr_coarse, fn, 1, &c, &e);
+
+        if (p == 0 || corr_better(c, e, best_c, best_e))
+        {
+            best = pos[p];
+            best_c = c;
+            best_e = e;
+        }
+    }
+
+    return best;
+}
+
 /* Discard all data */
 static void tdspeed_flush(void)
 {
@@ -143,26 +462,24 @@ static bool tdspeed_update(int32_t samplerate, int32_t factor)
     if (factor < STRETCH_MIN || factor > STRETCH_MAX)
         return false;
 
+    /* one period of MINFREQ, whatever the samplerate */
     st->dst_step = samplerate / MINFREQ;
 
     if (factor > PITCH_SPEED_100)
         st->dst_step = st->dst_step * PITCH_SPEED_100 / factor;
 
-    st->dst_order = 1;
-
-    while (st->dst_step >>= 1)
-        st->dst_order++;
-
-    st->dst_step = (1 << st->dst_order);
-#ifdef CPU_COLDFIRE
-    /* blend_frame_samples works in s0.31 mode. Also must shift by
-       one less bit before mac in order not to overflow. */
-    st->dst_order = 30 - st->dst_order;
-#endif
+    st->dst_weight = (1 << 30) / st->dst_step;
     st->src_step = st->dst_step * factor / PITCH_SPEED_100;
     st->shift_max = (st->dst_step > st->src_step) ?
                         st->dst_step : st->src_step;
 
+    /* coarse search decimation brings its rate within a factor of about
+       sqrt(2) of CORR_COARSE_HZ */
+    st->corr_order = 0;
+
+    while ((samplerate >> st->corr_order) * 5 > CORR_COARSE_HZ * 7)
+        st->corr_order++;
+
     st->ovl_buff[0] = overlap_buffer[0];
     st->ovl_buff[1] = overlap_buffer[1]; /* ignored if mono */
 
@@ -258,39 +575,10 @@ static int tdspeed_apply(int32_t *buf_out[2], int32_t *buf_in[2],
     /* process all complete frames */
     while (data_len - next_frame >= src_frame_sz)
     {
-        /* find frame overlap by autocorelation */
-        int const INC1 = 8;
-        int const INC2 = 32;
-
-        int64_t min_delta = INT64_MAX;  /* most positive */
-        int shift = 0;
-
         assert(next_frame + st->shift_max - 1 + st->dst_step <= data_len);
         assert(prev_frame + st->dst_step <= data_len);
 
-        for (int i = 0; i < st->shift_max; i += INC1)
-        {
-            int64_t delta = 0;
-
-            for (int ch = 0; ch < st->channels; ch++)
-            {
-                int32_t *curr = buf_in[ch] + next_frame + i;
-                int32_t *prev = buf_in[ch] + prev_frame;
-
-                for (int j = 0; j < st->dst_step;
-                     j += INC2, curr += INC2, prev += INC2)
-                {
-                    delta += ad_s32(*curr, *prev);
-
-                    if (delta >= min_delta)
-                        goto skip;
-                }
-            }
-
-            min_delta = delta;
-            shift = i;
-skip:;
-        }
+        int shift = tdspeed_find_overlap(buf_in, next_frame, prev_frame);
 
         /* overlap fading-out previous frame with fading-in current frame */
         for (int ch = 0; ch < st->channels; ch++)
@@ -303,11 +591,12 @@ skip:;
             assert(prev_frame + st->dst_step <= data_len);
             assert(dest[ch] - buf_out[ch] + st->dst_step <= out_size);
 
+            int32_t const w = st->dst_weight;
+
             for (int i = 0, j = st->dst_step; j; i++, j--)
             {
                 assert(d < buf_out[ch] + out_size);
-                *d++ = blend_frame_samples(*curr++, *prev++, i, j,
-                                           st->dst_order);
+                *d++ = blend_frame_samples(*curr++, *prev++, i, j, w);
             }
 
             dest[ch] = d;
@@ -71,7 +71,7 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
 
         if (type == 0)       /* 0 is the STREAMINFO block */
         {
-            unsigned long totalsamples;
+            uint64_t totalsamples;
 
             if (i >= sizeof(id3->path) || read(fd, buf, i) != (int)i)
             {
@@ -84,8 +84,9 @@ bool get_flac_metadata(int fd, struct mp3entry* id3)
                 | ((buf[12] & 0xf0) >> 4);
             rc = true;  /* Got vital metadata */
 
-            /* totalsamples is a 36-bit field, but we assume <= 32 bits are used */
-            totalsamples = get_long_be(&buf[14]);
+            /* totalsamples is a 36-bit field */
+            totalsamples = ((uint64_t)(buf[13] & 0x0f) << 32)
+                           | get_long_be(&buf[14]);
 
             if(totalsamples > 0)
             {
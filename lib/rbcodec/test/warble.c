@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include "buffering.h" /* TYPE_PACKET_AUDIO */
 #include "kernel.h"
@@ -102,6 +103,11 @@ static bool use_dsp = true;
 static bool enable_loop = false;
 static const char *config = "";
 
+/* DSP timing */
+static bool time_dsp = false;
+static double dsp_cpu_time = 0;   /* seconds spent in dsp_process */
+static double dsp_audio_time = 0; /* seconds of codec output processed */
+
 /* Volume control */
 #define VOL_FRACBITS 31
 #define VOL_FACTOR_UNITY (1u << VOL_FRACBITS)
@@ -441,6 +447,12 @@ static void ci_pcmbuf_insert(const void *ch1, const void *ch2, int count)
     num_output_samples += count;
 
     if (use_dsp) {
+        struct timespec t0, t1;
+        if (time_dsp) {
+            dsp_audio_time += (double)count / format.freq;
+            clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t0);
+        }
+
         struct dsp_buffer src;
         src.remcount = count;
         src.pin[0] = ch1;
@@ -457,6 +469,12 @@ static void ci_pcmbuf_insert(const void *ch1, const void *ch2, int count)
 
             dsp_process(ci.dsp, &src, &dst);
 
+            if (time_dsp) {
+                clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t1);
+                dsp_cpu_time += (t1.tv_sec - t0.tv_sec) +
+                                (t1.tv_nsec - t0.tv_nsec) / 1e9;
+            }
+
             if (dst.remcount > 0) {
                 if (mode == MODE_WRITE)
                     write_pcm(buf, dst.remcount);
@@ -465,6 +483,9 @@ static void ci_pcmbuf_insert(const void *ch1, const void *ch2, int count)
             } else if (src.remcount <= 0) {
                 break;
             }
+
+            if (time_dsp)
+                clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t0);
         }
     } else {
         /* Convert to 32-bit interleaved. */
@@ -842,6 +863,7 @@ static void print_help(const char *progname)
                     "general options:\n"
                     "  -c a=1:b=2    Configuration (see below)\n"
                     "  -h            Show this help\n"
+                    "  -t            Print CPU time spent in the DSP on exit\n"
                     "\n"
                     "write to WAV options:\n"
                     "  -f            Write raw codec output converted to 64-bit float\n"
@@ -864,13 +886,15 @@ static void print_help(const char *progname)
                     "  %s in.adx -c loop=1:wait=44100:halt=1\n"
                     "  # Lower pitch 1 octave and write to out.wav\n"
                     "  %s in.ogg -c rate=0.5:tempo=2 out.wav\n"
-                    , progname, progname, progname, progname);
+                    "  # Measure the DSP cost of playing 1.5x faster\n"
+                    "  %s -t in.mp3 -c tempo=1.5 /dev/null\n"
+                    , progname, progname, progname, progname, progname);
 }
 
 int main(int argc, char **argv)
 {
     int opt;
-    while ((opt = getopt(argc, argv, "c:fhr")) != -1) {
+    while ((opt = getopt(argc, argv, "c:fhrt")) != -1) {
         switch (opt) {
         case 'c':
             config = optarg;
@@ -882,6 +906,9 @@ int main(int argc, char **argv)
             use_dsp = false;
             write_raw = true;
             break;
+        case 't':
+            time_dsp = true;
+            break;
         case 'h': /* fallthrough */
         default:
             print_help(argv[0]);
@@ -913,5 +940,10 @@ int main(int argc, char **argv)
     else if (mode == MODE_PLAY)
         playback_quit();
 
+    if (time_dsp && dsp_cpu_time > 0) {
+        fprintf(stderr, "DSP: %.3f s CPU for %.3f s of audio (%.1fx realtime)\n",
+                dsp_cpu_time, dsp_audio_time, dsp_audio_time / dsp_cpu_time);
+    }
+
     return 0;
 }
@@ -0,0 +1,107 @@
+#!/bin/bash
+#             __________               __   ___.
+#   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+#   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+#   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+#   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+#                     \/            \/     \/    \/            \/
+# $Id$
+#
+################################################################################
+#
+# Bit-exactness and speed test for the Monkey's Audio (demac) decoder using
+# warble builds (tools/configure, build type W).
+#
+# ./ape_warble_test.sh <warble> <dir with .ape files> [reference warble]
+#
+# Every .ape file below the directory is decoded to raw codec output. With a
+# reference warble (e.g. a build from before a change to libdemac, or one
+# built for a CPU without SSE2/AVX2) both outputs must be identical and the
+# decode times are compared. Without one, the output is checked against
+# <file>.ape.md5 when present, or that file is created.
+#
+# Encode one file at each compression level (-c1000 .. -c5000) for full
+# coverage of the filters.
+#
+################################################################################
+
+set -uo pipefail
+IFS=$'\n\t'
+
+if [ $# -lt 2 ]; then
+  echo "Usage: $0 <warble> <dir with .ape files> [reference warble]"
+  exit 1
+fi
+
+WARBLE=$1
+APEDIR=$2
+REF=${3:-}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# print the compression level stored in the file header
+ape_level() {
+  local version desclen
+  version=$(od -An -tu2 -j4 -N2 "$1" | tr -d ' ')
+  if [ "$version" -ge 3980 ]; then
+    desclen=$(od -An -tu4 -j8 -N4 "$1" | tr -d ' ')
+    od -An -tu2 -j"$desclen" -N2 "$1" | tr -d ' '
+  else
+    od -An -tu2 -j6 -N2 "$1" | tr -d ' '
+  fi
+}
+
+# decode $2 with warble $1 into $3, print the elapsed time in ms
+decode() {
+  local start end
+  start=$(date +%s%N)
+  "$1" -r "$2" "$3" > /dev/null 2>&1 || return 1
+  end=$(date +%s%N)
+  echo $(( (end - start) / 1000000 ))
+}
+
+FAIL=0
+printf "%-40s %6s %10s %10s %s\n" "file" "level" "time(ms)" "ref(ms)" "result"
+
+while IFS= read -r -d '' f; do
+  name=$(basename "$f")
+  level=$(ape_level "$f")
+
+  if ! t=$(decode "$WARBLE" "$f" "$TMP/out.raw"); then
+    printf "%-40s %6s %10s %10s %s\n" "$name" "$level" "-" "-" "DECODE FAILED"
+    FAIL=1
+    continue
+  fi
+  sum=$(md5sum < "$TMP/out.raw" | cut -d' ' -f1)
+
+  if [ -n "$REF" ]; then
+    if ! rt=$(decode "$REF" "$f" "$TMP/ref.raw"); then
+      printf "%-40s %6s %10s %10s %s\n" "$name" "$level" "$t" "-" "REFERENCE FAILED"
+      FAIL=1
+      continue
+    fi
+    if cmp -s "$TMP/out.raw" "$TMP/ref.raw"; then
+      result="ok"
+    else
+      result="MISMATCH"
+      FAIL=1
+    fi
+  else
+    rt="-"
+    if [ -f "$f.md5" ]; then
+      if [ "$sum" = "$(cat "$f.md5")" ]; then
+        result="ok"
+      else
+        result="MISMATCH"
+        FAIL=1
+      fi
+    else
+      echo "$sum" > "$f.md5"
+      result="md5 saved"
+    fi
+  fi
+
+  printf "%-40s %6s %10s %10s %s\n" "$name" "$level" "$t" "$rt" "$result"
+done < <(find "$APEDIR" -name '*.ape' -print0 | sort -z)
+
+exit $FAIL
@@ -0,0 +1,232 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+/*
+ * Compresses generated data with zlib, at every level and strategy and in
+ * raw, zlib and gzip framing, and checks that firmware/common/inflate.c
+ * gives it back.
+ *
+ * The reader hands over the stream and then nothing more, as the zip
+ * reader does at the end of a member, sometimes a few bytes at a time. Raw
+ * streams have no trailer, so their last codes end within the last byte
+ * of the input; the decoder must not need more than that.
+ *
+ * Each stream is also cut short by 1 to 3 bytes, which must fail. The
+ * length at the end of a gzip stream is not checked, so those are cut
+ * short of it.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* only deflate is used from zlib; keep its inflate out of the way */
+#define inflate zlib_inflate
+#include <zlib.h>
+#undef inflate
+#include "inflate.h"
+
+#define STREAMS         6000
+#define DATA_MAX        (96*1024)
+
+static unsigned char data[DATA_MAX];
+static unsigned char packed[DATA_MAX + DATA_MAX/8 + 1024];
+static unsigned char unpacked[DATA_MAX];
+
+struct reader
+{
+    const unsigned char *buf, *end;
+    uint32_t chunk;                 /* most bytes per call, 0 for no limit */
+    bool started;
+};
+
+struct writer
+{
+    unsigned char *buf, *end;
+};
+
+static uint32_t read_stream(void *block, uint32_t block_size, void *ctx)
+{
+    struct reader *r = ctx;
+    uint32_t size = r->end - r->buf;
+
+    if (size > block_size)
+        size = block_size;
+    /* the zlib and gzip headers are parsed from the first read */
+    if (r->started && r->chunk && size > r->chunk)
+        size = r->chunk;
+
+    r->started = true;
+
+    memcpy(block, r->buf, size);
+    r->buf += size;
+    return size;
+}
+
+static uint32_t write_stream(const void *block, uint32_t block_size,
+                             void *ctx)
+{
+    struct writer *w = ctx;
+
+    if (block_size > (uint32_t)(w->end - w->buf))
+        return 0;
+
+    memcpy(w->buf, block, block_size);
+    w->buf += block_size;
+    return block_size;
+}
+
+/* text made of a few words, random bytes, runs, or all of those */
+static size_t make_data(unsigned int seed)
+{
+    static const char *const words[] = {
+        "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ",
+        "dog ", "Rockbox ", "\n", ", ", "inflate ",
+    };
+    size_t size = rand() % (rand() % 8 ? 4096 : DATA_MAX);
+    int kind = seed % 4;
+    size_t i = 0;
+
+    while (i < size)
+    {
+        int k = (kind == 3) ? rand() % 3 : kind;
+
+        if (k == 0)
+        {
+            const char *w = words[rand() % 12];
+            while (*w && i < size)
+                data[i++] = *w++;
+        }
+        else if (k == 1)
+        {
+            data[i++] = rand();
+        }
+        else
+        {
+            size_t run = 1 + rand() % 300;
+            unsigned char c = rand();
+            while (run-- && i < size)
+                data[i++] = c;
+        }
+    }
+
+    return size;
+}
+
+static size_t deflate_data(size_t size, int level, int strategy,
+                           int window_bits, int mem_level)
+{
+    z_stream z;
+
+    memset(&z, 0, sizeof(z));
+    if (deflateInit2(&z, level, Z_DEFLATED, window_bits, mem_level,
+                     strategy) != Z_OK)
+        abort();
+
+    z.next_in = data;
+    z.avail_in = size;
+    z.next_out = packed;
+    z.avail_out = sizeof(packed);
+
+    if (deflate(&z, Z_FINISH) != Z_STREAM_END)
+        abort();
+
+    size = z.total_out;
+    deflateEnd(&z);
+    return size;
+}
+
+static int run_inflate(void *state, int type, size_t in_size,
+                       uint32_t chunk, size_t *out_size)
+{
+    struct reader r = { packed, packed + in_size, chunk, false };
+    struct writer w = { unpacked, unpacked + sizeof(unpacked) };
+    int rv = inflate(state, type, read_stream, &r, write_stream, &w);
+
+    *out_size = w.buf - unpacked;
+    return rv;
+}
+
+int main(void)
+{
+    static const int strategies[] = {
+        Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED,
+    };
+    static const struct { int type, window_bits; const char *name; } types[] = {
+        { INFLATE_RAW,  -15, "raw"  },
+        { INFLATE_ZLIB,  15, "zlib" },
+        { INFLATE_GZIP,  31, "gzip" },
+    };
+    void *state = aligned_alloc(inflate_align,
+                                (inflate_size + inflate_align - 1) /
+                                inflate_align * inflate_align);
+    int failed[3] = { 0 }, cut_passed[3] = { 0 }, count[3] = { 0 };
+
+    srand(1);
+
+    for (unsigned int n = 0; n < STREAMS; n++)
+    {
+        int t = n % 3;
+        int level = rand() % 10;
+        int strategy = strategies[rand() % 5];
+        int mem_level = 1 + rand() % 9;
+        uint32_t chunk = (rand() % 2) ? 0 : 1 + rand() % 13;
+        size_t size = make_data(n);
+        size_t packed_size = deflate_data(size, level, strategy,
+                                          types[t].window_bits, mem_level);
+        size_t out_size;
+        int rv;
+
+        count[t]++;
+        rv = run_inflate(state, types[t].type, packed_size, chunk, &out_size);
+
+        if (rv != 0 || out_size != size || memcmp(unpacked, data, size))
+        {
+            if (failed[t]++ < 10)
+                printf("%s stream %u: %zu -> %zu bytes, level %d, "
+                       "strategy %d, chunk %u: error %d, %zu bytes out\n",
+                       types[t].name, n, size, packed_size, level, strategy,
+                       chunk, rv, out_size);
+            continue;
+        }
+
+        for (size_t cut = 1; cut <= 3; cut++)
+        {
+            size_t cut_size = packed_size - cut -
+                              (types[t].type == INFLATE_GZIP ? 4 : 0);
+
+            if (cut_size == 0 || cut_size > packed_size)
+                break;
+
+            rv = run_inflate(state, types[t].type, cut_size, chunk,
+                             &out_size);
+            if (rv == 0 && cut_passed[t]++ < 10)
+                printf("%s stream %u cut by %zu bytes: no error\n",
+                       types[t].name, n, cut);
+        }
+    }
+
+    for (int t = 0; t < 3; t++)
+        printf("%-4s: %d streams, %d failed, %d cut short without error\n",
+               types[t].name, count[t], failed[t], cut_passed[t]);
+
+    free(state);
+    return (failed[0] | failed[1] | failed[2] |
+            cut_passed[0] | cut_passed[1] | cut_passed[2]) ? 1 : 0;
+}
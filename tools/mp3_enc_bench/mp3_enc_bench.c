@@ -0,0 +1,190 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+/*
+ * Encodes a fixed, generated corpus with the core of the MP3 encoder codec
+ * (lib/rbcodec/codecs/mp3_enc.c) at 44.1 kHz and 128 kbps, mono and then
+ * stereo, and prints the speed as a multiple of realtime.
+ *
+ * The corpus is 30 s of two steady tones, a slow sweep and noise from a
+ * fixed LCG, the same on every run and every host. Each pass encodes all
+ * of it, with no file I/O in the timed loop unless an output file is given.
+ * An FNV-1a checksum of the stream is printed to compare builds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include "shim.h"
+#include "mp3_enc_core.c"
+
+#define CORPUS_RATE     44100
+#define CORPUS_SECONDS  30
+#define CORPUS_SAMPLES  (CORPUS_RATE*CORPUS_SECONDS)
+#define BITRATE         128
+
+static short corpus[CORPUS_SAMPLES*2];
+
+/* Same as firmware/general.c */
+static int round_value_to_list32(unsigned long value,
+                                 const unsigned long list[],
+                                 int count, bool signd)
+{
+    unsigned long dmin = (unsigned long)-1;
+    int idmin = -1;
+
+    for (int i = 0; i < count; i++)
+    {
+        unsigned long diff;
+
+        if (list[i] == value)
+            return i;
+
+        if (signd ? ((long)list[i] < (long)value) : (list[i] < value))
+            diff = value - list[i];
+        else
+            diff = list[i] - value;
+
+        if (diff < dmin)
+        {
+            dmin = diff;
+            idmin = i;
+        }
+    }
+
+    return idmin;
+}
+
+static struct codec_api api =
+{
+    .round_value_to_list32 = round_value_to_list32,
+    .memcpy                = memcpy,
+    .memset                = memset,
+    .memmove               = memmove,
+};
+
+struct codec_api *ci = &api;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void make_corpus(void)
+{
+    unsigned int seed = 12345;
+    double ph1 = 0, ph2 = 0, ph3 = 0;
+
+    for (long i = 0; i < CORPUS_SAMPLES; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+
+        double noise = (int)((seed >> 16) & 2047) - 1024;
+        double sweep = 3000 * sin(ph2);
+
+        corpus[2*i]   = (short)(6000 * sin(ph1) + sweep + noise);
+        corpus[2*i+1] = (short)(5000 * sin(ph3) + sweep - noise);
+
+        ph1 += 2*M_PI * 440 / CORPUS_RATE;
+        ph2 += 2*M_PI * (200 + i * 0.01) / CORPUS_RATE;
+        ph3 += 2*M_PI * 3520 / CORPUS_RATE;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int passes = argc > 1 ? atoi(argv[1]) : 10;
+    FILE *out = NULL;
+
+    if (passes < 1)
+    {
+        fprintf(stderr, "Usage: %s [passes] [out.mp3]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2 && !(out = fopen(argv[2], "wb")))
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    make_corpus();
+
+    printf("%d s corpus, %d kbps, %d passes, %s\n", CORPUS_SECONDS, BITRATE,
+           passes,
+#ifdef __SSE2__
+           "SSE2"
+#else
+           "generic"
+#endif
+           );
+
+    for (int channels = 1; channels <= 2; channels++)
+    {
+        static uint8_t frame[4096];
+        long const frames = CORPUS_SAMPLES / 1152;
+        uint32_t fnv = 2166136261u;
+        unsigned long bytes = 0;
+
+        mp3_encoder_init(CORPUS_RATE, channels, BITRATE);
+
+        double start = now();
+
+        for (int p = 0; p < passes; p++)
+        {
+            for (long f = 0; f < frames; f++)
+            {
+                short *dst = cfg.samp_buffer;
+                const short *src = corpus + f*1152*2;
+
+                if (channels == 2)
+                    memcpy(dst, src, 1152*2*sizeof (short));
+                else
+                    for (int i = 0; i < 1152; i++)
+                        dst[i] = src[2*i];
+
+                mp3_enc_encode_frame();
+
+                size_t size = mp3_enc_get_frame(frame);
+
+                for (size_t i = 0; i < size; i++)
+                    fnv = (fnv ^ frame[i]) * 16777619u;
+
+                bytes += size;
+
+                if (out)
+                    fwrite(frame, 1, size, out);
+            }
+        }
+
+        double elapsed = now() - start;
+
+        printf("%s: %7.1fx realtime, %lu bytes, checksum %08x\n",
+               channels == 1 ? "mono  " : "stereo",
+               passes * CORPUS_SECONDS / elapsed, bytes, fnv);
+    }
+
+    if (out)
+        fclose(out);
+
+    return 0;
+}
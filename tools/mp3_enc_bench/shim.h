@@ -0,0 +1,58 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#ifndef SHIM_H
+#define SHIM_H
+
+/* Stands in for codeclib.h: a single core, no IRAM and the few codec API
+ * calls the encoder core makes. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#define NUM_CORES           1
+#define CODEC_ENC_HEADER
+#define ROCKBOX_LITTLE_ENDIAN
+
+#define IBSS_ATTR
+#define ICODE_ATTR
+#define ICONST_ATTR
+#define MEM_ALIGN_ATTR      __attribute__((aligned(16)))
+
+#define UNLIKELY(x)         __builtin_expect(!!(x), 0)
+#define MAX(a, b)           ((a) > (b) ? (a) : (b))
+#define ALIGN_UP(n, a)      (((n) + (a) - 1) / (a) * (a))
+#define swap32(x)           __builtin_bswap32(x)
+
+struct codec_api
+{
+    int (*round_value_to_list32)(unsigned long value,
+                                 const unsigned long list[],
+                                 int count, bool signd);
+    void * (*memcpy)(void *dst, const void *src, size_t n);
+    void * (*memset)(void *dst, int c, size_t n);
+    void * (*memmove)(void *dst, const void *src, size_t n);
+};
+
+extern struct codec_api *ci;
+
+#endif /* SHIM_H */
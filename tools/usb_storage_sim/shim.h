@@ -0,0 +1,99 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+#ifndef SHIM_H
+#define SHIM_H
+
+/* Stands in for the target headers usb_storage.c includes: one drive, 512
+ * byte sectors, no RTC, static buffers as on the i.MX31 and the ARC
+ * controller's buffer sizes. Everything else is in usb_storage_sim.c. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CONFIG_RTC          0
+#define IMX31L              1
+#define CONFIG_CPU          IMX31L
+#define USBOTG_ARC          1
+#define CONFIG_USBOTG       USBOTG_ARC
+#define STORAGE_ATA         1
+#define STORAGE_SD          2
+#define CONFIG_STORAGE      STORAGE_ATA
+#define NUM_DRIVES          1
+#define SECTOR_SIZE         512
+#define USB_DEVBSS_ATTR
+
+#define IF_MD(x...)
+#define IF_MD_NONVOID(x...) void
+
+#define MIN(a, b)           ((a) < (b) ? (a) : (b))
+#define MAX(a, b)           ((a) > (b) ? (a) : (b))
+
+/* glibc has these as well */
+#undef htobe16
+#undef htobe32
+#undef htole32
+#define htobe16(x)          __builtin_bswap16(x)
+#define htobe32(x)          __builtin_bswap32(x)
+#define htole32(x)          (x)
+#define letoh32(x)          (x)
+
+#define logf(...)           do {} while (0)
+
+#define SYS_USB_LUN_LOCKED  0
+void queue_broadcast(long id, intptr_t data);
+void commit_discard_dcache(void);
+void panicf(const char *fmt, ...);
+
+struct storage_info
+{
+    unsigned int sector_size;
+    unsigned int num_sectors;
+    char *vendor;
+    char *product;
+    char *revision;
+};
+
+#define storage_get_info(drive, info) sim_storage_get_info(info)
+void sim_storage_get_info(struct storage_info *info);
+int storage_read_sectors(unsigned long start, int count, void *buf);
+int storage_write_sectors(unsigned long start, int count, const void *buf);
+int storage_num_drives(void);
+bool storage_removable(int drive);
+bool storage_present(int drive);
+bool disk_present(IF_MD_NONVOID(int drive));
+
+struct usb_class_driver;
+int usb_core_request_endpoint(int type, int dir, struct usb_class_driver *drv);
+void usb_core_release_endpoint(int ep);
+bool usb_exclusive_storage(void);
+
+#define USB_CONTROL_ACK     0
+int usb_drv_send_nonblocking(int endpoint, void *ptr, int length);
+int usb_drv_recv_nonblocking(int endpoint, void *ptr, int length);
+void usb_drv_stall(int endpoint, bool stall, bool in);
+void usb_drv_control_response(int resp, void *data, int length);
+
+extern int buflib_ops_locked;
+int core_alloc_ex(size_t size, void *ops);
+void *core_get_data(int handle);
+int core_free(int handle);
+
+#endif /* SHIM_H */
@@ -0,0 +1,473 @@
+/***************************************************************************
+ *             __________               __   ___.
+ *   Open      \______   \ ____   ____ |  | _\_ |__   _______  ___
+ *   Source     |       _//  _ \_/ ___\|  |/ /| __ \ /  _ \  \/  /
+ *   Jukebox    |    |   (  <_> )  \___|    < | \_\ (  <_> > <  <
+ *   Firmware   |____|_  /\____/ \___  >__|_ \|___  /\____/__/\_ \
+ *                     \/            \/     \/    \/            \/
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY
+ * KIND, either express or implied.
+ *
+ ****************************************************************************/
+
+/*
+ * Runs firmware/usbstack/usb_storage.c on the host against a RAM disk, a
+ * simulated USB controller and a simulated host, on a virtual clock:
+ *
+ *  - Storage reads and writes block and advance the clock by a per-call
+ *    cost plus the transfer time, as the storage drivers block the USB
+ *    thread on a target.
+ *  - The controller runs one transfer per direction, each completing after
+ *    a per-transfer cost plus the transfer time. Completions are handed to
+ *    usb_storage_transfer_complete() in time order, once the driver is done
+ *    with the previous one.
+ *  - The host sends one command at a time. It sends the next CBW a fixed
+ *    turnaround after it received the CSW, as bulk-only transport requires.
+ *
+ * Each workload moves 16 MB. Every byte read is checked against the data
+ * the host has written so far, and the disk is compared in full at the end.
+ * A final stress run mixes reads of any size, mostly continuing where the
+ * last one ended, with writes at and right after the read position.
+ *
+ * The throughput figures only compare the driver against itself, build
+ * this with SRC= set to an older usb_storage.c for the other side. See the
+ * Makefile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "shim.h"
+#include "usb_storage.h"
+
+#define DISK_SECTORS    (64*1024*2)     /* 64 MB */
+#define WORKLOAD_SIZE   (16*1024*1024)
+#define EP_IN           1
+#define EP_OUT          2
+
+static unsigned char disk[DISK_SECTORS*SECTOR_SIZE];
+static unsigned char host_disk[DISK_SECTORS*SECTOR_SIZE]; /* what it should be */
+
+/* Timing model, in microseconds and bytes per microsecond (MB/s) */
+static const struct profile
+{
+    const char *name;
+    double storage_call;
+    double storage_rate;
+} profiles[] =
+{
+    { "sd",   250, 15 },
+    { "hdd",  120, 30 },
+    { "nand", 400,  8 },
+};
+
+#define USB_TRANSFER    15      /* per transfer */
+#define USB_RATE        35      /* high speed bulk, in practice */
+#define HOST_TURNAROUND 80      /* CSW in to next CBW out */
+
+static const struct profile *profile;
+static double now;
+static long storage_reads, errors;
+
+static unsigned int rnd(void)
+{
+    static unsigned int x = 12345;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/** Storage: a RAM disk with a cost **/
+
+void sim_storage_get_info(struct storage_info *info)
+{
+    info->sector_size = SECTOR_SIZE;
+    info->num_sectors = DISK_SECTORS;
+    info->vendor = "Rockbox";
+    info->product = "usb_storage_sim";
+    info->revision = "0.1";
+}
+
+int storage_read_sectors(unsigned long start, int count, void *buf)
+{
+    if (start + count > DISK_SECTORS)
+        panicf("read past the end: %lu+%d", start, count);
+
+    memcpy(buf, disk + start*SECTOR_SIZE, count*SECTOR_SIZE);
+    now += profile->storage_call + count*SECTOR_SIZE / profile->storage_rate;
+    storage_reads++;
+    return 0;
+}
+
+int storage_write_sectors(unsigned long start, int count, const void *buf)
+{
+    if (start + count > DISK_SECTORS)
+        panicf("write past the end: %lu+%d", start, count);
+
+    memcpy(disk + start*SECTOR_SIZE, buf, count*SECTOR_SIZE);
+    now += profile->storage_call + count*SECTOR_SIZE / profile->storage_rate;
+    return 0;
+}
+
+int storage_num_drives(void) { return 1; }
+bool storage_removable(int drive) { return false; }
+bool storage_present(int drive) { return true; }
+bool disk_present(IF_MD_NONVOID(int drive)) { return true; }
+bool usb_exclusive_storage(void) { return true; }
+
+/** Odds and ends **/
+
+int buflib_ops_locked;
+int core_alloc_ex(size_t size, void *ops) { return -1; }
+void *core_get_data(int handle) { return NULL; }
+int core_free(int handle) { return 0; }
+void commit_discard_dcache(void) {}
+void queue_broadcast(long id, intptr_t data) {}
+
+void panicf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    exit(2);
+}
+
+int usb_core_request_endpoint(int type, int dir, struct usb_class_driver *drv)
+{
+    return dir == USB_DIR_IN ? EP_IN : EP_OUT;
+}
+
+void usb_core_release_endpoint(int ep) {}
+void usb_drv_control_response(int resp, void *data, int length) {}
+
+void usb_drv_stall(int endpoint, bool stall, bool in)
+{
+    panicf("endpoint %d stalled", endpoint);
+}
+
+/** Controller: one transfer per direction **/
+
+static struct transfer
+{
+    bool busy;
+    unsigned char *buf;
+    int length;
+    double done;        /* < 0 while the host has nothing to send */
+} in, out;
+
+static double in_free, out_free;
+
+static double usb_time(int length)
+{
+    return USB_TRANSFER + length / (double)USB_RATE;
+}
+
+int usb_drv_send_nonblocking(int endpoint, void *ptr, int length)
+{
+    if (in.busy)
+        panicf("IN transfer already queued");
+
+    in.busy = true;
+    in.buf = ptr;
+    in.length = length;
+    in.done = MAX(now, in_free) + usb_time(length);
+    in_free = in.done;
+    return 0;
+}
+
+int usb_drv_recv_nonblocking(int endpoint, void *ptr, int length)
+{
+    if (out.busy)
+        panicf("OUT transfer already queued");
+
+    out.busy = true;
+    out.buf = ptr;
+    out.length = length;
+    out.done = -1;
+    return 0;
+}
+
+/** Host **/
+
+struct command
+{
+    bool write;
+    unsigned int sector;
+    unsigned int count;
+};
+
+static struct command *commands;
+static int num_commands, cur;
+static enum { HOST_CBW, HOST_DATA, HOST_CSW } host_state;
+static double cbw_ready;
+static unsigned int host_bytes;     /* data moved for the current command */
+static unsigned char cbw[31];
+
+static void host_make_cbw(void)
+{
+    const struct command *c = &commands[cur];
+    uint32_t signature = 0x43425355, tag = cur, length = c->count*SECTOR_SIZE;
+
+    memset(cbw, 0, sizeof(cbw));
+    memcpy(&cbw[0], &signature, 4);
+    memcpy(&cbw[4], &tag, 4);
+    memcpy(&cbw[8], &length, 4);
+    cbw[12] = c->write ? 0 : 0x80;
+    cbw[14] = 10;
+    cbw[15] = c->write ? 0x2a : 0x28;   /* WRITE(10) / READ(10) */
+    cbw[17] = c->sector >> 24;
+    cbw[18] = c->sector >> 16;
+    cbw[19] = c->sector >> 8;
+    cbw[20] = c->sector;
+    cbw[22] = c->count >> 8;
+    cbw[23] = c->count;
+
+    host_state = HOST_CBW;
+    host_bytes = 0;
+
+    /* New contents for the disk, as of this command */
+    if (c->write)
+    {
+        for (unsigned int i = 0; i < c->count*SECTOR_SIZE; i++)
+            host_disk[c->sector*SECTOR_SIZE + i] = rnd();
+    }
+}
+
+/* Fills a queued OUT transfer once the host has something for it */
+static void host_schedule_out(void)
+{
+    const struct command *c = &commands[cur];
+
+    if (!out.busy || out.done >= 0 || cur >= num_commands)
+        return;
+
+    double start = MAX(now, out_free);
+
+    if (host_state == HOST_CBW)
+        out.done = MAX(start, cbw_ready) + usb_time(sizeof(cbw));
+    else if (host_state == HOST_DATA && c->write)
+        out.done = start + usb_time(MIN((unsigned int)out.length,
+                                        c->count*SECTOR_SIZE - host_bytes));
+}
+
+static void complete_in(void)
+{
+    const struct command *c = &commands[cur];
+
+    in.busy = false;
+    now = MAX(now, in.done);
+
+    if (host_state == HOST_DATA && !c->write)
+    {
+        if (memcmp(in.buf, host_disk + c->sector*SECTOR_SIZE + host_bytes,
+                   in.length))
+            errors++;
+
+        host_bytes += in.length;
+        if (host_bytes == c->count*SECTOR_SIZE)
+            host_state = HOST_CSW;
+    }
+    else
+    {
+        if (in.length != 13 || in.buf[12] != 0)
+        {
+            fprintf(stderr, "command %d failed\n", cur);
+            errors++;
+        }
+
+        if (++cur < num_commands)
+        {
+            host_make_cbw();
+            cbw_ready = now + HOST_TURNAROUND;
+        }
+    }
+
+    usb_storage_transfer_complete(EP_IN, USB_DIR_IN, 0, in.length);
+}
+
+static void complete_out(void)
+{
+    const struct command *c = &commands[cur];
+    int length;
+
+    out.busy = false;
+    now = MAX(now, out.done);
+    out_free = now;
+
+    if (host_state == HOST_CBW)
+    {
+        length = sizeof(cbw);
+        memcpy(out.buf, cbw, length);
+        host_state = c->count ? HOST_DATA : HOST_CSW;
+    }
+    else
+    {
+        length = MIN((unsigned int)out.length,
+                     c->count*SECTOR_SIZE - host_bytes);
+        memcpy(out.buf, host_disk + c->sector*SECTOR_SIZE + host_bytes,
+               length);
+        host_bytes += length;
+        if (host_bytes == c->count*SECTOR_SIZE)
+            host_state = HOST_CSW;
+    }
+
+    usb_storage_transfer_complete(EP_OUT, USB_DIR_OUT, 0, length);
+}
+
+/* Runs the command list, returns the virtual time it took */
+static double run(void)
+{
+    now = in_free = out_free = 0;
+    cur = 0;
+    cbw_ready = 0;
+    host_make_cbw();
+
+    while (cur < num_commands)
+    {
+        host_schedule_out();
+
+        bool out_ready = out.busy && out.done >= 0;
+
+        if (!in.busy && !out_ready)
+            panicf("stuck at command %d", cur);
+
+        if (in.busy && (!out_ready || in.done <= out.done))
+            complete_in();
+        else
+            complete_out();
+    }
+
+    return now;
+}
+
+static const struct workload
+{
+    const char *name;
+    unsigned int kbytes;
+    bool random;
+    int write_every;    /* every nth command writes, 0 = never */
+} workloads[] =
+{
+    { "seq read 4K",    4, false, 0 },
+    { "seq read 64K",  64, false, 0 },
+    { "seq read 120K",120, false, 0 },
+    { "rand read 64K", 64, true,  0 },
+    { "seq write 64K", 64, false, 1 },
+    { "mixed 64K",     64, true,  3 },
+};
+
+static void make_workload(const struct workload *w)
+{
+    unsigned int count = w->kbytes*1024 / SECTOR_SIZE;
+
+    num_commands = WORKLOAD_SIZE / (count*SECTOR_SIZE);
+
+    for (int i = 0; i < num_commands; i++)
+    {
+        struct command *c = &commands[i];
+
+        c->count = count;
+        c->write = w->write_every && (i % w->write_every) == w->write_every-1;
+
+        if (!w->random)
+            c->sector = i*count;
+        else if (!c->write) /* mixed: reads below, writes above half */
+            c->sector = rnd() % (DISK_SECTORS/2 - count);
+        else
+            c->sector = DISK_SECTORS/2 + rnd() % (DISK_SECTORS/2 - count);
+    }
+}
+
+static void make_stress(void)
+{
+    unsigned int next = 0;
+
+    num_commands = 20000;
+
+    for (int i = 0; i < num_commands; i++)
+    {
+        struct command *c = &commands[i];
+        unsigned int r = rnd() % 10;
+
+        if (r < 2)
+        {
+            /* Write into or right after what was just read */
+            c->write = true;
+            c->count = 1 + rnd() % 64;
+            c->sector = next + DISK_SECTORS - 32 + rnd() % 64;
+            c->sector %= DISK_SECTORS;
+            c->sector = MIN(c->sector, DISK_SECTORS - c->count);
+            continue;
+        }
+
+        c->write = false;
+        c->count = 1 + rnd() % 300;
+
+        if (r == 9 || next + c->count > DISK_SECTORS)
+            next = rnd() % (DISK_SECTORS - c->count);
+
+        c->sector = next;
+        next += c->count;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : "sd";
+
+    for (size_t i = 0; i < sizeof(profiles)/sizeof(profiles[0]); i++)
+    {
+        if (!strcmp(name, profiles[i].name))
+            profile = &profiles[i];
+    }
+
+    if (!profile)
+    {
+        fprintf(stderr, "usage: %s [sd|hdd|nand]\n", argv[0]);
+        return 1;
+    }
+
+    commands = malloc(20000 * sizeof(*commands));
+
+    for (size_t i = 0; i < sizeof(disk); i++)
+        disk[i] = rnd();
+    memcpy(host_disk, disk, sizeof(disk));
+
+    usb_storage_request_endpoints(NULL);
+    usb_storage_init_connection();
+
+    printf("profile %s: storage %.0f us + %.0f MB/s, USB %d us + %d MB/s\n",
+           profile->name, profile->storage_call, profile->storage_rate,
+           USB_TRANSFER, USB_RATE);
+
+    for (size_t i = 0; i < sizeof(workloads)/sizeof(workloads[0]); i++)
+    {
+        make_workload(&workloads[i]);
+        storage_reads = 0;
+        double t = run();
+        printf("%-14s %6.2f MB/s, %5ld storage reads\n", workloads[i].name,
+               WORKLOAD_SIZE / t / 1.048576, storage_reads);
+    }
+
+    make_stress();
+    run();
+
+    if (memcmp(disk, host_disk, sizeof(disk)))
+    {
+        printf("disk contents differ\n");
+        errors++;
+    }
+
+    printf("%ld errors\n", errors);
+    return errors != 0;
+}